@@ -0,0 +1,52 @@
+/* bench.h - Benchmark Helpers
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * Read a monotonic clock.
+ *
+ * @return The current time, in seconds, from an arbitrary fixed epoch.
+ */
+static inline double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+/**
+ * Print the throughput of a benchmark.
+ * @param name    A short description of the benchmark
+ * @param ops     The number of operations performed
+ * @param seconds The time taken to perform `ops` operations
+ */
+static inline void bench_report(const char * name,
+	                        const size_t ops,
+	                        const double seconds)
+{
+	printf("%-52s %14.0f ops/sec\n", name, ops / seconds);
+}
+
+#endif /* __BENCH_H */
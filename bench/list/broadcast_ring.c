@@ -0,0 +1,95 @@
+/* broadcast_ring.c - Benchmarks for the Broadcast Ring API
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "bench.h"
+#include "list/broadcast_ring.h"
+
+#define RECORDS       2000000
+#define MAX_CONSUMERS 4
+#define BATCH         64
+
+static const struct ds_properties props = {
+	.data_size = sizeof(uint64_t),
+	.entries   = 1024,
+	.consumers = MAX_CONSUMERS,
+};
+
+static broadcast_ring ring;
+
+static void * consumer(void * arg)
+{
+	ssize_t id = (ssize_t) arg;
+	uint64_t records[BATCH];
+	size_t read = 0;
+	size_t n;
+
+	while(read < RECORDS) {
+		while(!(n = br_read(ring, id, records, BATCH)))
+			sched_yield();
+
+		read += n;
+	}
+
+	br_unsubscribe(ring, id);
+	return NULL;
+}
+
+/* One producer publishes RECORDS blocks, and every one of `consumers`
+ * consumers reads all of them in batches of up to BATCH. */
+static void bench_broadcast(const size_t consumers)
+{
+	char label[64];
+	double start;
+	pthread_t threads[MAX_CONSUMERS];
+
+	start = bench_now();
+	for(size_t i = 0; i < consumers; i++)
+		pthread_create(&threads[i], NULL, consumer,
+		               (void *) br_subscribe(ring));
+
+	for(uint64_t i = 0; i < RECORDS; i++)
+		while(!br_publish(ring, &i))
+			sched_yield();
+
+	for(size_t i = 0; i < consumers; i++)
+		pthread_join(threads[i], NULL);
+
+	snprintf(label, sizeof(label), "br_publish/br_read (%zu consumers)",
+	         consumers);
+	bench_report(label, RECORDS, bench_now() - start);
+}
+
+int main(void)
+{
+	ring = br_create(&props);
+	if(!ring) {
+		perror("br_create");
+		return 1;
+	}
+
+	for(size_t consumers = 1; consumers <= MAX_CONSUMERS; consumers *= 2)
+		bench_broadcast(consumers);
+
+	br_destroy(&ring);
+
+	return 0;
+}
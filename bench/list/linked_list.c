@@ -0,0 +1,334 @@
+/* linked_list.c - Benchmarks for the Linked List APIs
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "list/double_list.h"
+#include "list/single_list.h"
+#include "list/skip_list.h"
+#include "list/unrolled_list.h"
+
+#define RECORDS 1000000
+#define FETCHES 20000
+
+/* Each benchmark runs the same loops over a different kind of list. */
+struct list_ops {
+	const char * name;
+	void * (* create)(const struct ds_properties * props);
+	void (* destroy)(void * list);
+	void (* push_tail)(void * list, const void * data);
+	bool (* pop_head_into)(void * list, void * data);
+	void * (* foldl)(void * list, const foldl_fn fn, const void * init);
+	void * (* fetch)(void * list, const size_t pos);
+};
+
+static void sum(void * accumulator, const void * data)
+{
+	*(uint64_t *) accumulator += *(const uint64_t *) data;
+}
+
+static void * sl_create_ds(const struct ds_properties * props)
+{
+	return sl_create(props);
+}
+
+static void sl_destroy_ds(void * list)
+{
+	single_list sl = list;
+
+	sl_destroy(&sl);
+}
+
+static void sl_push_tail_ds(void * list, const void * data)
+{
+	sl_push_tail(list, data);
+}
+
+static bool sl_pop_head_into_ds(void * list, void * data)
+{
+	return sl_pop_head_into(list, data);
+}
+
+static void * sl_foldl_ds(void * list, const foldl_fn fn, const void * init)
+{
+	return sl_foldl(list, fn, init);
+}
+
+static void * sl_fetch_ds(void * list, const size_t pos)
+{
+	return sl_fetch(list, pos);
+}
+
+static void * dl_create_ds(const struct ds_properties * props)
+{
+	return dl_create(props);
+}
+
+static void dl_destroy_ds(void * list)
+{
+	double_list dl = list;
+
+	dl_destroy(&dl);
+}
+
+static void dl_push_tail_ds(void * list, const void * data)
+{
+	dl_push_tail(list, data);
+}
+
+static bool dl_pop_head_into_ds(void * list, void * data)
+{
+	return dl_pop_head_into(list, data);
+}
+
+static void * dl_foldl_ds(void * list, const foldl_fn fn, const void * init)
+{
+	return dl_foldl(list, fn, init);
+}
+
+static void * dl_fetch_ds(void * list, const size_t pos)
+{
+	return dl_fetch(list, pos);
+}
+
+static void * ul_create_ds(const struct ds_properties * props)
+{
+	return ul_create(props);
+}
+
+static void ul_destroy_ds(void * list)
+{
+	unrolled_list ul = list;
+
+	ul_destroy(&ul);
+}
+
+static void ul_push_tail_ds(void * list, const void * data)
+{
+	ul_push_tail(list, data);
+}
+
+static bool ul_pop_head_into_ds(void * list, void * data)
+{
+	return ul_pop_head_into(list, data);
+}
+
+static void * ul_foldl_ds(void * list, const foldl_fn fn, const void * init)
+{
+	return ul_foldl(list, fn, init);
+}
+
+static void * ul_fetch_ds(void * list, const size_t pos)
+{
+	return ul_fetch(list, pos);
+}
+
+static void * sk_create_ds(const struct ds_properties * props)
+{
+	return sk_create(props);
+}
+
+static void sk_destroy_ds(void * list)
+{
+	skip_list sk = list;
+
+	sk_destroy(&sk);
+}
+
+static void sk_push_tail_ds(void * list, const void * data)
+{
+	sk_push_tail(list, data);
+}
+
+static bool sk_pop_head_into_ds(void * list, void * data)
+{
+	return sk_pop_head_into(list, data);
+}
+
+static void * sk_foldl_ds(void * list, const foldl_fn fn, const void * init)
+{
+	return sk_foldl(list, fn, init);
+}
+
+static void * sk_fetch_ds(void * list, const size_t pos)
+{
+	return sk_fetch(list, pos);
+}
+
+static const struct list_ops lists[] = {
+	{"sl", sl_create_ds, sl_destroy_ds, sl_push_tail_ds,
+	 sl_pop_head_into_ds, sl_foldl_ds, sl_fetch_ds},
+	{"dl", dl_create_ds, dl_destroy_ds, dl_push_tail_ds,
+	 dl_pop_head_into_ds, dl_foldl_ds, dl_fetch_ds},
+	{"ul", ul_create_ds, ul_destroy_ds, ul_push_tail_ds,
+	 ul_pop_head_into_ds, ul_foldl_ds, ul_fetch_ds},
+	{"sk", sk_create_ds, sk_destroy_ds, sk_push_tail_ds,
+	 sk_pop_head_into_ds, sk_foldl_ds, sk_fetch_ds},
+};
+
+/* The resident set size of this process, in KiB. */
+static size_t resident(void)
+{
+	FILE * statm;
+	size_t pages = 0;
+
+	statm = fopen("/proc/self/statm", "r");
+	if(statm) {
+		if(fscanf(statm, "%*s %zu", &pages) != 1)
+			pages = 0;
+		fclose(statm);
+	}
+
+	return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/* Fill a list with RECORDS elements, sum them, drain it, then push and pop one
+ * element at a time with the list half full.  Each run happens in a child
+ * process, so that memory the allocator kept from an earlier run does not hide
+ * this run's memory use. */
+static void bench_list(const struct list_ops * ops, const bool pooled)
+{
+	char label[64];
+	double start;
+	size_t before;
+	uint64_t record;
+	void * list;
+	pid_t child;
+	const char * mode = pooled ? "pooled" : "malloc";
+	struct ds_properties props = {
+		.data_size = sizeof(uint64_t),
+		.pooled    = pooled,
+	};
+
+	fflush(stdout);
+	child = fork();
+	if(child < 0) {
+		perror("fork");
+		return;
+	} else if(child > 0) {
+		waitpid(child, NULL, 0);
+		return;
+	}
+
+	before = resident();
+	list = ops->create(&props);
+	if(!list) {
+		perror("create");
+		exit(EXIT_FAILURE);
+	}
+
+	start = bench_now();
+	for(record = 0; record < RECORDS; record++)
+		ops->push_tail(list, &record);
+	snprintf(label, sizeof(label), "%s_push_tail (%s)", ops->name, mode);
+	bench_report(label, RECORDS, bench_now() - start);
+
+	snprintf(label, sizeof(label), "  resident memory for 1M elements (%s)",
+	         mode);
+	printf("%-52s %14zu KiB\n", label, resident() - before);
+
+	record = 0;
+	start = bench_now();
+	free(ops->foldl(list, sum, &record));
+	snprintf(label, sizeof(label), "%s_foldl elements (%s)",
+	         ops->name, mode);
+	bench_report(label, RECORDS, bench_now() - start);
+
+	start = bench_now();
+	while(ops->pop_head_into(list, &record)) {}
+	snprintf(label, sizeof(label), "%s_pop_head_into (%s)",
+	         ops->name, mode);
+	bench_report(label, RECORDS, bench_now() - start);
+
+	for(record = 0; record < RECORDS / 2; record++)
+		ops->push_tail(list, &record);
+
+	start = bench_now();
+	for(size_t i = 0; i < RECORDS; i++) {
+		ops->push_tail(list, &record);
+		ops->pop_head_into(list, &record);
+	}
+	snprintf(label, sizeof(label), "%s_push_tail/pop_head_into (%s)",
+	         ops->name, mode);
+	bench_report(label, RECORDS, bench_now() - start);
+
+	ops->destroy(list);
+	fflush(stdout);
+	_exit(EXIT_SUCCESS);
+}
+
+/* Fetch every position of a list in order, then in reverse order, then at
+ * scattered positions. */
+static void bench_fetch(const struct list_ops * ops)
+{
+	char label[64];
+	double start;
+	uint64_t record;
+	void * list;
+	struct ds_properties props = {
+		.data_size = sizeof(uint64_t),
+	};
+
+	list = ops->create(&props);
+	if(!list) {
+		perror("create");
+		return;
+	}
+
+	for(record = 0; record < FETCHES; record++)
+		ops->push_tail(list, &record);
+
+	start = bench_now();
+	for(size_t i = 0; i < FETCHES; i++)
+		ops->fetch(list, i);
+	snprintf(label, sizeof(label), "%s_fetch ascending (20K elements)",
+	         ops->name);
+	bench_report(label, FETCHES, bench_now() - start);
+
+	start = bench_now();
+	for(size_t i = FETCHES; i-- > 0;)
+		ops->fetch(list, i);
+	snprintf(label, sizeof(label), "%s_fetch descending (20K elements)",
+	         ops->name);
+	bench_report(label, FETCHES, bench_now() - start);
+
+	start = bench_now();
+	for(size_t i = 0; i < FETCHES; i++)
+		ops->fetch(list, (i * 7919) % FETCHES);
+	snprintf(label, sizeof(label), "%s_fetch scattered (20K elements)",
+	         ops->name);
+	bench_report(label, FETCHES, bench_now() - start);
+
+	ops->destroy(list);
+}
+
+int main(void)
+{
+	for(size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); i++) {
+		bench_list(&lists[i], false);
+		bench_list(&lists[i], true);
+	}
+
+	for(size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); i++)
+		bench_fetch(&lists[i]);
+
+	return 0;
+}
@@ -0,0 +1,139 @@
+/* mpmc_queue.c - Benchmarks for the Multi-Producer/Multi-Consumer Queue API
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "bench.h"
+#include "list/mpmc_queue.h"
+#include "list/ring_buffer.h"
+
+#define RECORDS     2000000
+#define MAX_THREADS 8
+
+static const struct ds_properties props = {
+	.data_size = sizeof(uint64_t),
+	.entries   = 1024,
+};
+
+/* Each benchmark runs the same loops over a different push/pop pair. */
+struct worker {
+	void * ds;
+	bool (* push)(void * ds, const void * data);
+	void * (* pop)(void * ds);
+	size_t records;
+};
+
+static bool rb_push(void * ds, const void * data)
+{
+	return rb_push_tail(ds, data);
+}
+
+static void * rb_pop(void * ds)
+{
+	return rb_pop_head(ds);
+}
+
+static bool mq_push_ds(void * ds, const void * data)
+{
+	return mq_push(ds, data);
+}
+
+static void * mq_pop_ds(void * ds)
+{
+	return mq_pop(ds);
+}
+
+static void * producer(void * arg)
+{
+	struct worker * worker = arg;
+
+	for(uint64_t i = 0; i < worker->records; i++)
+		while(!worker->push(worker->ds, &i))
+			sched_yield();
+
+	return NULL;
+}
+
+static void * consumer(void * arg)
+{
+	struct worker * worker = arg;
+	void * data;
+
+	for(size_t i = 0; i < worker->records; i++) {
+		while(!(data = worker->pop(worker->ds)))
+			sched_yield();
+
+		free(data);
+	}
+
+	return NULL;
+}
+
+/* Run `threads` producers and `threads` consumers over one shared queue. */
+static void bench_fan(const char * name, struct worker * worker, size_t threads)
+{
+	char label[64];
+	double start;
+	pthread_t producers[MAX_THREADS];
+	pthread_t consumers[MAX_THREADS];
+
+	worker->records = RECORDS / threads;
+
+	start = bench_now();
+	for(size_t i = 0; i < threads; i++) {
+		pthread_create(&producers[i], NULL, producer, worker);
+		pthread_create(&consumers[i], NULL, consumer, worker);
+	}
+
+	for(size_t i = 0; i < threads; i++) {
+		pthread_join(producers[i], NULL);
+		pthread_join(consumers[i], NULL);
+	}
+
+	snprintf(label, sizeof(label), "%s (%zu x %zu threads)",
+		 name, threads, threads);
+	bench_report(label, worker->records * threads, bench_now() - start);
+}
+
+int main(void)
+{
+	ring_buffer buf;
+	mpmc_queue queue;
+
+	buf = rb_create(&props);
+	queue = mq_create(&props);
+	if(!buf || !queue) {
+		perror("create");
+		return 1;
+	}
+
+	for(size_t threads = 1; threads <= MAX_THREADS; threads *= 2) {
+		struct worker rb_worker = {buf, rb_push, rb_pop, 0};
+		struct worker mq_worker = {queue, mq_push_ds, mq_pop_ds, 0};
+
+		bench_fan("ring_buffer (locked)", &rb_worker, threads);
+		bench_fan("mpmc_queue", &mq_worker, threads);
+	}
+
+	mq_destroy(&queue);
+	rb_destroy(&buf);
+
+	return 0;
+}
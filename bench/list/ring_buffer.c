@@ -0,0 +1,534 @@
+/* ring_buffer.c - Benchmarks for the Ring Buffer API
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "list/ring_buffer.h"
+
+#define RECORDS 2000000
+
+static const struct ds_properties locked_props = {
+	.data_size = sizeof(uint64_t),
+	.entries   = 1024,
+};
+
+static const struct ds_properties spsc_props = {
+	.data_size = sizeof(uint64_t),
+	.entries   = 1024,
+	.spsc      = true,
+};
+
+static void increment(void * data)
+{
+	(*(uint64_t *) data)++;
+}
+
+/* Push and pop one block at a time from a single thread, then iterate over a
+ * full buffer, to measure the cost of index arithmetic. */
+static void bench_indexing(const char * name, const size_t entries)
+{
+	char label[64];
+	double start;
+	ring_buffer buf;
+	struct ds_properties props = locked_props;
+
+	props.entries = entries;
+	buf = rb_create(&props);
+	if(!buf) {
+		perror(name);
+		return;
+	}
+
+	start = bench_now();
+	for(uint64_t i = 0; i < RECORDS; i++) {
+		rb_push_tail(buf, &i);
+		if(rb_full(buf))
+			while(!rb_empty(buf))
+				free(rb_pop_head(buf));
+	}
+	snprintf(label, sizeof(label), "rb_push_tail/rb_pop_head %s", name);
+	bench_report(label, RECORDS, bench_now() - start);
+
+	while(!rb_full(buf))
+		rb_push_tail(buf, &(uint64_t) {0});
+
+	start = bench_now();
+	for(size_t i = 0; i < RECORDS / entries; i++)
+		rb_map(buf, increment);
+	snprintf(label, sizeof(label), "rb_map %s", name);
+	bench_report(label, (RECORDS / entries) * entries, bench_now() - start);
+
+	rb_destroy(&buf);
+}
+
+#define GAP_ENTRIES 65536
+#define GAP_OPS     2000
+
+/* Insert into and delete from a third of the way into a three-quarters full
+ * buffer, so that every operation shifts a quarter of the buffer's capacity.
+ */
+static void bench_gap(const size_t data_size)
+{
+	char label[64];
+	double start;
+	uint8_t data[256] = {0};
+	ring_buffer buf;
+	struct ds_properties props = {
+		.data_size = data_size,
+		.entries   = GAP_ENTRIES,
+	};
+
+	buf = rb_create(&props);
+	if(!buf) {
+		perror("rb_create");
+		return;
+	}
+
+	/* Start with the contents wrapped around the end of the storage. */
+	for(size_t i = 0; i < GAP_ENTRIES - GAP_ENTRIES / 4; i++)
+		rb_push_tail(buf, data);
+	for(size_t i = 0; i < GAP_ENTRIES / 4; i++)
+		rb_pop_head_into(buf, data);
+	for(size_t i = 0; i < GAP_ENTRIES / 4; i++)
+		rb_push_tail(buf, data);
+
+	start = bench_now();
+	for(size_t i = 0; i < GAP_OPS; i++) {
+		rb_insert(buf, data, GAP_ENTRIES / 4);
+		rb_delete(buf, GAP_ENTRIES / 4);
+	}
+	snprintf(label, sizeof(label),
+	         "rb_insert/rb_delete (%zuB, 64Ki entries)", data_size);
+	bench_report(label, 2 * GAP_OPS, bench_now() - start);
+
+	rb_destroy(&buf);
+}
+
+/* Search a full buffer of 1Mi blocks for a block it doesn't hold, so every
+ * call to rb_elem() scans the whole buffer. */
+#define ELEM_ENTRIES (1 << 20)
+#define ELEM_OPS     100
+
+static void bench_elem(const size_t data_size)
+{
+	char label[64];
+	double start;
+	uint8_t data[16] = {0};
+	uint8_t key[16];
+	ring_buffer buf;
+	struct ds_properties props = {
+		.data_size = data_size,
+		.entries   = ELEM_ENTRIES,
+	};
+
+	buf = rb_create(&props);
+	if(!buf) {
+		perror("rb_create");
+		return;
+	}
+
+	for(size_t i = 0; i < ELEM_ENTRIES; i++)
+		rb_push_tail(buf, data);
+	memset(key, 0xFF, sizeof(key));
+
+	start = bench_now();
+	for(size_t i = 0; i < ELEM_OPS; i++)
+		if(rb_elem(buf, key))
+			abort();
+	snprintf(label, sizeof(label), "rb_elem blocks (%zuB, 1Mi entries)",
+	         data_size);
+	bench_report(label, (size_t) ELEM_OPS * ELEM_ENTRIES,
+	             bench_now() - start);
+
+	rb_destroy(&buf);
+}
+
+/* Reverse a buffer of 1Mi blocks that wraps around the end of its storage,
+ * and rotate it full and (slightly less than) half full. */
+#define REVERSE_ENTRIES (1 << 20)
+#define REVERSE_OPS     100
+
+static void bench_reverse(const size_t data_size)
+{
+	char label[64];
+	double start;
+	uint8_t data[16] = {0};
+	ring_buffer buf;
+	struct ds_properties props = {
+		.data_size = data_size,
+		.entries   = REVERSE_ENTRIES,
+	};
+
+	buf = rb_create(&props);
+	if(!buf) {
+		perror("rb_create");
+		return;
+	}
+
+	for(size_t i = 0; i < REVERSE_ENTRIES / 2; i++) {
+		rb_push_tail(buf, data);
+		rb_pop_head_into(buf, data);
+	}
+	for(size_t i = 0; i < REVERSE_ENTRIES; i++)
+		rb_push_tail(buf, data);
+
+	start = bench_now();
+	for(size_t i = 0; i < REVERSE_OPS; i++)
+		rb_reverse(buf);
+	snprintf(label, sizeof(label), "rb_reverse blocks (%zuB, 1Mi entries)",
+	         data_size);
+	bench_report(label,
+	             (size_t) REVERSE_OPS * REVERSE_ENTRIES,
+	             bench_now() - start);
+
+	start = bench_now();
+	for(size_t i = 0; i < REVERSE_OPS; i++)
+		rb_rotate(buf, REVERSE_ENTRIES / 3);
+	snprintf(label, sizeof(label), "rb_rotate full (%zuB, 1Mi entries)",
+	         data_size);
+	bench_report(label, REVERSE_OPS, bench_now() - start);
+
+	for(size_t i = 0; i < REVERSE_ENTRIES / 2 + 1; i++)
+		rb_pop_head_into(buf, data);
+
+	start = bench_now();
+	for(size_t i = 0; i < REVERSE_OPS; i++)
+		rb_rotate(buf, REVERSE_ENTRIES / 3);
+	snprintf(label, sizeof(label), "rb_rotate half (%zuB, 1Mi entries)",
+	         data_size);
+	bench_report(label, REVERSE_OPS, bench_now() - start);
+
+	rb_destroy(&buf);
+}
+
+RING_BUFFER_DEFINE(u64_rb, uint64_t)
+
+/* Push and pop one block at a time, then sum a full buffer, through both the
+ * generic interface and the typed one generated by RING_BUFFER_DEFINE(). */
+static void bench_typed(void)
+{
+	double start;
+	uint64_t out;
+	uint64_t sum = 0;
+	uint64_t * current;
+	ring_buffer buf;
+
+	buf = u64_rb_create(&locked_props);
+	if(!buf) {
+		perror("u64_rb_create");
+		return;
+	}
+
+	start = bench_now();
+	for(uint64_t i = 0; i < RECORDS; i++) {
+		rb_push_tail(buf, &i);
+		rb_pop_head_into(buf, &out);
+	}
+	bench_report("rb_push_tail/rb_pop_head_into (generic)",
+	             RECORDS,
+	             bench_now() - start);
+
+	start = bench_now();
+	for(uint64_t i = 0; i < RECORDS; i++) {
+		u64_rb_push_tail(buf, i);
+		u64_rb_pop_head(buf, &out);
+	}
+	bench_report("rb_push_tail/rb_pop_head_into (typed)",
+	             RECORDS,
+	             bench_now() - start);
+
+	while(u64_rb_push_tail(buf, 1));
+
+	start = bench_now();
+	for(size_t i = 0; i < RECORDS / locked_props.entries; i++) {
+		ring_buffer_foreach(buf, current)
+			sum += *current;
+	}
+	bench_report("ring_buffer_foreach sum (generic)",
+	             RECORDS,
+	             bench_now() - start);
+
+	start = bench_now();
+	for(size_t i = 0; i < RECORDS / locked_props.entries; i++) {
+		ring_buffer_typed_foreach(u64_rb, buf, current)
+			sum += *current;
+	}
+	bench_report("ring_buffer_foreach sum (typed)",
+	             RECORDS,
+	             bench_now() - start);
+
+	if(sum != 2 * (RECORDS / locked_props.entries) * locked_props.entries)
+		abort();
+
+	rb_destroy(&buf);
+}
+
+#define BATCH 256
+
+/* Move RECORDS blocks through a buffer in batches of BATCH, either one block
+ * at a time or with the bulk APIs. */
+static void bench_batch(void)
+{
+	uint64_t records[BATCH];
+	double start;
+	ring_buffer buf;
+	void * data;
+
+	buf = rb_create(&locked_props);
+	if(!buf) {
+		perror("rb_create");
+		return;
+	}
+
+	for(size_t i = 0; i < BATCH; i++)
+		records[i] = i;
+
+	start = bench_now();
+	for(size_t i = 0; i < RECORDS / BATCH; i++) {
+		for(size_t j = 0; j < BATCH; j++)
+			rb_push_tail(buf, &records[j]);
+		for(size_t j = 0; j < BATCH; j++) {
+			data = rb_pop_head(buf);
+			memcpy(&records[j], data, sizeof(records[j]));
+			free(data);
+		}
+	}
+	bench_report("rb_push_tail/rb_pop_head x 256",
+		     (RECORDS / BATCH) * BATCH, bench_now() - start);
+
+	start = bench_now();
+	for(size_t i = 0; i < RECORDS / BATCH; i++) {
+		rb_push_tail_n(buf, records, BATCH);
+		rb_pop_head_n(buf, records, BATCH);
+	}
+	bench_report("rb_push_tail_n/rb_pop_head_n (256)",
+		     (RECORDS / BATCH) * BATCH, bench_now() - start);
+
+	rb_destroy(&buf);
+}
+
+static void * producer(void * arg)
+{
+	ring_buffer buf = arg;
+
+	for(uint64_t i = 0; i < RECORDS; i++)
+		while(!rb_push_tail(buf, &i))
+			sched_yield();
+
+	return NULL;
+}
+
+/* One producer thread pushes RECORDS blocks onto the tail of a buffer while
+ * the calling thread pops them off the head. */
+static void bench_pipe(const char * name, const struct ds_properties * props)
+{
+	double start;
+	pthread_t thread;
+	ring_buffer buf;
+	void * data;
+
+	buf = rb_create(props);
+	if(!buf) {
+		perror(name);
+		return;
+	}
+
+	start = bench_now();
+	pthread_create(&thread, NULL, producer, buf);
+
+	for(size_t i = 0; i < RECORDS; i++) {
+		while(!(data = rb_pop_head(buf)))
+			sched_yield();
+
+		free(data);
+	}
+
+	pthread_join(thread, NULL);
+	bench_report(name, RECORDS, bench_now() - start);
+
+	rb_destroy(&buf);
+}
+
+/* Run the calling thread on CPU `cpu`, or on any CPU if there is only one. */
+static void pin(const long cpu)
+{
+	cpu_set_t set;
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu % (cpus > 0 ? cpus : 1), &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/* The number of times the producer found its copy of the consumer's index
+ * out of date, and had to fetch the consumer's cache line. */
+static size_t head_reloads;
+
+static void * pinned_producer(void * arg)
+{
+	ring_buffer buf = arg;
+	size_t cached;
+
+	pin(0);
+	for(uint64_t i = 0; i < RECORDS; i++) {
+		cached = DS_PRIV(buf)->head_cache;
+		while(!rb_push_tail(buf, &i))
+			sched_yield();
+		head_reloads += DS_PRIV(buf)->head_cache != cached;
+	}
+
+	return NULL;
+}
+
+/* An SPSC pipe between two threads on different CPUs (when there are two),
+ * popping into caller storage so that only the two sides' index updates are
+ * shared.  Besides throughput, report how often the producer had to read the
+ * consumer's index: without the cached copy, that would be every push. */
+static void bench_pinned(void)
+{
+	double start;
+	pthread_t thread;
+	ring_buffer buf;
+	uint64_t record;
+
+	buf = rb_create(&spsc_props);
+	if(!buf) {
+		perror("rb_create");
+		return;
+	}
+
+	head_reloads = 0;
+	start = bench_now();
+	pthread_create(&thread, NULL, pinned_producer, buf);
+
+	pin(1);
+	for(size_t i = 0; i < RECORDS; i++)
+		while(!rb_pop_head_into(buf, &record))
+			sched_yield();
+
+	pthread_join(thread, NULL);
+	bench_report("rb_push_tail/rb_pop_head_into pipe (spsc, pinned)",
+	             RECORDS,
+	             bench_now() - start);
+
+	printf("%-52s %14.1f\n",
+	       "  consumer index reloads per 1000 pushes",
+	       1000.0 * head_reloads / RECORDS);
+
+	rb_destroy(&buf);
+}
+
+/* The same pipe, but between two processes: a child process pushes RECORDS
+ * blocks through a shared memory buffer, and a pipe(2) for comparison. */
+static void bench_shared(void)
+{
+	char path[64];
+	double start;
+	uint64_t record;
+	int fds[2];
+	pid_t child;
+	ring_buffer buf;
+	struct ds_properties props = spsc_props;
+
+	snprintf(path, sizeof(path), "/focs-bench-%d", (int) getpid());
+	props.shared = true;
+	props.path   = path;
+
+	buf = rb_create(&props);
+	if(!buf) {
+		perror("rb_create");
+		return;
+	}
+
+	start = bench_now();
+	if((child = fork()) == 0) {
+		ring_buffer producer = rb_create(&props);
+
+		for(uint64_t i = 0; i < RECORDS; i++)
+			while(!rb_push_tail(producer, &i))
+				sched_yield();
+		_exit(0);
+	}
+
+	for(size_t i = 0; i < RECORDS; i++)
+		while(!rb_pop_head_into(buf, &record))
+			sched_yield();
+
+	waitpid(child, NULL, 0);
+	bench_report("rb_push_tail/rb_pop_head_into (processes, shm)",
+	             RECORDS,
+	             bench_now() - start);
+
+	rb_destroy(&buf);
+	shm_unlink(path);
+
+	if(pipe(fds) < 0) {
+		perror("pipe");
+		return;
+	}
+
+	start = bench_now();
+	if((child = fork()) == 0) {
+		close(fds[0]);
+		for(uint64_t i = 0; i < RECORDS; i++)
+			if(write(fds[1], &i, sizeof(i)) != sizeof(i))
+				_exit(1);
+		_exit(0);
+	}
+
+	close(fds[1]);
+	for(size_t i = 0; i < RECORDS; i++)
+		if(read(fds[0], &record, sizeof(record)) != sizeof(record))
+			break;
+
+	waitpid(child, NULL, 0);
+	close(fds[0]);
+	bench_report("write/read (processes, pipe)",
+	             RECORDS,
+	             bench_now() - start);
+}
+
+int main(void)
+{
+	bench_indexing("(1000 entries)", 1000);
+	bench_indexing("(1024 entries)", 1024);
+	bench_batch();
+	bench_typed();
+
+	for(size_t size = 1; size <= 256; size *= 4)
+		bench_gap(size);
+	for(size_t size = 1; size <= 16; size *= 2)
+		bench_elem(size);
+	for(size_t size = 1; size <= 16; size *= 2)
+		bench_reverse(size);
+
+	bench_pipe("rb_push_tail/rb_pop_head pipe (locked)", &locked_props);
+	bench_pipe("rb_push_tail/rb_pop_head pipe (spsc)",   &spsc_props);
+	bench_pinned();
+	bench_shared();
+
+	return 0;
+}
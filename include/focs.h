@@ -33,6 +33,10 @@
 
 #define __immutable(type) const type * const
 
+/* Keep data written by different threads on separate cache lines. */
+#define CACHE_LINE_SIZE 64
+#define __cacheline_aligned __attribute__((__aligned__(CACHE_LINE_SIZE)))
+
 /**
  * Set errno and return from the current function with some value.
  * @param err The error number to set errno to
@@ -0,0 +1,82 @@
+/* block.h - Data Block Swapping and Reversal
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FOCS_BLOCK_H
+#define __FOCS_BLOCK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "focs.h"
+
+/**
+ * Exchange the contents of two data blocks.
+ * @param a    A pointer to the first block (non-NULL)
+ * @param b    A pointer to the second block (non-NULL)
+ * @param size The size of each block in bytes
+ *
+ * The blocks are swapped eight bytes at a time through a register, so no
+ * temporary block has to be allocated.  The blocks must not overlap.
+ */
+static inline __nonulls void mem_swap(void * a, void * b, const size_t size)
+{
+	uint8_t * x = a;
+	uint8_t * y = b;
+	uint64_t u;
+	uint64_t v;
+	uint8_t c;
+	size_t i;
+
+	for(i = 0; i + sizeof(u) <= size; i += sizeof(u)) {
+		memcpy(&u, x + i, sizeof(u));
+		memcpy(&v, y + i, sizeof(v));
+		memcpy(x + i, &v, sizeof(v));
+		memcpy(y + i, &u, sizeof(u));
+	}
+
+	for(; i < size; i++) {
+		c    = x[i];
+		x[i] = y[i];
+		y[i] = c;
+	}
+}
+
+/**
+ * Exchange two arrays of data blocks, reversing their order.
+ * @param lo    A pointer to the first array (non-NULL)
+ * @param hi    A pointer to the second array (non-NULL)
+ * @param count The number of blocks in each array
+ * @param size  The size of each block in bytes
+ *
+ * Swap block `i` of `lo` with block `count - 1 - i` of `hi` for every `i`, so
+ * each array ends up holding the other's blocks in reverse order.  Reversing
+ * an array of `n` blocks is one call, with `lo` the first `n / 2` blocks and
+ * `hi` the last `n / 2`.  The arrays must not overlap.
+ *
+ * Blocks of 1, 2, 4, or 8 bytes are reversed a whole vector at a time with
+ * SSE2 or AVX2 shuffles where the CPU supports them.
+ */
+void __nonulls mem_swap_reverse(void * lo,
+	                        void * hi,
+	                        const size_t count,
+	                        const size_t size);
+
+#endif /* __FOCS_BLOCK_H */
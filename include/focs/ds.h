@@ -27,11 +27,28 @@
 #include <string.h>
 
 #include "focs.h"
+#include "focs/search.h"
 
 struct ds_properties {
 	size_t data_size;
 	size_t entries;
 	bool   overwrite;
+	bool   spsc;
+	bool   mirror;
+	bool   growable;
+	bool   shared;
+
+	/* Allow threads to sleep until a ring buffer has data or room. */
+	bool   blocking;
+
+	/* Allocate a linked list's elements from a pool of slabs. */
+	bool   pooled;
+
+	/* The maximum number of consumers of a broadcast data structure. */
+	size_t consumers;
+
+	/* If non-NULL, the data structure is backed by this file. */
+	const char * path;
 };
 
 #define __DS_PRIV_NAME  __priv
@@ -54,7 +71,15 @@ struct ds_properties {
 #define DS_DATA_SIZE(ds) (DS_PROPS(ds)->data_size)
 #define DS_ENTRIES(ds)   (DS_PROPS(ds)->entries)
 #define DS_OVERWRITE(ds) (DS_PROPS(ds)->overwrite)
+#define DS_SPSC(ds)      (DS_PROPS(ds)->spsc)
+#define DS_MIRROR(ds)    (DS_PROPS(ds)->mirror)
+#define DS_GROWABLE(ds)  (DS_PROPS(ds)->growable)
+#define DS_SHARED(ds)    (DS_PROPS(ds)->shared)
+#define DS_BLOCKING(ds)  (DS_PROPS(ds)->blocking)
+#define DS_POOLED(ds)    (DS_PROPS(ds)->pooled)
+#define DS_CONSUMERS(ds) (DS_PROPS(ds)->consumers)
+#define DS_PATH(ds)      (DS_PROPS(ds)->path)
 
-#define DS_DATA_EQ(ds, s1, s2) (memcmp(s1, s2, DS_DATA_SIZE(ds)) == 0)
+#define DS_DATA_EQ(ds, s1, s2) mem_eq(s1, s2, DS_DATA_SIZE(ds))
 
 #endif /* __FOCS_DS_H */
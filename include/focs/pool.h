@@ -0,0 +1,108 @@
+/* pool.h - Fixed-Size Object Pool API
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FOCS_POOL_H
+#define __FOCS_POOL_H
+
+#include <stddef.h>
+
+#include "focs.h"
+
+/**
+ * @struct pool_slab
+ * The header at the start of every slab of objects in a pool.
+ *
+ * Slabs are aligned to their own size, so the slab an object belongs to is
+ * found by masking the object's address.
+ *
+ * This structure is intended for internal use only.
+ */
+struct pool_slab {
+	struct pool_slab * next;
+
+	/* The number of this slab's objects currently allocated. */
+	size_t used;
+};
+
+/**
+ * @struct pool
+ * A pool of equally sized objects, carved out of large slabs.
+ *
+ * Free objects are kept on a single intrusive free list, so allocating and
+ * freeing an object only pushes or pops the head of that list.  A pool is not
+ * thread-safe; the data structure owning it must serialize access.
+ */
+struct pool {
+	size_t object_size;
+	size_t slab_size;
+	size_t per_slab;
+
+	struct pool_slab * slabs;
+	void * free;
+};
+
+/**
+ * Create a new object pool.
+ * @param object_size The size of each object in bytes
+ *
+ * @return Upon successful completion, pool_create() shall return the new
+ * pool.  Otherwise, `NULL` shall be returned and `errno` set to `ENOMEM`.
+ */
+struct pool * pool_create(const size_t object_size);
+
+/**
+ * Destroy an object pool.
+ * @param pool A pointer to the pool to destroy (non-NULL)
+ *
+ * Release every slab of `*pool` at once, including the objects that are
+ * still allocated, then set `*pool` to `NULL`.
+ */
+void __nonulls pool_destroy(struct pool ** pool);
+
+/**
+ * Allocate an object from a pool.
+ * @param pool The pool to allocate from (non-NULL)
+ *
+ * @return A pointer to an uninitialized object of the pool's object size,
+ * aligned like memory returned by malloc().  Otherwise, `NULL` shall be
+ * returned and `errno` set to `ENOMEM`.
+ */
+void * __nonulls pool_alloc(struct pool * pool);
+
+/**
+ * Return an object to its pool.
+ * @param pool   The pool `object` was allocated from (non-NULL)
+ * @param object The object to free (non-NULL)
+ */
+void __nonulls pool_free(struct pool * pool, void * object);
+
+/**
+ * Release a pool's empty slabs.
+ * @param pool The pool to trim (non-NULL)
+ *
+ * Free every slab none of whose objects are allocated, returning its memory
+ * to the system.  This walks the free list, so it is best called after
+ * freeing many objects at once rather than after every pool_free().
+ *
+ * @return The number of slabs released.
+ */
+size_t __nonulls pool_trim(struct pool * pool);
+
+#endif /* __FOCS_POOL_H */
@@ -0,0 +1,92 @@
+/* search.h - Data Block Comparison and Search
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FOCS_SEARCH_H
+#define __FOCS_SEARCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "focs.h"
+
+/**
+ * Compare two data blocks for equality.
+ * @param a    A pointer to the first block (non-NULL)
+ * @param b    A pointer to the second block (non-NULL)
+ * @param size The size of each block in bytes
+ *
+ * Blocks of 1, 2, 4, 8, or 16 bytes are compared as integers, which the
+ * compiler can inline, rather than with a call to memcmp().
+ *
+ * @return `true` if the blocks hold the same bytes, otherwise `false`.
+ */
+static inline __pure __nonulls bool mem_eq(const void * a,
+	                                   const void * b,
+	                                   const size_t size)
+{
+	uint64_t x[2];
+	uint64_t y[2];
+
+	switch(size) {
+	case 1:
+		return *(const uint8_t *) a == *(const uint8_t *) b;
+	case 2:
+		memcpy(x, a, 2);
+		memcpy(y, b, 2);
+		return (uint16_t) x[0] == (uint16_t) y[0];
+	case 4:
+		memcpy(x, a, 4);
+		memcpy(y, b, 4);
+		return (uint32_t) x[0] == (uint32_t) y[0];
+	case 8:
+		memcpy(x, a, 8);
+		memcpy(y, b, 8);
+		return x[0] == y[0];
+	case 16:
+		memcpy(x, a, 16);
+		memcpy(y, b, 16);
+		return ((x[0] ^ y[0]) | (x[1] ^ y[1])) == 0;
+	default:
+		return memcmp(a, b, size) == 0;
+	}
+}
+
+/**
+ * Find a data block in an array of blocks.
+ * @param base  A pointer to the first block in the array
+ * @param count The number of blocks in the array
+ * @param size  The size of each block in bytes
+ * @param key   A pointer to the block to search for (non-NULL)
+ *
+ * Search `count` contiguous blocks of `size` bytes, starting at `base`, for
+ * the first one holding the same bytes as `key`.  For blocks of 1, 2, 4, 8,
+ * or 16 bytes, the search uses SSE2 or AVX2 vector comparisons where the CPU
+ * supports them.
+ *
+ * @return The index of the first matching block, or `count` if there is none.
+ */
+size_t mem_find(const void * base,
+	        const size_t count,
+	        const size_t size,
+	        const void * key);
+
+#endif /* __FOCS_SEARCH_H */
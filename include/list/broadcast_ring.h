@@ -0,0 +1,201 @@
+/* broadcast_ring.h - Single-Producer Broadcast Ring API
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIST_BROADCAST_RING_H
+#define __LIST_BROADCAST_RING_H
+
+#include "focs.h"
+#include "focs/ds.h"
+#include "list/ring_buffer.h"
+
+/**
+ * @struct br_cursor
+ * Represents a consumer's position in a broadcast ring.
+ *
+ * `sequence` is the sequence number of the next data block the consumer will
+ * read.  Each cursor sits on its own cache line, so consumers advancing their
+ * cursors do not contend with each other or with the producer.
+ *
+ * This structure is intended for internal use only.
+ */
+struct br_cursor {
+	size_t sequence __cacheline_aligned;
+	bool   active;
+};
+
+DS_START(broadcast_ring) {
+	void * data;
+	struct br_cursor * cursors;
+
+	/* The sequence number the producer will publish next.  Every block
+	 * with a lower sequence number (and at most `entries` of them) is
+	 * available to the consumers. */
+	size_t published __cacheline_aligned;
+
+	/* The producer's cached copy of the lowest active consumer cursor; it
+	 * is only refreshed when the producer seems to have caught up with it.
+	 */
+	size_t gate;
+} DS_END(broadcast_ring);
+
+/**
+ * Create a new broadcast ring with the given properties.
+ * @param props A pointer to a data structure properties structure (non-NULL)
+ *
+ * Allocates and initializes a new broadcast ring which holds up to
+ * `props->entries` data blocks of `props->data_size` bytes each, and which up
+ * to `props->consumers` consumers may subscribe to.
+ *
+ * A broadcast ring has a single producer and any number of consumers.  Unlike
+ * a ring buffer or queue, every data block published by the producer is seen
+ * by every subscribed consumer: each consumer reads from its own cursor, and
+ * a block is only overwritten once the slowest consumer has read it.  The
+ * producer and the consumers never take a lock, and consumers read every
+ * block published so far in one batch.
+ *
+ * @return Upon successful completion, br_create() shall return the newly
+ * created broadcast ring.  Otherwise, `NULL` shall be returned and `errno`
+ * set to indicate the error.  `EINVAL` indicates that `props->entries` or
+ * `props->consumers` is zero.
+ */
+broadcast_ring __nonulls br_create(const struct ds_properties * props);
+
+/**
+ * Destroy and deallocate a broadcast ring.
+ * @param ring A pointer to a `broadcast_ring` (non-NULL)
+ *
+ * Destroys and deallocates the ring pointed to by `ring`.  No other thread may
+ * be using the ring.
+ */
+void __nonulls br_destroy(broadcast_ring * ring);
+
+/**
+ * Subscribe a new consumer to a broadcast ring.
+ * @param ring The ring to subscribe to (non-NULL)
+ *
+ * Register a new consumer with `ring`.  The consumer will see every data block
+ * published after br_subscribe() returns, and until it calls
+ * br_unsubscribe(), the producer will not overwrite blocks it has not read.
+ * br_subscribe() may be called concurrently with the producer and with other
+ * consumers.
+ *
+ * @return The consumer's identifier, to be passed to the other consumer
+ * functions.  Otherwise, -1 shall be returned and `errno` set to `EAGAIN` if
+ * `props->consumers` consumers are already subscribed.
+ */
+ssize_t __nonulls br_subscribe(broadcast_ring ring);
+
+/**
+ * Unsubscribe a consumer from a broadcast ring.
+ * @param ring     The ring to unsubscribe from (non-NULL)
+ * @param consumer The consumer's identifier, from br_subscribe()
+ *
+ * After br_unsubscribe(), the producer no longer waits for `consumer`, and its
+ * identifier may be reused by a later call to br_subscribe().
+ */
+void __nonulls br_unsubscribe(broadcast_ring ring, const size_t consumer);
+
+/**
+ * Publish a data block to every consumer of a broadcast ring.
+ * @param ring The ring to publish to (non-NULL)
+ * @param data A pointer to the data to publish
+ *
+ * Copy `data` into `ring` and make it available to every subscribed consumer.
+ * Only one thread may publish to a ring.
+ *
+ * @return `true` if the data was published, or `false` if the slowest
+ * consumer has not yet read the block that would be overwritten.
+ */
+bool __nonulls br_publish(broadcast_ring ring, const void * data);
+
+/**
+ * Publish an array of data blocks to every consumer of a broadcast ring.
+ * @param ring  The ring to publish to (non-NULL)
+ * @param data  A pointer to an array of `count` data blocks
+ * @param count The number of data blocks to publish
+ *
+ * Publish as many of the blocks in `data` as the slowest consumer leaves room
+ * for, in order, making them all available to the consumers at once.
+ *
+ * @return The number of data blocks published.
+ */
+size_t __nonulls br_publish_n(broadcast_ring ring,
+	                      const void * data,
+	                      const size_t count);
+
+/**
+ * Determine the number of data blocks a consumer has not read yet.
+ * @param ring     The ring to check (non-NULL)
+ * @param consumer The consumer's identifier, from br_subscribe()
+ *
+ * @return The number of published data blocks that `consumer` has not read.
+ */
+size_t __nonulls br_available(const broadcast_ring ring, const size_t consumer);
+
+/**
+ * Read data blocks published to a broadcast ring.
+ * @param ring     The ring to read from (non-NULL)
+ * @param consumer The consumer's identifier, from br_subscribe()
+ * @param data     A pointer to space for `count` data blocks
+ * @param count    The maximum number of data blocks to read
+ *
+ * Copy up to `count` of the blocks published to `ring` that `consumer` has
+ * not read yet into `data`, oldest first, and advance past them.  Each
+ * consumer must only be used by one thread at a time.
+ *
+ * @return The number of data blocks read, which is zero if there were none.
+ */
+size_t __nonulls br_read(broadcast_ring ring,
+	                 const size_t consumer,
+	                 void * data,
+	                 const size_t count);
+
+/**
+ * Access published data blocks in place.
+ * @param ring     The ring to read from (non-NULL)
+ * @param consumer The consumer's identifier, from br_subscribe()
+ * @param count    The maximum number of data blocks to access
+ * @param span     An array of two spans to describe the data blocks
+ *
+ * Describe up to `count` of the blocks that `consumer` has not read yet, in
+ * up to two spans of the ring's storage, without copying them.  The blocks
+ * stay valid until `consumer` calls br_release().
+ *
+ * @return The number of data blocks described by `span`.
+ */
+size_t __nonulls br_peek(broadcast_ring ring,
+	                 const size_t consumer,
+	                 const size_t count,
+	                 struct rb_span span[2]);
+
+/**
+ * Finish reading data blocks accessed with br_peek().
+ * @param ring     The ring to release blocks from (non-NULL)
+ * @param consumer The consumer's identifier, from br_subscribe()
+ * @param count    The number of data blocks to release
+ *
+ * Advance `consumer` past the first `count` blocks returned by br_peek(),
+ * letting the producer overwrite them once every other consumer has read them.
+ * `count` must not be more than br_peek() returned.
+ */
+void __nonulls br_release(broadcast_ring ring,
+	                  const size_t consumer,
+	                  const size_t count);
+
+#endif /* __LIST_BROADCAST_RING_H */
@@ -20,8 +20,12 @@
 #ifndef __LIST_DOUBLE_LIST_H
 #define __LIST_DOUBLE_LIST_H
 
+#include <stdalign.h>
+#include <stddef.h>
+
 #include "focs.h"
 #include "focs/ds.h"
+#include "focs/pool.h"
 #include "hof.h"
 #include "list/linked_list.h"
 #include "sync/rwlock.h"
@@ -36,7 +40,9 @@ struct dl_element {
 	struct dl_element * next;
 	struct dl_element * prev;
 
-	void * data;
+	/* The element's data is stored in the element itself, with the same
+	 * alignment malloc() would give it. */
+	alignas(max_align_t) uint8_t data[];
 };
 
  DS_START(double_list) {
@@ -45,7 +51,18 @@ struct dl_element {
 	size_t length;
 	size_t data_size;
 
+	/* The element most recently reached by its position, and that position,
+	 * so that positional access near it need not walk from either end.  It
+	 * is `NULL` when not known, and only one reader at a time may use it,
+	 * while holding `finger_busy`. */
+	struct dl_element * finger;
+	size_t finger_pos;
+	bool finger_busy;
+
 	struct rwlock * rwlock;
+
+	/* Where elements are allocated from, if the list is pooled. */
+	struct pool * pool;
 } DS_END(double_list);
 
 #define __LENGTH(list) (DS_PRIV(list)->length)
@@ -134,6 +151,13 @@ struct dl_element {
  * Allocates a new doubly linked list at the structure pointer pointed to by
  * `list`.
  *
+ * Each element is a single allocation holding its data inline.  If
+ * `props->pooled` is set, elements are allocated from slabs owned by the list
+ * rather than with malloc().  Pushing and popping then reuse freed elements,
+ * the list's memory is released all at once when it is destroyed, and slabs
+ * left empty by dl_filter(), dl_drop_while(), or dl_take_while() are returned
+ * to the system.
+ *
  * @return Upon successful completion, dl_create() shall return a new
  * double_list.  Otherwise, `NULL` shall be returned and `errno` set to
  * indicate the error.
@@ -212,6 +236,30 @@ __nonulls void * dl_pop_head(double_list list);
  */
 __nonulls void * dl_pop_tail(double_list list);
 
+/**
+ * Pop a data element from the head of a list into caller storage.
+ * @param list The list to pop from
+ * @param data A pointer to room for one data element
+ *
+ * Remove the data element at the head of `list` and copy it into `data`, so
+ * the caller has nothing to free().
+ *
+ * @return `true` if an element was popped, or `false` if `list` was empty.
+ */
+__nonulls bool dl_pop_head_into(double_list list, void * data);
+
+/**
+ * Pop a data element from the tail of a list into caller storage.
+ * @param list The list to pop from
+ * @param data A pointer to room for one data element
+ *
+ * Remove the data element at the tail of `list` and copy it into `data`, so
+ * the caller has nothing to free().
+ *
+ * @return `true` if an element was popped, or `false` if `list` was empty.
+ */
+__nonulls bool dl_pop_tail_into(double_list list, void * data);
+
 /**
  * Insert a new data element to a given position in a list.
  * @param list The list to inesrt into
@@ -256,6 +304,22 @@ __nonulls bool dl_delete(double_list list, const size_t pos);
  */
 __nonulls void * dl_remove(double_list list, const size_t pos);
 
+/**
+ * Delete a data element from a given position in a list into caller storage.
+ * @param list The list to delete from
+ * @param pos  The position to delete the element at
+ *             (must be an index in the range `0..DS_PRIV(list)->length - 1`)
+ * @param data A pointer to room for one data element
+ *
+ * Delete the data element stored in `list` at the index indicated by `pos`,
+ * after copying it into `data`.
+ *
+ * @return `true` if the deletion succeeds, otherwise `false`.
+ */
+__nonulls bool dl_remove_into(double_list list,
+                              const size_t pos,
+                              void * data);
+
 /**
  * Determine if a list contains a value.
  * @param list The list to search
@@ -275,7 +339,9 @@ __nonnull((1)) bool dl_elem(const double_list list, __immutable(void) data);
  * @param pos  The index to fetch the element from
  *             (must be an index in the range `0..DS_PRIV(list)->length - 1`)
  *
- * Fetch the data stored at index `pos` in `list`.
+ * Fetch the data stored at index `pos` in `list`.  The list is walked from
+ * its head, its tail, or the position last looked up, whichever is closest,
+ * so fetching neighbouring positions one after another takes constant time.
  *
  * @return A pointer to the data at index `pos`, or `NULL` on failure.
  * This pointer should **not** be free()d explicitly, or the list will become
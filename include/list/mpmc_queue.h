@@ -0,0 +1,132 @@
+/* mpmc_queue.h - Bounded Multi-Producer/Multi-Consumer Queue API
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIST_MPMC_QUEUE_H
+#define __LIST_MPMC_QUEUE_H
+
+#include "focs.h"
+#include "focs/ds.h"
+
+/**
+ * @struct mq_cell
+ * Represents a slot in a multi-producer/multi-consumer queue.
+ *
+ * `sequence` tells producers and consumers whose turn it is to use the slot:
+ * a slot whose sequence equals a producer's ticket is free to be written, and a
+ * slot whose sequence equals a consumer's ticket plus one holds data ready to
+ * be read.  The data block itself follows the cell header in memory.
+ *
+ * This structure is intended for internal use only.
+ */
+struct mq_cell {
+	size_t sequence;
+	uint8_t data[];
+};
+
+DS_START(mpmc_queue) {
+	void * cells;
+	size_t stride;
+
+	/* Consumers and producers each claim tickets from their own counter;
+	 * keep the counters on separate cache lines so the two sides don't
+	 * contend for the same line. */
+	size_t head __cacheline_aligned;
+	size_t tail __cacheline_aligned;
+} DS_END(mpmc_queue);
+
+/**
+ * Create a new multi-producer/multi-consumer queue with the given properties.
+ * @param props A pointer to a data structure properties structure (non-NULL)
+ *
+ * Allocates and initializes a new bounded queue which holds at most
+ * `props->entries` data blocks of `props->data_size` bytes each.  Any number of
+ * threads may push to and pop from the queue concurrently without locking.
+ *
+ * @return Upon successful completion, mq_create() shall return the newly
+ * created queue.  Otherwise, `NULL` shall be returned and `errno` set to
+ * indicate the error.  `EINVAL` indicates that `props->entries` is zero, or
+ * that `props->overwrite` is set, which is not supported.
+ */
+mpmc_queue __nonulls mq_create(const struct ds_properties * props);
+
+/**
+ * Destroy and deallocate a multi-producer/multi-consumer queue.
+ * @param queue A pointer to a `mpmc_queue` (non-NULL)
+ *
+ * Destroys and deallocates the queue pointed to by `queue`.  No other thread
+ * may be using the queue.
+ */
+void __nonulls mq_destroy(mpmc_queue * queue);
+
+/**
+ * Determine the number of data blocks stored in a queue.
+ * @param queue The queue to check (non-NULL)
+ *
+ * @return The number of data blocks that have been pushed onto `queue` but
+ * not yet popped.  If other threads are pushing or popping concurrently, the
+ * result is only a snapshot.
+ */
+size_t __nonulls mq_size(const mpmc_queue queue);
+
+/**
+ * Determine if a queue is empty.
+ * @param queue The queue to check (non-NULL)
+ *
+ * @return `true` if `queue` is empty, or `false` otherwise.
+ */
+bool __nonulls mq_empty(const mpmc_queue queue);
+
+/**
+ * Determine if a queue is full.
+ * @param queue The queue to check (non-NULL)
+ *
+ * @return `true` if `queue` is full, or `false` otherwise.
+ */
+bool __nonulls mq_full(const mpmc_queue queue);
+
+/**
+ * Push a new data block onto the tail of a queue.
+ * @param queue The queue to push onto (non-NULL)
+ * @param data  A pointer to the data to push
+ *
+ * Push a copy of `data` onto the tail of `queue`.  This is the equivalent of
+ * rb_push_tail() for a ring buffer.
+ *
+ * @return `true` if the data was pushed, or `false` if `queue` was full.
+ */
+bool __nonulls mq_push(mpmc_queue queue, const void * data);
+
+/**
+ * Pop a data block from the head of a queue.
+ * @param queue The queue to pop from (non-NULL)
+ *
+ * Remove and return the data block at the head of `queue`.  This is the
+ * equivalent of rb_pop_head() for a ring buffer.
+ *
+ * @return Upon successful completion, this function shall return a pointer to
+ * a copy of the data block stored at the head of `queue`; otherwise, `NULL`
+ * shall be returned.  `NULL` is returned without setting `errno` if `queue` is
+ * empty.
+ *
+ * This pointer must be explicitly freed with free() when it is no longer
+ * needed.
+ */
+void * __nonulls mq_pop(mpmc_queue queue);
+
+#endif /* __LIST_MPMC_QUEUE_H */
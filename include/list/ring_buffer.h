@@ -24,41 +24,159 @@
 #include "hof.h"
 #include "focs/ds.h"
 #include "sync/rwlock.h"
+#include "sync/waitq.h"
 
 DS_START(ring_buffer) {
-	void * head;
-	void * tail;
-
+	/* Process-local state: pointers and handles which only mean something
+	 * to the process that set them up. */
 	void * data;
-	size_t length;
 
 	struct rwlock * rwlock;
+
+	/* Threads blocked until the buffer is non-empty or non-full. */
+	struct waitq * not_empty;
+	struct waitq * not_full;
+
+	/* The open backing file of a file-backed buffer, or -1. */
+	int fd;
+
+	/* Everything from `entries` on describes the buffer's contents without
+	 * using any pointers, so a shared buffer can keep it in shared memory
+	 * while each process has its own copy of the fields above. */
+
+	/* The current capacity.  This starts out as `props->entries`, but
+	 * growable buffers may be resized later. */
+	size_t entries __cacheline_aligned;
+
+	size_t mask;
+	bool   pow2;
+
+	/* Odd while a writer holds `rwlock`; lets readers validate lock-free
+	 * reads of the buffer. */
+	size_t seq;
+
+	/* `head` and `tail` are logical indices in the range [0, 2 * entries);
+	 * the data block at logical index `i` is stored in slot
+	 * `i % entries`.  Using twice the range lets `head == tail` mean empty
+	 * while a distance of `entries` means full, so no separate length
+	 * counter needs to be shared between the two ends of the buffer.
+	 *
+	 * If `entries` is a power of two, `head` and `tail` are instead
+	 * free-running counters that are simply allowed to overflow, and a
+	 * slot is found by masking with `mask` rather than dividing.
+	 *
+	 * The consumer's state and the producer's state each have a cache line
+	 * of their own, so that in SPSC mode neither side writes to a line the
+	 * other side reads on every operation.  Each side also keeps a copy of
+	 * the other side's index, which it only refreshes once the copy says
+	 * the buffer is empty (or full); the copy is never ahead of the real
+	 * index, so it can only make the buffer look emptier (or fuller) than
+	 * it really is. */
+	size_t head __cacheline_aligned;
+	size_t tail_cache;
+
+	/* The number of bytes of a partly written block at the head, left by
+	 * rb_write_fd(). */
+	size_t partial_out;
+
+	size_t tail __cacheline_aligned;
+	size_t head_cache;
+
+	/* The number of bytes of a partly read block after the tail, left by
+	 * rb_read_fd(). */
+	size_t partial_in;
 } DS_END(ring_buffer);
 
-#define __SPACE(buf)  (DS_DATA_SIZE(buf) * DS_ENTRIES(buf))
-#define __LENGTH(buf) (DS_PRIV(buf)->length)
-#define __HEAD(buf)   (DS_PRIV(buf)->head)
-#define __TAIL(buf)   (DS_PRIV(buf)->tail)
+/**
+ * A contiguous run of data blocks inside a ring buffer's storage.
+ *
+ * Because the blocks of a ring buffer may wrap around the end of its storage,
+ * a range of blocks is described by up to two spans; the second span is empty
+ * (its `count` is zero) if the range does not wrap.
+ */
+struct rb_span {
+	void * data;  /**< The address of the first block in the span */
+	size_t count; /**< The number of blocks in the span */
+};
+
+#define __ENTRIES(buf) (DS_PRIV(buf)->entries)
+#define __SPACE(buf)   (DS_DATA_SIZE(buf) * __ENTRIES(buf))
+#define __WRAP(buf)    (2 * __ENTRIES(buf))
+#define __LENGTH(buf) \
+	__distance(buf, DS_PRIV(buf)->head, DS_PRIV(buf)->tail)
+#define __HEAD(buf)   __slot(buf, DS_PRIV(buf)->head)
+#define __TAIL(buf)   __slot(buf, __retreat(buf, DS_PRIV(buf)->tail, 1))
 
 #define __IS_EMPTY(buf)       (__LENGTH(buf) <= 0)
-#define __IS_FULL(buf)        (__LENGTH(buf) >= DS_ENTRIES(buf))
-#define __INDEX_ABS(buf, rel) (__IS_EMPTY(buf) ? 0 : mod(rel, __LENGTH(buf)))
+#define __IS_FULL(buf)        (__LENGTH(buf) >= __ENTRIES(buf))
+#define __INDEX_ABS(buf, rel) \
+	(__IS_EMPTY(buf) ? 0 : mod((ssize_t) (rel), (ssize_t) __LENGTH(buf)))
 
-static inline __pure __nonulls void * __index_to_addr(const ring_buffer buf,
-	                                              const size_t index)
+#define __IS_POW2(buf) (DS_PRIV(buf)->pow2)
+
+static inline __pure __nonulls size_t __advance(const ring_buffer buf,
+	                                        const size_t index,
+	                                        const size_t n)
 {
-	size_t offset;
-	size_t start;
+	if(__IS_POW2(buf))
+		return index + n;
 
-	/* Doing arithmetic with void pointers is tricksy, even in GNU C.
-	 * Cast all our pointers to size_t integers before doing arithmetic. */
+	return (index + n) % __WRAP(buf);
+}
+
+static inline __pure __nonulls size_t __retreat(const ring_buffer buf,
+	                                        const size_t index,
+	                                        const size_t n)
+{
+	if(__IS_POW2(buf))
+		return index - n;
+
+	return (index + __WRAP(buf) - n) % __WRAP(buf);
+}
+
+static inline __pure __nonulls size_t __distance(const ring_buffer buf,
+	                                         const size_t from,
+	                                         const size_t to)
+{
+	if(__IS_POW2(buf))
+		return to - from;
+
+	return (to + __WRAP(buf) - from) % __WRAP(buf);
+}
+
+static inline __pure __nonulls size_t __position(const ring_buffer buf,
+	                                         const size_t index)
+{
+	if(__IS_POW2(buf))
+		return index & DS_PRIV(buf)->mask;
+
+	return index % __ENTRIES(buf);
+}
+
+static inline __pure __nonulls void * __slot(const ring_buffer buf,
+	                                     const size_t index)
+{
 	size_t data = (size_t) DS_PRIV(buf)->data;
-	size_t head = (size_t) DS_PRIV(buf)->head;
 
-	start = head - data;
-	offset = index * DS_DATA_SIZE(buf);
-	offset = (start + offset) % __SPACE(buf);
-	return (void *) (data + offset);
+	return (void *) (data + __position(buf, index) * DS_DATA_SIZE(buf));
+}
+
+/* The number of blocks that can be addressed contiguously from `index` without
+ * wrapping around the end of the storage.  A mirrored buffer maps its storage
+ * twice back-to-back, so any run of up to `entries` blocks is contiguous. */
+static inline __pure __nonulls size_t __contiguous(const ring_buffer buf,
+	                                           const size_t index)
+{
+	if(DS_MIRROR(buf))
+		return __ENTRIES(buf);
+
+	return __ENTRIES(buf) - __position(buf, index);
+}
+
+static inline __pure __nonulls void * __index_to_addr(const ring_buffer buf,
+	                                              const size_t index)
+{
+	return __slot(buf, DS_PRIV(buf)->head + index);
 }
 
 static inline __pure __nonulls size_t __addr_to_index(const ring_buffer buf,
@@ -68,44 +186,94 @@ static inline __pure __nonulls size_t __addr_to_index(const ring_buffer buf,
 
 	/* Doing arithmetic with void pointers is tricksy, even in GNU C.
 	 * Cast all our pointers to size_t integers before doing arithmetic. */
-	size_t head = (size_t) DS_PRIV(buf)->head;
+	size_t head = (size_t) __HEAD(buf);
 	size_t mark = (size_t) addr;
 
 	offset = mod((ssize_t) (mark - head), (ssize_t) __SPACE(buf));
 	return offset / DS_DATA_SIZE(buf);
 }
 
+/* __prev() and __next() only ever step one block, so wrapping around the end
+ * of the data area is a comparison rather than a division. */
+
 static inline __pure __nonulls void * __prev(const ring_buffer buf,
 	                                     const void * addr)
 {
-	size_t start;
-	size_t offset;
-
 	/* Doing arithmetic with void pointers is tricksy, even in GNU C.
 	 * Cast all our pointers to size_t integers before doing arithmetic. */
 	size_t data = (size_t) DS_PRIV(buf)->data;
 	size_t mark = (size_t) addr;
 
-	start = mark - data;
-	offset = mod((ssize_t) (start - DS_DATA_SIZE(buf)),
-		     (ssize_t) __SPACE(buf));
-	return (void *) (data + offset);
+	if(mark == data)
+		mark += __SPACE(buf);
+
+	return (void *) (mark - DS_DATA_SIZE(buf));
 }
 
 static inline __pure __nonulls void * __next(const ring_buffer buf,
 	                                     const void * addr)
 {
-	size_t start;
-	size_t offset;
-
 	/* Doing arithmetic with void pointers is tricksy, even in GNU C.
 	 * Cast all our pointers to size_t integers before doing arithmetic. */
 	size_t data = (size_t) DS_PRIV(buf)->data;
-	size_t mark = (size_t) addr;
+	size_t mark = (size_t) addr + DS_DATA_SIZE(buf);
+
+	if(mark == data + __SPACE(buf))
+		mark = data;
 
-	start = mark - data;
-	offset = (start + DS_DATA_SIZE(buf)) % __SPACE(buf);
-	return (void *) (data + offset);
+	return (void *) mark;
+}
+
+/* Every change to a locked buffer is made between __writer_entry() and
+ * __writer_exit(), which also bump `seq` for optimistic readers. */
+
+static inline __nonulls void __writer_entry(ring_buffer buf)
+{
+	size_t seq;
+
+	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+
+	seq = __atomic_load_n(&DS_PRIV(buf)->seq, __ATOMIC_RELAXED);
+	__atomic_store_n(&DS_PRIV(buf)->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline __nonulls void __writer_exit(ring_buffer buf)
+{
+	size_t seq;
+
+	/* Operations other than pushing and popping may move the head or tail
+	 * of an SPSC buffer anywhere, so the producer's and consumer's copies
+	 * of each other's index have to catch up. */
+	if(DS_SPSC(buf)) {
+		DS_PRIV(buf)->head_cache = DS_PRIV(buf)->head;
+		DS_PRIV(buf)->tail_cache = DS_PRIV(buf)->tail;
+	}
+
+	seq = __atomic_load_n(&DS_PRIV(buf)->seq, __ATOMIC_RELAXED);
+	__atomic_store_n(&DS_PRIV(buf)->seq, seq + 1, __ATOMIC_RELEASE);
+
+	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+}
+
+/* Wake threads blocked in rb_pop_head_wait() after `count` blocks are stored.
+ * Waking must happen after the buffer's lock is released, since waiters
+ * re-check the buffer's state with the lock.  Buffers that cannot block skip
+ * the wait queue, and with it the full fence in waitq_wake(). */
+static inline __nonulls void __wake_consumers(const ring_buffer buf,
+	                                      const size_t count)
+{
+	if(DS_BLOCKING(buf))
+		waitq_wake(DS_PRIV(buf)->not_empty, count);
+}
+
+/* Wake threads blocked in rb_push_tail_wait() after `count` blocks are
+ * freed. */
+static inline __nonulls void __wake_producers(const ring_buffer buf,
+	                                      const size_t count)
+{
+	if(DS_BLOCKING(buf))
+		waitq_wake(DS_PRIV(buf)->not_full, count);
 }
 
 /**
@@ -181,12 +349,145 @@ static inline __pure __nonulls void * __next(const ring_buffer buf,
  *
  * Allocates and initializes a new ring buffer with the given properties.
  *
+ * If `props->spsc` is set, the buffer is created in single-producer/
+ * single-consumer mode: rb_push_tail() and rb_pop_head() no longer take the
+ * buffer's lock, and instead synchronize through the head and tail indices
+ * using acquire/release atomics.  In this mode, one thread may call
+ * rb_push_tail() while another concurrently calls rb_pop_head(), and either
+ * thread may call rb_size(), rb_empty(), or rb_full().  Every other operation
+ * must not run concurrently with the producer or consumer.  SPSC mode cannot
+ * be combined with `props->overwrite`, since overwriting requires the
+ * producer to move the consumer's head index.
+ *
+ * If `props->entries` is a power of two, indexing into the buffer uses bit
+ * masks instead of division, which makes pushing, popping, and iterating
+ * cheaper; prefer power-of-two capacities for performance-sensitive buffers.
+ *
+ * If `props->mirror` is set, the buffer's storage is mapped twice, back to
+ * back, in virtual memory, so that a run of up to `props->entries` blocks
+ * starting anywhere in the buffer is contiguous.  rb_peek() and rb_reserve()
+ * then always describe a single span, and batch copies never have to be split
+ * at the end of the storage.  The storage size (`props->data_size *
+ * props->entries`) must be a multiple of the system page size.
+ *
+ * If `props->growable` is set, `props->entries` is only the initial capacity:
+ * pushing onto a full buffer doubles its capacity instead of failing, and the
+ * capacity can also be changed explicitly with rb_reserve_capacity() and
+ * rb_shrink_to_fit().  A growable buffer cannot be combined with SPSC mode,
+ * `props->overwrite`, or `props->mirror`.  Since resizing moves the storage,
+ * rb_fetch() and rb_elem() always take the reader lock on a growable buffer.
+ *
+ * If `props->blocking` is set, threads may sleep in rb_pop_head_wait() and
+ * rb_push_tail_wait() until the buffer has data or room.  Every function that
+ * stores or frees blocks then checks for sleeping threads to wake, which costs
+ * a full memory barrier, so leave it unset for buffers that are only polled.
+ *
+ * If `props->path` is set, the buffer's storage and its head and tail indices
+ * are kept in a shared memory mapping of that file, so pushing and popping
+ * are ordinary stores and the contents survive the process exiting or
+ * crashing.  If the file is empty or does not exist, a new empty buffer is
+ * laid out in it; otherwise the buffer left in the file is recovered, and its
+ * data size and capacity must match `props`.  Only one process may have a
+ * buffer file open with rb_create() at a time; other processes can take a
+ * copy of its contents with rb_load().  An operation interrupted by a crash
+ * may leave the blocks it was moving partially written, but the blocks it
+ * was not touching are intact.  A file-backed buffer cannot be combined with
+ * `props->mirror` or `props->growable`.
+ *
+ * If `props->shared` is set, `props->path` instead names a POSIX shared memory
+ * object (see shm_open()), and any number of processes may create ring
+ * buffers on it with the same data size and capacity.  The first one creates
+ * the object and lays out an empty buffer in it; the others attach to that
+ * buffer.  Shared buffers must use SPSC mode: one process may push with
+ * rb_push_tail(), rb_push_tail_n(), or rb_reserve() while another pops with
+ * rb_pop_head(), rb_pop_head_n(), or rb_peek(), each handing over blocks with
+ * a memcpy() into shared memory.  Wait queues cannot be shared between
+ * processes, so a shared buffer cannot be combined with `props->blocking`,
+ * and the consumer must poll instead of calling rb_pop_head_wait().
+ * The object outlives the buffers using it; remove it with shm_unlink().
+ *
  * @return Upon successful completion, rb_create() shall return the newly
  * created ring buffer.  Otherwise, `NULL` shall be returned and `errno` set to
- * indicate the error.
+ * indicate the error.  `EINVAL` indicates that `props->entries` is zero, an
+ * unsupported combination of properties, or a backing file that does not
+ * hold a matching buffer.  `ENOTSUP` indicates that mirrored buffers are not
+ * supported on this system.  `EWOULDBLOCK` indicates that another ring buffer
+ * already has the backing file open.  `EAGAIN` indicates that another process
+ * is still creating the shared memory object `props->path`.  Other errors from
+ * open(), shm_open(), ftruncate(), or mmap() may also be reported.
  */
 ring_buffer __nonulls rb_create(const struct ds_properties * props);
 
+/**
+ * Copy a file-backed ring buffer into a new ring buffer.
+ * @param path  The backing file of the buffer to copy (non-NULL)
+ * @param props The properties of the new buffer (non-NULL)
+ *
+ * Take a consistent copy of the buffer stored in the file at `path`, even while
+ * another process has it open with rb_create(), and push its contents onto a
+ * new, ordinary ring buffer created with `props`.  `props->data_size` and
+ * `props->entries` must match the stored buffer, and `props->path` must not be
+ * set.  The file is never modified.
+ *
+ * @return The new ring buffer.  Otherwise, `NULL` shall be returned and `errno`
+ * set to indicate the error.  `EINVAL` indicates that the file does not hold a
+ * buffer matching `props`.  Other errors from rb_create(), open(), or mmap()
+ * may also be reported.
+ */
+ring_buffer __nonulls rb_load(const char * path,
+	                      const struct ds_properties * props);
+
+/**
+ * Flush a file-backed ring buffer to its backing file.
+ * @param buf The ring buffer to flush (non-NULL)
+ *
+ * Changes to a file-backed buffer survive the process crashing as soon as they
+ * are made, but only survive the system crashing once they have been written
+ * back to the file.  rb_sync() waits until that has happened.  If `buf` is not
+ * file-backed, there is nothing to flush.
+ *
+ * @return `true` on success.  Otherwise, `false` shall be returned and `errno`
+ * set by msync().
+ */
+bool __nonulls rb_sync(const ring_buffer buf);
+
+/**
+ * Grow the storage of a growable ring buffer to hold a number of blocks.
+ * @param buf     The ring buffer to grow (non-NULL)
+ * @param entries The number of data blocks `buf` must be able to hold
+ *
+ * Make sure `buf` can hold at least `entries` data blocks without growing
+ * again.  If `buf` must grow, its contents are moved to new storage with at
+ * most two calls to memcpy().
+ *
+ * @return `true` if `buf` can hold `entries` blocks.  Otherwise, `false` shall
+ * be returned and `errno` set to `EINVAL` if `buf` is not growable, or to
+ * `ENOMEM` if the new storage cannot be allocated.
+ */
+bool __nonulls rb_reserve_capacity(ring_buffer buf, const size_t entries);
+
+/**
+ * Shrink the storage of a growable ring buffer to fit its contents.
+ * @param buf The ring buffer to shrink (non-NULL)
+ *
+ * Reduce the capacity of `buf` to the number of data blocks it currently
+ * holds (but never below one block), releasing the rest of its storage.
+ *
+ * @return `true` on success.  Otherwise, `false` shall be returned and
+ * `errno` set to `EINVAL` if `buf` is not growable, or to `ENOMEM` if the new
+ * storage cannot be allocated.
+ */
+bool __nonulls rb_shrink_to_fit(ring_buffer buf);
+
+/**
+ * Return the current capacity of a ring buffer.
+ * @param buf The ring buffer to query (non-NULL)
+ *
+ * @return The number of data blocks `buf` can hold before it is full, or, if
+ * it is growable, before it next has to grow.
+ */
+size_t __nonulls rb_capacity(const ring_buffer buf);
+
 /**
  * Destroy and deallocate a ring buffer.
  * @param buf A pointer to a `struct ring_buffer` (non-NULL)
@@ -254,6 +555,54 @@ bool __nonulls rb_push_head(ring_buffer buf, const void * data);
  */
 bool __nonulls rb_push_tail(ring_buffer buf, const void * data);
 
+/**
+ * Push an array of data blocks onto the head of a ring buffer.
+ * @param buf   The ring buffer to push onto (non-NULL)
+ * @param data  A pointer to `count` contiguous data blocks
+ * @param count The number of data blocks to push
+ *
+ * Prepend copies of the data blocks in `data` to `buf` as a single run, so
+ * that afterwards `data[0]` is at the head of `buf`, followed by `data[1]`,
+ * and so on, followed by the blocks that were previously in `buf`.  (Note
+ * that this is the reverse of the order produced by calling rb_push_head()
+ * for each block in turn.)  The buffer is locked only once, and the blocks are
+ * copied with at most two calls to memcpy().
+ *
+ * If there is not enough room for all `count` blocks, only the first blocks
+ * that fit are pushed, unless `buf` was created with `overwrite`, in which case
+ * blocks are dropped from the tail of `buf` to make room.
+ *
+ * @return The number of data blocks pushed.
+ */
+size_t __nonulls rb_push_head_n(ring_buffer buf,
+	                        const void * data,
+	                        const size_t count);
+
+/**
+ * Push an array of data blocks onto the tail of a ring buffer.
+ * @param buf   The ring buffer to push onto (non-NULL)
+ * @param data  A pointer to `count` contiguous data blocks
+ * @param count The number of data blocks to push
+ *
+ * Append copies of the data blocks in `data` to the tail of `buf`, in order.
+ * This has the same result as calling rb_push_tail() for each block in turn,
+ * but the buffer is locked only once, and the blocks are copied with at most
+ * two calls to memcpy().
+ *
+ * If there is not enough room for all `count` blocks, only the first blocks
+ * that fit are pushed, unless `buf` was created with `overwrite`, in which case
+ * blocks are dropped from the head of `buf` to make room.
+ *
+ * In SPSC mode, this function may be used by the producer in place of
+ * rb_push_tail(); the pushed blocks become visible to the consumer all at
+ * once.
+ *
+ * @return The number of data blocks pushed.
+ */
+size_t __nonulls rb_push_tail_n(ring_buffer buf,
+	                        const void * data,
+	                        const size_t count);
+
 /**
  * Pop a data element from the head of a ring buffer.
  * @param buf The ring buffer to pop from (non-NULL)
@@ -288,6 +637,226 @@ void * __nonulls rb_pop_head(ring_buffer buf);
  */
 void * __nonulls rb_pop_tail(ring_buffer buf);
 
+/**
+ * Pop several data blocks from the head of a ring buffer.
+ * @param buf   The ring buffer to pop from (non-NULL)
+ * @param data  A pointer to room for `count` contiguous data blocks
+ * @param count The maximum number of data blocks to pop
+ *
+ * Remove up to `count` data blocks from the head of `buf` and copy them into
+ * `data`, in order from the head.  The buffer is locked only once, and the
+ * blocks are copied with at most two calls to memcpy().
+ *
+ * In SPSC mode, this function may be used by the consumer in place of
+ * rb_pop_head().
+ *
+ * @return The number of data blocks popped, which is less than `count` if `buf`
+ * held fewer than `count` blocks.
+ */
+size_t __nonulls rb_pop_head_n(ring_buffer buf,
+	                       void * data,
+	                       const size_t count);
+
+/**
+ * Pop several data blocks from the tail of a ring buffer.
+ * @param buf   The ring buffer to pop from (non-NULL)
+ * @param data  A pointer to room for `count` contiguous data blocks
+ * @param count The maximum number of data blocks to pop
+ *
+ * Remove up to `count` data blocks from the tail of `buf` and copy them into
+ * `data`.  The blocks are stored in the order they appeared in `buf`, so the
+ * block that was at the tail of `buf` is stored last.  The buffer is locked
+ * only once, and the blocks are copied with at most two calls to memcpy().
+ *
+ * @return The number of data blocks popped, which is less than `count` if `buf`
+ * held fewer than `count` blocks.
+ */
+size_t __nonulls rb_pop_tail_n(ring_buffer buf,
+	                       void * data,
+	                       const size_t count);
+
+/**
+ * Reserve space at the tail of a ring buffer to write into directly.
+ * @param buf   The ring buffer to reserve space in (non-NULL)
+ * @param count The maximum number of data blocks to reserve
+ * @param span  Two spans to describe the reserved blocks (non-NULL)
+ *
+ * Find up to `count` free data blocks following the tail of `buf` and describe
+ * them in `span[0]` and, if the reservation wraps around the end of the
+ * buffer's storage, `span[1]`.  The caller may then write its data directly
+ * into the spans, and make it visible with rb_commit().  A reservation never
+ * overwrites stored data, even if `buf` was created with the `overwrite`
+ * property.
+ *
+ * Every call to rb_reserve() must be followed by exactly one call to
+ * rb_commit(), even if no blocks were reserved.  Unless `buf` is in SPSC
+ * mode, `buf` remains locked in between, so the other functions in this API
+ * must not be called on `buf` by the same thread until the reservation has
+ * been committed.  In SPSC mode, only the producer may reserve space.
+ *
+ * @return The number of blocks reserved, which is less than `count` if there
+ * is not enough free space in `buf`.
+ */
+size_t __nonulls rb_reserve(ring_buffer buf,
+	                    const size_t count,
+	                    struct rb_span span[2]);
+
+/**
+ * Commit data written into space reserved by rb_reserve().
+ * @param buf   The ring buffer to commit to (non-NULL)
+ * @param count The number of reserved blocks to commit
+ *
+ * Append the first `count` blocks of the last reservation on `buf` to its
+ * tail.  `count` must not exceed the number of blocks reserved; any reserved
+ * blocks beyond `count` are returned to the free space of `buf`.
+ */
+void __nonulls rb_commit(ring_buffer buf, const size_t count);
+
+/**
+ * Look at the data blocks at the head of a ring buffer in place.
+ * @param buf   The ring buffer to peek into (non-NULL)
+ * @param count The maximum number of data blocks to peek at
+ * @param span  Two spans to describe the blocks (non-NULL)
+ *
+ * Describe up to `count` data blocks starting at the head of `buf` in
+ * `span[0]` and, if they wrap around the end of the buffer's storage,
+ * `span[1]`.  The caller may read the blocks directly out of the spans, and
+ * then remove them from `buf` with rb_release().
+ *
+ * Every call to rb_peek() must be followed by exactly one call to
+ * rb_release(), even if no blocks were found.  The locking rules are the same
+ * as for rb_reserve(); in SPSC mode, only the consumer may peek.
+ *
+ * @return The number of blocks described, which is less than `count` if `buf`
+ * does not contain that many.
+ */
+size_t __nonulls rb_peek(ring_buffer buf,
+	                 const size_t count,
+	                 struct rb_span span[2]);
+
+/**
+ * Release data blocks found by rb_peek().
+ * @param buf   The ring buffer to release from (non-NULL)
+ * @param count The number of blocks to remove from the head of `buf`
+ *
+ * Remove the first `count` blocks found by the last rb_peek() on `buf`.
+ * `count` must not exceed the number of blocks found; any blocks beyond
+ * `count` stay at the head of `buf`.
+ */
+void __nonulls rb_release(ring_buffer buf, const size_t count);
+
+/**
+ * Read data from a file descriptor directly into a ring buffer.
+ * @param buf   The ring buffer to read into (non-NULL)
+ * @param fd    The file descriptor to read from
+ * @param count The maximum number of data blocks to read
+ *
+ * Read up to `count` data blocks' worth of bytes from `fd` with one call to
+ * readv(), straight into the free space after the tail of `buf` (see
+ * rb_reserve()), and append every block that was read completely.  If the
+ * read ends partway through a block, the partial block is kept after the tail
+ * and completed by the next call to rb_read_fd(), so nothing else may push
+ * onto the tail of `buf` in the meantime.
+ *
+ * Unless `buf` is in SPSC mode, `buf` stays locked while readv() runs, so a
+ * blocking `fd` also blocks every other thread using `buf`.  In SPSC mode,
+ * only the producer may call rb_read_fd().
+ *
+ * @return The number of bytes read, which is zero at the end of the file.
+ * Otherwise, -1 shall be returned and `errno` set to `ENOBUFS` if `buf` is
+ * full, or by readv().
+ */
+ssize_t __nonulls rb_read_fd(ring_buffer buf, const int fd, const size_t count);
+
+/**
+ * Write data from a ring buffer directly to a file descriptor.
+ * @param buf   The ring buffer to write from (non-NULL)
+ * @param fd    The file descriptor to write to
+ * @param count The maximum number of data blocks to write
+ *
+ * Write up to `count` data blocks from the head of `buf` to `fd` with one call
+ * to writev(), straight out of the buffer's storage (see rb_peek()), and
+ * remove every block that was written completely.  If the write ends partway
+ * through a block, the block stays at the head of `buf` and the next call to
+ * rb_write_fd() continues where this one stopped, so nothing else may pop
+ * from the head of `buf` in the meantime.
+ *
+ * The locking rules are the same as for rb_read_fd(); in SPSC mode, only the
+ * consumer may call rb_write_fd().
+ *
+ * @return The number of bytes written, which is zero if `buf` is empty.
+ * Otherwise, -1 shall be returned and `errno` set by writev().
+ */
+ssize_t __nonulls rb_write_fd(ring_buffer buf,
+	                      const int fd,
+	                      const size_t count);
+
+/**
+ * Pop a data block from the head of a ring buffer into caller storage.
+ * @param buf  The ring buffer to pop from (non-NULL)
+ * @param data A pointer to room for one data block (non-NULL)
+ *
+ * Remove the data block at the head of `buf` and copy it into `data`.  Unlike
+ * rb_pop_head(), this function never allocates memory.  In SPSC mode, it may
+ * be used by the consumer in place of rb_pop_head().
+ *
+ * @return `true` if a data block was popped, or `false` if `buf` was empty.
+ */
+bool __nonulls rb_pop_head_into(ring_buffer buf, void * data);
+
+/**
+ * Pop a data block from the tail of a ring buffer into caller storage.
+ * @param buf  The ring buffer to pop from (non-NULL)
+ * @param data A pointer to room for one data block (non-NULL)
+ *
+ * Remove the data block at the tail of `buf` and copy it into `data`.  Unlike
+ * rb_pop_tail(), this function never allocates memory.
+ *
+ * @return `true` if a data block was popped, or `false` if `buf` was empty.
+ */
+bool __nonulls rb_pop_tail_into(ring_buffer buf, void * data);
+
+/**
+ * Push a data block to the tail of a ring buffer, waiting for room if needed.
+ * @param buf     The ring buffer to push onto (non-NULL)
+ * @param data    A pointer to the data to push (non-NULL)
+ * @param timeout The longest time to wait, or `NULL` to wait indefinitely
+ *
+ * Push a copy of `data` onto the tail of `buf` like rb_push_tail(), but if
+ * `buf` is full, sleep until another thread frees a block instead of failing.
+ * Every function that removes blocks from `buf` wakes only as many sleeping
+ * pushers as it freed blocks.  In SPSC mode, only the producer may call this.
+ * `buf` must have been created with `props->blocking` set.
+ *
+ * @return `true` if `data` was pushed.  Otherwise, `false` shall be returned
+ * and `errno` set to `ETIMEDOUT` if `timeout` expired first, or to `EINVAL`
+ * if `buf` is not a blocking buffer.
+ */
+bool __nonnull((1, 2)) rb_push_tail_wait(ring_buffer buf,
+	                                 const void * data,
+	                                 const struct timespec * timeout);
+
+/**
+ * Pop a data block from the head of a ring buffer, waiting for one if needed.
+ * @param buf     The ring buffer to pop from (non-NULL)
+ * @param data    A pointer to room for one data block (non-NULL)
+ * @param timeout The longest time to wait, or `NULL` to wait indefinitely
+ *
+ * Pop the data block at the head of `buf` into `data` like
+ * rb_pop_head_into(), but if `buf` is empty, sleep until another thread
+ * stores a block instead of failing.  Every function that stores blocks in
+ * `buf` wakes only as many sleeping poppers as it stored blocks.  In SPSC
+ * mode, only the consumer may call this.  `buf` must have been created with
+ * `props->blocking` set.
+ *
+ * @return `true` if a block was popped into `data`.  Otherwise, `false` shall
+ * be returned and `errno` set to `ETIMEDOUT` if `timeout` expired first, or to
+ * `EINVAL` if `buf` is not a blocking buffer.
+ */
+bool __nonnull((1, 2)) rb_pop_head_wait(ring_buffer buf,
+	                                void * data,
+	                                const struct timespec * timeout);
+
 /**
  * Insert a data block into a ring buffer at a certain position.
  * @param buf  The ring buffer to insert into (non-NULL)
@@ -317,6 +886,21 @@ bool __nonulls rb_insert(ring_buffer buf, const void * data, const ssize_t pos);
  */
 void * __nonulls rb_fetch(const ring_buffer buf, const ssize_t pos);
 
+/**
+ * Copy a data block from a given index of a ring buffer into caller storage.
+ * @param buf  The ring buffer to fetch from (non-NULL)
+ * @param pos  The index to fetch the block from
+ * @param data A pointer to room for one data block (non-NULL)
+ *
+ * Copy the data stored at index `pos` in `buf` into `data`.  Unlike
+ * rb_fetch(), this function never allocates memory.
+ *
+ * @return `true` if a data block was copied, or `false` if `buf` was empty.
+ */
+bool __nonulls rb_fetch_into(const ring_buffer buf,
+	                     const ssize_t pos,
+	                     void * data);
+
 /**
  * Delete a data element from a given index of a ring buffer.
  * @param buf The ring buffer to delete from
@@ -343,6 +927,21 @@ bool __nonulls rb_delete(ring_buffer buf, const ssize_t pos);
  */
 void * __nonulls rb_remove(ring_buffer buf, const ssize_t pos);
 
+/**
+ * Delete a data element from a given index of a ring buffer into caller
+ * storage.
+ * @param buf  The ring buffer to delete from (non-NULL)
+ * @param pos  The index to delete the element at
+ * @param data A pointer to room for one data block (non-NULL)
+ *
+ * Delete the data block stored in `buf` at the index indicated by `pos`, after
+ * copying it into `data`.  Unlike rb_remove(), this function never allocates
+ * memory.
+ *
+ * @return `true` if a data block was removed, or `false` if `buf` was empty.
+ */
+bool __nonulls rb_remove_into(ring_buffer buf, const ssize_t pos, void * data);
+
 /**
  * Reverse the contents of a ring buffer in-place.
  * @param buf The ring buffer to reverse
@@ -352,6 +951,21 @@ void * __nonulls rb_remove(ring_buffer buf, const ssize_t pos);
  */
 bool __nonulls rb_reverse(ring_buffer buf);
 
+/**
+ * Rotate the contents of a ring buffer in-place.
+ * @param buf The ring buffer to rotate (non-NULL)
+ * @param k   The position of the block to rotate to the head of `buf`
+ *
+ * Rotates `buf` so that the data block at position `k` becomes the head, and
+ * the blocks before it follow the old tail in their original order.  As with
+ * rb_fetch(), negative positions count back from the tail, so rotating by -1
+ * moves the tail to the head.
+ *
+ * Rotating a full buffer only moves its head and tail; otherwise at most
+ * every block is moved once or twice, and no memory is allocated.
+ */
+void __nonulls rb_rotate(ring_buffer buf, const ssize_t k);
+
 /* ########################## *
  * # Higher Order Functions # *
  * ########################## */
@@ -471,6 +1085,182 @@ void rb_drop_while(ring_buffer buf, const pred_fn pred);
  */
 void rb_take_while(ring_buffer buf, const pred_fn pred);
 
+/**
+ * Generate a typed interface to ring buffers of a single data type.
+ * @param name The prefix for the generated functions
+ * @param type The type of the data blocks
+ *
+ * A ring buffer only learns its data size at run time, so the generic
+ * functions copy blocks with memcpy() and compute addresses with a variable
+ * stride.  RING_BUFFER_DEFINE() generates static inline functions for
+ * buffers of `type` which use plain assignments and constant strides:
+ * ```
+ * RING_BUFFER_DEFINE(u32_rb, uint32_t)
+ *
+ * ring_buffer buf = u32_rb_create(&props);
+ * u32_rb_push_tail(buf, 42);
+ * ```
+ * The generated functions are:
+ * - `ring_buffer name_create(const struct ds_properties * props)`, which fails
+ *   with `EINVAL` unless `props->data_size` is `sizeof(type)`
+ * - `bool name_push_head(ring_buffer buf, type data)`
+ * - `bool name_push_tail(ring_buffer buf, type data)`
+ * - `bool name_pop_head(ring_buffer buf, type * data)`
+ * - `bool name_pop_tail(ring_buffer buf, type * data)`
+ * - `type * name_head(ring_buffer buf)` and
+ *   `type * name_next(ring_buffer buf, type * current)`, which are used by
+ *   ring_buffer_typed_foreach_i()
+ *
+ * These behave exactly like their generic counterparts, and may be mixed
+ * freely with the rest of the ring buffer API on the same buffer.  Operations
+ * on SPSC or growable buffers are passed to the generic functions.
+ */
+#define RING_BUFFER_DEFINE(name, type)                                        \
+	static inline __unused __nonulls                                      \
+	ring_buffer name##_create(const struct ds_properties * props)         \
+	{                                                                     \
+		if(props->data_size != sizeof(type))                          \
+			return_with_errno(EINVAL, NULL);                      \
+		                                                              \
+		return rb_create(props);                                      \
+	}                                                                     \
+	                                                                      \
+	static inline __unused __pure __nonulls                               \
+	type * name##_slot(const ring_buffer buf, const size_t index)         \
+	{                                                                     \
+		return (type *) DS_PRIV(buf)->data + __position(buf, index);  \
+	}                                                                     \
+	                                                                      \
+	static inline __unused __pure __nonulls                               \
+	type * name##_head(const ring_buffer buf)                             \
+	{                                                                     \
+		return name##_slot(buf, DS_PRIV(buf)->head);                  \
+	}                                                                     \
+	                                                                      \
+	static inline __unused __pure __nonulls                               \
+	type * name##_next(const ring_buffer buf, const type * current)       \
+	{                                                                     \
+		type * data = DS_PRIV(buf)->data;                             \
+		                                                              \
+		if(++current == data + __ENTRIES(buf))                        \
+			return data;                                          \
+		                                                              \
+		return (type *) current;                                      \
+	}                                                                     \
+	                                                                      \
+	static inline __unused __nonulls                                      \
+	bool name##_push_head(ring_buffer buf, const type data)               \
+	{                                                                     \
+		struct ring_buffer_priv * priv = DS_PRIV(buf);                \
+		bool success = false;                                         \
+		                                                              \
+		if(DS_GROWABLE(buf))                                          \
+			return rb_push_head(buf, &data);                      \
+		                                                              \
+		__writer_entry(buf);                                          \
+		if(!__IS_FULL(buf) || DS_OVERWRITE(buf)) {                    \
+			if(__IS_FULL(buf))                                    \
+				priv->tail = __retreat(buf, priv->tail, 1);   \
+			priv->head = __retreat(buf, priv->head, 1);           \
+			*name##_slot(buf, priv->head) = data;                 \
+			success = true;                                       \
+		}                                                             \
+		__writer_exit(buf);                                           \
+		                                                              \
+		__wake_consumers(buf, success);                               \
+		return success;                                               \
+	}                                                                     \
+	                                                                      \
+	static inline __unused __nonulls                                      \
+	bool name##_push_tail(ring_buffer buf, const type data)               \
+	{                                                                     \
+		struct ring_buffer_priv * priv = DS_PRIV(buf);                \
+		bool success = false;                                         \
+		                                                              \
+		if(DS_SPSC(buf) || DS_GROWABLE(buf))                          \
+			return rb_push_tail(buf, &data);                      \
+		                                                              \
+		__writer_entry(buf);                                          \
+		if(!__IS_FULL(buf) || DS_OVERWRITE(buf)) {                    \
+			if(__IS_FULL(buf))                                    \
+				priv->head = __advance(buf, priv->head, 1);   \
+			*name##_slot(buf, priv->tail) = data;                 \
+			priv->tail = __advance(buf, priv->tail, 1);           \
+			success = true;                                       \
+		}                                                             \
+		__writer_exit(buf);                                           \
+		                                                              \
+		__wake_consumers(buf, success);                               \
+		return success;                                               \
+	}                                                                     \
+	                                                                      \
+	static inline __unused __nonulls                                      \
+	bool name##_pop_head(ring_buffer buf, type * data)                    \
+	{                                                                     \
+		struct ring_buffer_priv * priv = DS_PRIV(buf);                \
+		bool success = false;                                         \
+		                                                              \
+		if(DS_SPSC(buf))                                              \
+			return rb_pop_head_into(buf, data);                   \
+		                                                              \
+		__writer_entry(buf);                                          \
+		if(!__IS_EMPTY(buf)) {                                        \
+			*data = *name##_slot(buf, priv->head);                \
+			priv->head = __advance(buf, priv->head, 1);           \
+			success = true;                                       \
+		}                                                             \
+		__writer_exit(buf);                                           \
+		                                                              \
+		__wake_producers(buf, success);                               \
+		return success;                                               \
+	}                                                                     \
+	                                                                      \
+	static inline __unused __nonulls                                      \
+	bool name##_pop_tail(ring_buffer buf, type * data)                    \
+	{                                                                     \
+		struct ring_buffer_priv * priv = DS_PRIV(buf);                \
+		bool success = false;                                         \
+		                                                              \
+		__writer_entry(buf);                                          \
+		if(!__IS_EMPTY(buf)) {                                        \
+			priv->tail = __retreat(buf, priv->tail, 1);           \
+			*data = *name##_slot(buf, priv->tail);                \
+			success = true;                                       \
+		}                                                             \
+		__writer_exit(buf);                                           \
+		                                                              \
+		__wake_producers(buf, success);                               \
+		return success;                                               \
+	}
+
+/**
+ * Advance through a typed ring buffer block by block.
+ * @param name    The prefix passed to RING_BUFFER_DEFINE()
+ * @param buf     The ring buffer to iterate over
+ * @param index   An iteration counter
+ * @param current A `type` pointer that will point to the current data block
+ *
+ * The syntax of ring_buffer_typed_foreach_i() is the same as
+ * ring_buffer_foreach_i(), but steps through the buffer with a constant stride.
+ */
+#define ring_buffer_typed_foreach_i(name, buf, index, current) \
+	for(index = 0, current = name##_head(buf);             \
+	    index < __LENGTH(buf);                             \
+	    index++, current = name##_next(buf, current))
+
+/**
+ * Advance through a typed ring buffer block by block.
+ * @param name    The prefix passed to RING_BUFFER_DEFINE()
+ * @param buf     The ring buffer to iterate over
+ * @param current A `type` pointer that will point to the current data block
+ *
+ * The syntax of ring_buffer_typed_foreach() is the same as
+ * ring_buffer_foreach().
+ */
+#define ring_buffer_typed_foreach(name, buf, current)       \
+	size_t _i;                                          \
+	ring_buffer_typed_foreach_i(name, buf, _i, current)
+
 #ifdef DEBUG
 
 #include <stdio.h>
@@ -20,8 +20,12 @@
 #ifndef __LIST_SINGLE_LIST_H
 #define __LIST_SINGLE_LIST_H
 
+#include <stdalign.h>
+#include <stddef.h>
+
 #include "focs.h"
 #include "focs/ds.h"
+#include "focs/pool.h"
 #include "hof.h"
 #include "linked_list.h"
 #include "sync/rwlock.h"
@@ -34,7 +38,10 @@
  */
 struct sl_element {
 	struct sl_element * next;
-	void * data;
+
+	/* The element's data is stored in the element itself, with the same
+	 * alignment malloc() would give it. */
+	alignas(max_align_t) uint8_t data[];
 };
 
 DS_START(single_list) {
@@ -42,7 +49,18 @@ DS_START(single_list) {
 	struct sl_element * tail;
 	size_t length;
 
+	/* The element most recently reached by its position, and that position,
+	 * so that positional access after it can walk on from there instead of
+	 * from the head.  It is `NULL` when not known, and only one reader at a
+	 * time may use it, while holding `finger_busy`. */
+	struct sl_element * finger;
+	size_t finger_pos;
+	bool finger_busy;
+
 	struct rwlock * rwlock;
+
+	/* Where elements are allocated from, if the list is pooled. */
+	struct pool * pool;
 } DS_END(single_list);
 
 #define __LENGTH(list)   (DS_PRIV(list)->length)
@@ -55,6 +73,13 @@ DS_START(single_list) {
  * Allocates a new singly linked list at the structure pointer pointed to by
  * `list`.
  *
+ * Each element is a single allocation holding its data inline.  If
+ * `props->pooled` is set, elements are allocated from slabs owned by the list
+ * rather than with malloc().  Pushing and popping then reuse freed elements,
+ * the list's memory is released all at once when it is destroyed, and slabs
+ * left empty by sl_filter(), sl_drop_while(), or sl_take_while() are returned
+ * to the system.
+ *
  * @return Upon successful completion, sl_alloc() shall return `0`.  Otherwise,
  * `-1` shall be returned and `errno` set to indicate the error.
  */
@@ -144,6 +169,30 @@ void * __nonulls sl_pop_head(single_list list);
  */
 void * __nonulls sl_pop_tail(single_list list);
 
+/**
+ * Pop a data element from the head of a list into caller storage.
+ * @param list The list to pop from
+ * @param data A pointer to room for one data element
+ *
+ * Remove the data element at the head of `list` and copy it into `data`, so
+ * the caller has nothing to free().
+ *
+ * @return `true` if an element was popped, or `false` if `list` was empty.
+ */
+bool __nonulls sl_pop_head_into(single_list list, void * data);
+
+/**
+ * Pop a data element from the tail of a list into caller storage.
+ * @param list The list to pop from
+ * @param data A pointer to room for one data element
+ *
+ * Remove the data element at the tail of `list` and copy it into `data`, so
+ * the caller has nothing to free().
+ *
+ * @return `true` if an element was popped, or `false` if `list` was empty.
+ */
+bool __nonulls sl_pop_tail_into(single_list list, void * data);
+
 /**
  * Insert a new data element to a given position in a list.
  * @param list The list to inesrt into
@@ -186,13 +235,29 @@ bool __nonulls sl_delete(single_list list, const size_t pos);
  */
 void * __nonulls sl_remove(single_list list, const size_t pos);
 
+/**
+ * Delete a data element from a given position in a list into caller storage.
+ * @param list The list to delete from
+ * @param pos  The position to delete the element at
+ *             (must be an index in the range `0..list->length - 1`)
+ * @param data A pointer to room for one data element
+ *
+ * Delete the data element stored in `list` at the index indicated by `pos`,
+ * after copying it into `data`.
+ *
+ * @return `true` if the deletion succeeds, otherwise `false`.
+ */
+bool __nonulls sl_remove_into(single_list list, const size_t pos, void * data);
+
 /**
  * Fetch a data element from a given position in a list.
  * @param list The list to fetch from
  * @param pos  The index to fetch the element from
  *             (must be an index in the range `0..list->length - 1`)
  *
- * Fetch the data stored at index `pos` in `list`.
+ * Fetch the data stored at index `pos` in `list`.  The list is walked from
+ * the position last looked up if `pos` is not before it, so fetching
+ * positions in ascending order takes constant time per position.
  *
  * @return A pointer to the data at index `pos`, or `NULL` on failure.
  * This pointer should **not** be free()d explicitly, or the list will become
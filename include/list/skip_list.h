@@ -0,0 +1,408 @@
+/* skip_list.h - Indexable Skip List API
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIST_SKIP_LIST_H
+#define __LIST_SKIP_LIST_H
+
+#include <stdalign.h>
+#include <stddef.h>
+
+#include "focs.h"
+#include "focs/ds.h"
+#include "hof.h"
+#include "sync/rwlock.h"
+
+/* The most levels of links a skip list has. */
+#define SK_MAX_LEVEL 32
+
+struct sk_node;
+
+/**
+ * @struct sk_link
+ * Represents one level of links from a skip list node.
+ *
+ * `span` is the number of positions the link moves forward: the position of
+ * `next` minus the position of the node the link belongs to.  A link with no
+ * `next` spans to one past the end of the list.
+ *
+ * This structure is intended for internal use only.
+ */
+struct sk_link {
+	struct sk_node * next;
+	size_t span;
+};
+
+/**
+ * @struct sk_node
+ * Represents an element in a skip list.
+ *
+ * The node's data is stored inline, followed by `levels` links.
+ *
+ * This structure is intended for internal use only.
+ */
+struct sk_node {
+	size_t levels;
+
+	alignas(max_align_t) uint8_t data[];
+};
+
+DS_START(skip_list) {
+	/* The links from the front of the list, at position zero.  The
+	 * elements themselves are at positions `1..length`. */
+	struct sk_link head[SK_MAX_LEVEL];
+
+	/* The number of levels in use. */
+	size_t level;
+	size_t length;
+
+	/* The state of the generator choosing each new node's levels. */
+	uint64_t seed;
+
+	struct rwlock * rwlock;
+} DS_END(skip_list);
+
+/**
+ * Allocate and initialize a new skip list.
+ * @param props The data structure properties
+ *
+ * Allocates a new indexable skip list.  A skip list has the same interface
+ * and ordering semantics as a singly linked list: elements are kept in the
+ * order they are inserted at, not sorted.  Each element also has a random
+ * number of extra links skipping over runs of later elements, which record
+ * how many positions they skip.  This makes sk_insert(), sk_delete(),
+ * sk_remove(), and sk_fetch() take `O(log n)` expected time at any position,
+ * rather than the linear time a linked list needs.
+ *
+ * Elements differ in size, so `props->pooled` is ignored.
+ *
+ * @return Upon successful completion, sk_create() shall return the newly
+ * created list.  Otherwise, `NULL` shall be returned and `errno` set to
+ * indicate the error.
+ */
+skip_list __nonulls sk_create(const struct ds_properties * props);
+
+/**
+ * Destroy and deallocate a skip list.
+ * @param list A pointer to a `skip_list` instance.
+ *
+ * De-allocates the skip list at the structure pointer pointed to by `list`, as
+ * well as de-allocating all data elements contained within `list`.
+ */
+void __nonulls sk_destroy(skip_list * list);
+
+/**
+ * Determine if a list is empty.
+ * @param list The list to check
+ *
+ * @return `true` if `list` is empty, `false` otherwise.
+ */
+bool __nonulls sk_empty(const skip_list list);
+
+/**
+ * Determine the length of a skip list.
+ * @param list The list to measure
+ *
+ * @return The number of data elements stored in `list`.
+ */
+size_t __nonulls sk_size(const skip_list list);
+
+/**
+ * Determine if a list contains a value.
+ * @param list The list to search
+ * @param data The data to search for in the list
+ *
+ * Determines if `list` contains an entry matching `data`.
+ * The operation compares the contents of the memory pointed to by `data`, and
+ * not the memory addresses of the data pointers.
+ *
+ * @return `true` if a matching entry is found, otherwise `false`
+ */
+bool __nonulls sk_elem(const skip_list list, const void * data);
+
+/**
+ * Push a new data element to the head of the list.
+ * @param list The list to push onto
+ * @param data A pointer to the data to push
+ *
+ * Push a newly allocated copy of `data` onto the head of `list`.
+ */
+void __nonulls sk_push_head(skip_list list, const void * data);
+
+/**
+ * Push a new data element to the tail of the list.
+ * @param list The list to push onto
+ * @param data A pointer to the data to push
+ *
+ * Push a newly allocated copy of `data` onto the tail of `list`.
+ */
+void __nonulls sk_push_tail(skip_list list, const void * data);
+
+/**
+ * Pop a data element from the head of a list.
+ * @param list The list to pop from
+ *
+ * Remove and return the data element at the head of `list`.  After this
+ * operation the returned data element *will no longer be stored in* `list`.
+ *
+ * @return A pointer to a copy of the data element at the head of `list`, or
+ * `NULL` if `list` is empty.  This pointer must be explicitly freed with
+ * free() when it is no longer needed.
+ */
+void * __nonulls sk_pop_head(skip_list list);
+
+/**
+ * Pop a data element from the tail of a list.
+ * @param list The list to pop from
+ *
+ * Remove and return the data element at the tail of `list`.  After this
+ * operation the returned data element *will no longer be stored in* `list`.
+ *
+ * @return A pointer to a copy of the data element at the tail of `list`, or
+ * `NULL` if `list` is empty.  This pointer must be explicitly freed with
+ * free() when it is no longer needed.
+ */
+void * __nonulls sk_pop_tail(skip_list list);
+
+/**
+ * Pop a data element from the head of a list into caller storage.
+ * @param list The list to pop from
+ * @param data A pointer to room for one data element
+ *
+ * Remove the data element at the head of `list` and copy it into `data`, so
+ * the caller has nothing to free().
+ *
+ * @return `true` if an element was popped, or `false` if `list` was empty.
+ */
+bool __nonulls sk_pop_head_into(skip_list list, void * data);
+
+/**
+ * Pop a data element from the tail of a list into caller storage.
+ * @param list The list to pop from
+ * @param data A pointer to room for one data element
+ *
+ * Remove the data element at the tail of `list` and copy it into `data`, so
+ * the caller has nothing to free().
+ *
+ * @return `true` if an element was popped, or `false` if `list` was empty.
+ */
+bool __nonulls sk_pop_tail_into(skip_list list, void * data);
+
+/**
+ * Insert a new data element to a given position in a list.
+ * @param list The list to insert into
+ * @param data A pointer to the data to insert
+ * @param pos  The position to insert the element at
+ *             (must be an index in the range `0..list->length`)
+ *
+ * Insert a newly allocated copy of `data` into `list` at the index indicated
+ * by `pos`.
+ *
+ * @return `true` if the insertion succeeds, otherwise `false`.
+ */
+bool __nonulls sk_insert(skip_list list, const void * data, const size_t pos);
+
+/**
+ * Delete a data element from a given position in a list.
+ * @param list The list to delete from
+ * @param pos  The position to delete the element at
+ *             (must be an index in the range `0..list->length - 1`)
+ *
+ * Delete the data element stored in `list` at the index indicated by `pos`.
+ *
+ * @return `true` if the deletion succeeds, otherwise `false`.
+ */
+bool __nonulls sk_delete(skip_list list, const size_t pos);
+
+/**
+ * Delete and return a data element from a given position in a list.
+ * @param list The list to delete from
+ * @param pos  The position to delete the element at
+ *             (must be an index in the range `0..list->length - 1`)
+ *
+ * Delete the data element stored in `list` at the index indicated by `pos`.
+ *
+ * @return A pointer to a copy of the data removed from `list`, or `NULL` on
+ * failure.  This pointer must be explicitly freed with free() when it is no
+ * longer needed.
+ */
+void * __nonulls sk_remove(skip_list list, const size_t pos);
+
+/**
+ * Delete a data element from a given position in a list into caller storage.
+ * @param list The list to delete from
+ * @param pos  The position to delete the element at
+ *             (must be an index in the range `0..list->length - 1`)
+ * @param data A pointer to room for one data element
+ *
+ * Delete the data element stored in `list` at the index indicated by `pos`,
+ * after copying it into `data`.
+ *
+ * @return `true` if the deletion succeeds, otherwise `false`.
+ */
+bool __nonulls sk_remove_into(skip_list list, const size_t pos, void * data);
+
+/**
+ * Fetch a data element from a given position in a list.
+ * @param list The list to fetch from
+ * @param pos  The index to fetch the element from
+ *             (must be an index in the range `0..list->length - 1`)
+ *
+ * Fetch the data stored at index `pos` in `list`.
+ *
+ * @return A pointer to the data at index `pos`, or `NULL` on failure.
+ * This pointer should **not** be free()d explicitly, or the list will become
+ * corrupted.  This pointer will be free()d when sk_destroy() is called, so if
+ * the data is needed after the list is destroyed, make a copy of it, or make
+ * sure to call sk_remove() on the data's index before destroying the list.
+ */
+void * __nonulls sk_fetch(skip_list list, const size_t pos);
+
+/**
+ * Reverse a list in place.
+ * @param list The list to reverse
+ *
+ * Reverses a list in place so that the elements are in reverse order and the
+ * head and tail are switched.
+ */
+void __nonulls sk_reverse(skip_list list);
+
+/* ########################## *
+ * # Higher Order Functions # *
+ * ########################## */
+
+/**
+ * Map a function over a skip list in-place.
+ * @param list A list of values
+ * @param fn A function that will transform each value in the list
+ *
+ * A map operation iterates over `list` and transforms each data element using
+ * the function `fn`, replacing the old value with the result of the
+ * transformation.  In pseudo-code:
+ * ```
+ * for i from 0 to list->length:
+ * 	list[i] = fn(list[i])
+ * ```
+ */
+void __nonulls sk_map(skip_list list, const map_fn fn);
+
+/**
+ * Right associative fold for skip lists.
+ * @param list A list of values to reduce
+ * @param fn A binary function that will sequentially reduce values
+ * @param init An initial value for the fold
+ *
+ * A right associative fold uses the binary function `fn` to sequentially reduce
+ * a list of values to a single value, starting from some initial value `init`:
+ * ```
+ * fn(init, fn(list[0], fn(list[1], ...)))
+ * ```
+ *
+ * @return The result of a right associate fold over `list`.  If `list` is
+ * empty, the fold will be equal to the value of `init`.
+ */
+void * __nonulls sk_foldr(const skip_list list,
+	                  const foldr_fn fn,
+	                  const void * init);
+
+/**
+ * Left associative fold for skip lists.
+ * @param list A list of values to reduce
+ * @param fn A binary function that will sequentially reduce values
+ * @param init An initial value for the fold
+ *
+ * A left associative fold uses the binary function `fn` to sequentially reduce
+ * a list of values to a single value, starting from some initial value `init`:
+ * ```
+ * fn(fn(fn(..., init), list[0]), list[1])
+ * ```
+ *
+ * @return The result of a left associate fold over `list`.  If `list` is
+ * empty, the fold will be equal to the value of `init`.
+ */
+void * __nonulls sk_foldl(const skip_list list,
+	                  const foldl_fn fn,
+	                  const void * init);
+
+/**
+ * Determine if any value in a list satisifies some condition.
+ * @param list A list of values
+ * @param pred The predicate function
+ *
+ * Iterate over each value stored in `list`, and determine if any of them
+ * satisfies `pred`.
+ *
+ * @return This function shall return `true` if the predicate `pred` is
+ * satisfied by any data element in `list`; otherwise `false` shall be returned.
+ */
+bool __nonulls sk_any(skip_list list, const pred_fn pred);
+
+/**
+ * Determines if all values in a list satisify some condition
+ * @param list A list of values
+ * @param pred The predicate function (representing a condition to be
+ *             satisfied).
+ *
+ * Iterate over each value stored in `list`, and determine if all of them
+ * satisfy `pred`.
+ *
+ * @return This function shall return `true` if the predicate `pred` is
+ * satisfied by all data elements in `list`; otherwise `false` shall be
+ * returned.
+ */
+bool __nonulls sk_all(skip_list list, const pred_fn pred);
+
+/**
+ * Filter a list to contain only values that satisfy some predicate.
+ * @param list The list to filter
+ * @param pred The predicate
+ *
+ * Filter `list` in-place by removing elements that do not satisfy the
+ * predicate `pred`.  Elements that do satisfy the predicate `pred` are not
+ * removed from the list.
+ */
+bool __nonulls sk_filter(skip_list list, const pred_fn pred);
+
+/**
+ * Drop elements from the head of the list until the predicate is unsatisfied.
+ * @param list The list to drop from
+ * @param pred The predicate
+ *
+ * Drop each element that satisfies the predicate `pred`, starting at the
+ * beginning of `list` and continuing until reaching the first element that does
+ * not satisfy the predicate `pred`.
+ *
+ * This function is an in-place equivalent of Haskell's dropWhile.
+ */
+bool __nonulls sk_drop_while(skip_list list, const pred_fn pred);
+
+/**
+ * Keep elements from the head of the list until the predicate is unsatisfied.
+ * @param list The list to take from
+ * @param pred The predicate
+ *
+ * Iterate over each element of `list`, starting at the beginning, that
+ * satisfies the predicate `pred`.  Once an element that does not satisfy the
+ * predicate `pred` is reached, drop the rest of the list, including that
+ * element.
+ *
+ * This function is an in-place equivalent of Haskell's takeWhile.
+ */
+bool __nonulls sk_take_while(skip_list list, const pred_fn pred);
+
+#endif /* __LIST_SKIP_LIST_H */
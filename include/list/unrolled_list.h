@@ -0,0 +1,402 @@
+/* unrolled_list.h - Unrolled Linked List API
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LIST_UNROLLED_LIST_H
+#define __LIST_UNROLLED_LIST_H
+
+#include <stdalign.h>
+#include <stddef.h>
+
+#include "focs.h"
+#include "focs/ds.h"
+#include "focs/pool.h"
+#include "hof.h"
+#include "linked_list.h"
+#include "sync/rwlock.h"
+
+/* The fewest data elements a node holds, however large the elements are. */
+#define UL_MIN_CAPACITY 2
+
+/**
+ * @struct ul_node
+ * Represents a node in an unrolled linked list.
+ *
+ * Each node holds up to the list's `capacity` data elements, packed together
+ * at the start of `data`.
+ *
+ * This structure is intended for internal use only.
+ */
+struct ul_node {
+	struct ul_node * next;
+	size_t count;
+
+	alignas(max_align_t) uint8_t data[];
+};
+
+DS_START(unrolled_list) {
+	struct ul_node * head;
+	struct ul_node * tail;
+	size_t length;
+
+	/* The number of data elements that fit in one node. */
+	size_t capacity;
+
+	struct rwlock * rwlock;
+
+	/* Where nodes are allocated from, if the list is pooled. */
+	struct pool * pool;
+} DS_END(unrolled_list);
+
+/**
+ * Allocate and initialize a new unrolled linked list.
+ * @param props The data structure properties
+ *
+ * Allocates a new unrolled linked list.  An unrolled list has the same
+ * interface and ordering semantics as a singly linked list, but each node
+ * holds a cache line's worth of data elements (and at least
+ * `UL_MIN_CAPACITY` of them) in an array.  For small elements, this saves
+ * most of the per-element pointer and allocation overhead, and iterating over
+ * the list walks through memory a cache line at a time instead of following a
+ * pointer for every element.
+ *
+ * If `props->pooled` is set, nodes are allocated from slabs owned by the list
+ * rather than with malloc().
+ *
+ * @return Upon successful completion, ul_create() shall return the newly
+ * created list.  Otherwise, `NULL` shall be returned and `errno` set to
+ * indicate the error.
+ */
+unrolled_list __nonulls ul_create(const struct ds_properties * props);
+
+/**
+ * Destroy and deallocate an unrolled linked list.
+ * @param list A pointer to an `unrolled_list` instance.
+ *
+ * De-allocates the unrolled linked list at the structure pointer pointed to by
+ * `list`, as well as de-allocating all data elements contained within `list`.
+ */
+void __nonulls ul_destroy(unrolled_list * list);
+
+/**
+ * Determine if a list is empty.
+ * @param list The list to check
+ *
+ * @return `true` if `list` is empty, `false` otherwise.
+ */
+bool __nonulls ul_empty(const unrolled_list list);
+
+/**
+ * Determine the length of an unrolled linked list.
+ * @param list The list to measure
+ *
+ * @return The number of data elements stored in `list`.
+ */
+size_t __nonulls ul_size(const unrolled_list list);
+
+/**
+ * Determine if a list contains a value.
+ * @param list The list to search
+ * @param data The data to search for in the list
+ *
+ * Determines if `list` contains an entry matching `data`.
+ * The operation compares the contents of the memory pointed to by `data`, and
+ * not the memory addresses of the data pointers.
+ *
+ * @return `true` if a matching entry is found, otherwise `false`
+ */
+bool __nonulls ul_elem(const unrolled_list list, const void * data);
+
+/**
+ * Push a new data element to the head of the list.
+ * @param list The list to push onto
+ * @param data A pointer to the data to push
+ *
+ * Push a copy of `data` onto the head of `list`.
+ */
+void __nonulls ul_push_head(unrolled_list list, const void * data);
+
+/**
+ * Push a new data element to the tail of the list.
+ * @param list The list to push onto
+ * @param data A pointer to the data to push
+ *
+ * Push a copy of `data` onto the tail of `list`.
+ */
+void __nonulls ul_push_tail(unrolled_list list, const void * data);
+
+/**
+ * Pop a data element from the head of a list.
+ * @param list The list to pop from
+ *
+ * Remove and return the data element at the head of `list`.  After this
+ * operation the returned data element *will no longer be stored in* `list`.
+ *
+ * @return A pointer to a copy of the data element at the head of `list`, or
+ * `NULL` if `list` is empty.  This pointer must be explicitly freed with
+ * free() when it is no longer needed.
+ */
+void * __nonulls ul_pop_head(unrolled_list list);
+
+/**
+ * Pop a data element from the tail of a list.
+ * @param list The list to pop from
+ *
+ * Remove and return the data element at the tail of `list`.  After this
+ * operation the returned data element *will no longer be stored in* `list`.
+ *
+ * @return A pointer to a copy of the data element at the tail of `list`, or
+ * `NULL` if `list` is empty.  This pointer must be explicitly freed with
+ * free() when it is no longer needed.
+ */
+void * __nonulls ul_pop_tail(unrolled_list list);
+
+/**
+ * Pop a data element from the head of a list into caller storage.
+ * @param list The list to pop from
+ * @param data A pointer to room for one data element
+ *
+ * Remove the data element at the head of `list` and copy it into `data`, so
+ * the caller has nothing to free().
+ *
+ * @return `true` if an element was popped, or `false` if `list` was empty.
+ */
+bool __nonulls ul_pop_head_into(unrolled_list list, void * data);
+
+/**
+ * Pop a data element from the tail of a list into caller storage.
+ * @param list The list to pop from
+ * @param data A pointer to room for one data element
+ *
+ * Remove the data element at the tail of `list` and copy it into `data`, so
+ * the caller has nothing to free().
+ *
+ * @return `true` if an element was popped, or `false` if `list` was empty.
+ */
+bool __nonulls ul_pop_tail_into(unrolled_list list, void * data);
+
+/**
+ * Insert a new data element to a given position in a list.
+ * @param list The list to insert into
+ * @param data A pointer to the data to insert
+ * @param pos  The position to insert the element at
+ *             (must be an index in the range `0..list->length`)
+ *
+ * Insert a copy of `data` into `list` at the index indicated by `pos`.  If
+ * the node that position falls in is full, half of its elements are moved to
+ * a new node first.
+ *
+ * @return `true` if the insertion succeeds, otherwise `false`.
+ */
+bool __nonulls ul_insert(unrolled_list list,
+	                 const void * data,
+	                 const size_t pos);
+
+/**
+ * Delete a data element from a given position in a list.
+ * @param list The list to delete from
+ * @param pos  The position to delete the element at
+ *             (must be an index in the range `0..list->length - 1`)
+ *
+ * Delete the data element stored in `list` at the index indicated by `pos`.
+ * A node left less than half full is merged with the next node when their
+ * elements fit in one node.
+ *
+ * @return `true` if the deletion succeeds, otherwise `false`.
+ */
+bool __nonulls ul_delete(unrolled_list list, const size_t pos);
+
+/**
+ * Delete and return a data element from a given position in a list.
+ * @param list The list to delete from
+ * @param pos  The position to delete the element at
+ *             (must be an index in the range `0..list->length - 1`)
+ *
+ * Delete the data element stored in `list` at the index indicated by `pos`.
+ *
+ * @return A pointer to a copy of the data removed from `list`, or `NULL` on
+ * failure.  This pointer must be explicitly freed with free() when it is no
+ * longer needed.
+ */
+void * __nonulls ul_remove(unrolled_list list, const size_t pos);
+
+/**
+ * Delete a data element from a given position in a list into caller storage.
+ * @param list The list to delete from
+ * @param pos  The position to delete the element at
+ *             (must be an index in the range `0..list->length - 1`)
+ * @param data A pointer to room for one data element
+ *
+ * Delete the data element stored in `list` at the index indicated by `pos`,
+ * after copying it into `data`.
+ *
+ * @return `true` if the deletion succeeds, otherwise `false`.
+ */
+bool __nonulls ul_remove_into(unrolled_list list,
+	                      const size_t pos,
+	                      void * data);
+
+/**
+ * Fetch a data element from a given position in a list.
+ * @param list The list to fetch from
+ * @param pos  The index to fetch the element from
+ *             (must be an index in the range `0..list->length - 1`)
+ *
+ * Fetch the data stored at index `pos` in `list`.
+ *
+ * @return A pointer to the data at index `pos`, or `NULL` on failure.
+ * This pointer should **not** be free()d explicitly.  Unlike sl_fetch(),
+ * elements share their node with their neighbours and are moved when the
+ * list is modified, so the pointer is only valid until the next operation
+ * that adds or removes an element of `list`.
+ */
+void * __nonulls ul_fetch(unrolled_list list, const size_t pos);
+
+/**
+ * Reverse a list in place.
+ * @param list The list to reverse
+ *
+ * Reverses a list in place so that the elements are in reverse order and the
+ * head and tail are switched.
+ */
+void __nonulls ul_reverse(unrolled_list list);
+
+/* ########################## *
+ * # Higher Order Functions # *
+ * ########################## */
+
+/**
+ * Map a function over an unrolled linked list in-place.
+ * @param list A list of values
+ * @param fn A function that will transform each value in the list
+ *
+ * A map operation iterates over `list` and transforms each data element using
+ * the function `fn`, replacing the old value with the result of the
+ * transformation.  In pseudo-code:
+ * ```
+ * for i from 0 to list->length:
+ * 	list[i] = fn(list[i])
+ * ```
+ */
+void __nonulls ul_map(unrolled_list list, const map_fn fn);
+
+/**
+ * Right associative fold for unrolled linked lists.
+ * @param list A list of values to reduce
+ * @param fn A binary function that will sequentially reduce values
+ * @param init An initial value for the fold
+ *
+ * A right associative fold uses the binary function `fn` to sequentially reduce
+ * a list of values to a single value, starting from some initial value `init`:
+ * ```
+ * fn(init, fn(list[0], fn(list[1], ...)))
+ * ```
+ *
+ * @return The result of a right associate fold over `list`.  If `list` is
+ * empty, the fold will be equal to the value of `init`.
+ */
+void * __nonulls ul_foldr(const unrolled_list list,
+	                  const foldr_fn fn,
+	                  const void * init);
+
+/**
+ * Left associative fold for unrolled linked lists.
+ * @param list A list of values to reduce
+ * @param fn A binary function that will sequentially reduce values
+ * @param init An initial value for the fold
+ *
+ * A left associative fold uses the binary function `fn` to sequentially reduce
+ * a list of values to a single value, starting from some initial value `init`:
+ * ```
+ * fn(fn(fn(..., init), list[0]), list[1])
+ * ```
+ *
+ * @return The result of a left associate fold over `list`.  If `list` is
+ * empty, the fold will be equal to the value of `init`.
+ */
+void * __nonulls ul_foldl(const unrolled_list list,
+	                  const foldl_fn fn,
+	                  const void * init);
+
+/**
+ * Determine if any value in a list satisifies some condition.
+ * @param list A list of values
+ * @param pred The predicate function
+ *
+ * Iterate over each value stored in `list`, and determine if any of them
+ * satisfies `pred`.
+ *
+ * @return This function shall return `true` if the predicate `pred` is
+ * satisfied by any data element in `list`; otherwise `false` shall be returned.
+ */
+bool __nonulls ul_any(unrolled_list list, const pred_fn pred);
+
+/**
+ * Determines if all values in a list satisify some condition
+ * @param list A list of values
+ * @param pred The predicate function (representing a condition to be
+ *             satisfied).
+ *
+ * Iterate over each value stored in `list`, and determine if all of them
+ * satisfy `pred`.
+ *
+ * @return This function shall return `true` if the predicate `pred` is
+ * satisfied by all data elements in `list`; otherwise `false` shall be
+ * returned.
+ */
+bool __nonulls ul_all(unrolled_list list, const pred_fn pred);
+
+/**
+ * Filter a list to contain only values that satisfy some predicate.
+ * @param list The list to filter
+ * @param pred The predicate
+ *
+ * Filter `list` in-place by removing elements that do not satisfy the
+ * predicate `pred`.  The remaining elements are packed into as few nodes as
+ * possible, and the nodes left over are freed.
+ */
+bool __nonulls ul_filter(unrolled_list list, const pred_fn pred);
+
+/**
+ * Drop elements from the head of the list until the predicate is unsatisfied.
+ * @param list The list to drop from
+ * @param pred The predicate
+ *
+ * Drop each element that satisfies the predicate `pred`, starting at the
+ * beginning of `list` and continuing until reaching the first element that does
+ * not satisfy the predicate `pred`.
+ *
+ * This function is an in-place equivalent of Haskell's dropWhile.
+ */
+bool __nonulls ul_drop_while(unrolled_list list, const pred_fn pred);
+
+/**
+ * Keep elements from the head of the list until the predicate is unsatisfied.
+ * @param list The list to take from
+ * @param pred The predicate
+ *
+ * Iterate over each element of `list`, starting at the beginning, that
+ * satisfies the predicate `pred`.  Once an element that does not satisfy the
+ * predicate `pred` is reached, drop the rest of the list, including that
+ * element.
+ *
+ * This function is an in-place equivalent of Haskell's takeWhile.
+ */
+bool __nonulls ul_take_while(unrolled_list list, const pred_fn pred);
+
+#endif /* __LIST_UNROLLED_LIST_H */
@@ -0,0 +1,52 @@
+/* waitq.h - Wait Queue Interface
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __WAITQ_H
+#define __WAITQ_H
+
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "focs.h"
+#include "hof.h"
+
+/* A wait queue parks threads until a condition on some other data structure
+ * becomes true.  The condition is changed without holding `lock`; waiters
+ * register themselves in `waiters` before re-checking it, and wakers only
+ * touch `lock` if `waiters` is non-zero, so an uncontended wake is a fence and
+ * a load. */
+struct waitq {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	size_t waiters;
+};
+
+struct waitq * waitq_create(void);
+void waitq_destroy(struct waitq ** waitq);
+bool waitq_wait(struct waitq * waitq,
+                const pred_fn ready,
+                const void * arg,
+                const struct timespec * deadline);
+void waitq_wake(struct waitq * waitq, const size_t count);
+void waitq_deadline(struct timespec * deadline,
+                    const struct timespec * timeout);
+
+#endif /* __WAITQ_H */
@@ -0,0 +1,191 @@
+/* block.c - Data Block Swapping and Reversal Kernels
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "focs/block.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+#define __X86_SIMD
+#endif
+
+/* Swap block `i` of `lo` with block `count - 1 - i` of `hi`, for `i` in
+ * [`start`, `count`), moving each block as one `type`. */
+#define __SWAP_REVERSE_AS(type, lo, hi, start, count)             \
+	do {                                                      \
+		type __a;                                         \
+		type __b;                                         \
+		type * __lo = (type *) (lo);                      \
+		type * __hi = (type *) (hi) + (count) - 1;        \
+		                                                  \
+		for(size_t __i = (start); __i < (count); __i++) { \
+			memcpy(&__a, __lo + __i, sizeof(type));   \
+			memcpy(&__b, __hi - __i, sizeof(type));   \
+			memcpy(__lo + __i, &__b, sizeof(type));   \
+			memcpy(__hi - __i, &__a, sizeof(type));   \
+		}                                                 \
+	} while(0)
+
+static void __swap_reverse_scalar(uint8_t * lo,
+	                          uint8_t * hi,
+	                          const size_t start,
+	                          const size_t count,
+	                          const size_t size)
+{
+	switch(size) {
+	case 1:
+		__SWAP_REVERSE_AS(uint8_t, lo, hi, start, count);
+		break;
+	case 2:
+		__SWAP_REVERSE_AS(uint16_t, lo, hi, start, count);
+		break;
+	case 4:
+		__SWAP_REVERSE_AS(uint32_t, lo, hi, start, count);
+		break;
+	case 8:
+		__SWAP_REVERSE_AS(uint64_t, lo, hi, start, count);
+		break;
+	default:
+		for(size_t i = start; i < count; i++)
+			mem_swap(lo + i * size,
+			         hi + (count - 1 - i) * size,
+			         size);
+	}
+}
+
+#ifdef __X86_SIMD
+
+/* The vector kernels take one vector from the front of `lo` and one from the
+ * back of `hi`, reverse the order of the blocks inside each, and store each
+ * in the other's place.  Since the vector width is a multiple of every
+ * supported size, blocks never straddle two vectors; whatever is left in the
+ * middle is swapped by the scalar kernel. */
+
+__attribute__((target("sse2")))
+static inline __m128i __reverse_sse2(__m128i v, const size_t size)
+{
+	switch(size) {
+	case 1:
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		/* fall through */
+	case 2:
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+		v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+		return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+	case 4:
+		return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+	default:
+		return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+	}
+}
+
+__attribute__((target("sse2")))
+static void __swap_reverse_sse2(uint8_t * lo,
+	                        uint8_t * hi,
+	                        const size_t count,
+	                        const size_t size)
+{
+	size_t offset;
+	size_t bytes = count * size;
+	uint8_t * mirror;
+	__m128i a;
+	__m128i b;
+
+	for(offset = 0; offset + sizeof(a) <= bytes; offset += sizeof(a)) {
+		mirror = hi + bytes - offset - sizeof(b);
+		a = _mm_loadu_si128((const __m128i *) (lo + offset));
+		b = _mm_loadu_si128((const __m128i *) mirror);
+		_mm_storeu_si128((__m128i *) (lo + offset),
+		                 __reverse_sse2(b, size));
+		_mm_storeu_si128((__m128i *) mirror, __reverse_sse2(a, size));
+	}
+
+	__swap_reverse_scalar(lo, hi, offset / size, count, size);
+}
+
+/* AVX2 byte shuffles only work within each 128-bit lane, so blocks are
+ * reversed inside the lanes and then the two lanes are exchanged. */
+__attribute__((target("avx2")))
+static inline __m256i __reverse_avx2(__m256i v, const __m256i order)
+{
+	return _mm256_permute4x64_epi64(_mm256_shuffle_epi8(v, order),
+	                                _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+__attribute__((target("avx2")))
+static void __swap_reverse_avx2(uint8_t * lo,
+	                        uint8_t * hi,
+	                        const size_t count,
+	                        const size_t size)
+{
+	size_t offset;
+	size_t bytes = count * size;
+	uint8_t order[32];
+	uint8_t * mirror;
+	__m256i shuffle;
+	__m256i a;
+	__m256i b;
+
+	/* Byte `i` of each reversed lane comes from the same byte of the
+	 * mirrored block. */
+	for(size_t i = 0; i < sizeof(order); i++)
+		order[i] = (15 - i % 16) / size * size + i % size;
+	shuffle = _mm256_loadu_si256((const __m256i *) order);
+
+	for(offset = 0; offset + sizeof(a) <= bytes; offset += sizeof(a)) {
+		mirror = hi + bytes - offset - sizeof(b);
+		a = _mm256_loadu_si256((const __m256i *) (lo + offset));
+		b = _mm256_loadu_si256((const __m256i *) mirror);
+		_mm256_storeu_si256((__m256i *) (lo + offset),
+		                    __reverse_avx2(b, shuffle));
+		_mm256_storeu_si256((__m256i *) mirror,
+		                    __reverse_avx2(a, shuffle));
+	}
+
+	__swap_reverse_scalar(lo, hi, offset / size, count, size);
+}
+
+#endif /* __X86_SIMD */
+
+void mem_swap_reverse(void * lo,
+	              void * hi,
+	              const size_t count,
+	              const size_t size)
+{
+	switch(size) {
+	case 1:
+	case 2:
+	case 4:
+	case 8:
+#ifdef __X86_SIMD
+		if(__builtin_cpu_supports("avx2")) {
+			__swap_reverse_avx2(lo, hi, count, size);
+			return;
+		}
+		if(__builtin_cpu_supports("sse2")) {
+			__swap_reverse_sse2(lo, hi, count, size);
+			return;
+		}
+#endif
+		/* fall through */
+	default:
+		__swap_reverse_scalar(lo, hi, 0, count, size);
+	}
+}
@@ -0,0 +1,198 @@
+/* pool.c - Fixed-Size Object Pool Implementation
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdalign.h>
+#include <sys/mman.h>
+
+#include "focs/pool.h"
+
+/* The usual slab size, which holds a few thousand small list elements. */
+#define POOL_SLAB_SIZE  65536
+
+/* Larger objects get slabs big enough for at least this many of them. */
+#define POOL_SLAB_MIN_OBJECTS 16
+
+#define POOL_ALIGN alignof(max_align_t)
+
+#define __round_up(n, align) (((n) + (align) - 1) / (align) * (align))
+
+static inline __nonulls struct pool_slab * __slab_of(const struct pool * pool,
+	                                             const void * object)
+{
+	return (struct pool_slab *) ((size_t) object & ~(pool->slab_size - 1));
+}
+
+static inline __nonulls void * __object(const struct pool * pool,
+	                                const struct pool_slab * slab,
+	                                const size_t index)
+{
+	size_t first = __round_up(sizeof(*slab), POOL_ALIGN);
+
+	return (void *) ((size_t) slab + first + index * pool->object_size);
+}
+
+static inline __nonulls void * __next_free(const void * object)
+{
+	return *(void * const *) object;
+}
+
+/* Map a slab aligned to its own size.  Twice the size is mapped and the
+ * excess on either side unmapped, since aligned_alloc() would keep the
+ * padding it needs for alignment resident next to every slab. */
+static __nonulls struct pool_slab * __map_slab(const struct pool * pool)
+{
+	uint8_t * base;
+	uint8_t * slab;
+	size_t size = pool->slab_size;
+
+	base = mmap(NULL, 2 * size, PROT_READ | PROT_WRITE,
+	            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(base == MAP_FAILED)
+		return_with_errno(ENOMEM, NULL);
+
+	slab = (uint8_t *) __round_up((size_t) base, size);
+	if(slab > base)
+		munmap(base, slab - base);
+	munmap(slab + size, base + size - slab);
+
+	return (struct pool_slab *) slab;
+}
+
+static inline __nonulls void __unmap_slab(const struct pool * pool,
+	                                  struct pool_slab * slab)
+{
+	munmap(slab, pool->slab_size);
+}
+
+/* Add a new slab to `pool`, putting its objects on the free list so that
+ * they are handed out in address order. */
+static __nonulls bool __add_slab(struct pool * pool)
+{
+	struct pool_slab * slab;
+	void * object;
+
+	slab = __map_slab(pool);
+	if(!slab)
+		return false;
+
+	slab->used  = 0;
+	slab->next  = pool->slabs;
+	pool->slabs = slab;
+
+	for(size_t i = pool->per_slab; i > 0; i--) {
+		object = __object(pool, slab, i - 1);
+		*(void **) object = pool->free;
+		pool->free = object;
+	}
+
+	return true;
+}
+
+struct pool * pool_create(const size_t object_size)
+{
+	struct pool * pool;
+	size_t header;
+	size_t needed;
+
+	malloc_rof(pool, sizeof(*pool), NULL);
+
+	/* Free objects hold the free list's links. */
+	pool->object_size = __round_up(MAX(object_size, sizeof(void *)),
+	                               POOL_ALIGN);
+
+	header = __round_up(sizeof(struct pool_slab), POOL_ALIGN);
+	needed = header + POOL_SLAB_MIN_OBJECTS * pool->object_size;
+
+	pool->slab_size = POOL_SLAB_SIZE;
+	while(pool->slab_size < needed)
+		pool->slab_size <<= 1;
+
+	pool->per_slab = (pool->slab_size - header) / pool->object_size;
+	pool->slabs    = NULL;
+	pool->free     = NULL;
+
+	return pool;
+}
+
+void pool_destroy(struct pool ** pool)
+{
+	struct pool_slab * slab;
+	struct pool_slab * next;
+
+	for(slab = (*pool)->slabs; slab; slab = next) {
+		next = slab->next;
+		__unmap_slab(*pool, slab);
+	}
+
+	free_null(*pool);
+}
+
+void * pool_alloc(struct pool * pool)
+{
+	void * object;
+
+	if(!pool->free && !__add_slab(pool))
+		return NULL;
+
+	object     = pool->free;
+	pool->free = __next_free(object);
+	__slab_of(pool, object)->used++;
+
+	return object;
+}
+
+void pool_free(struct pool * pool, void * object)
+{
+	__slab_of(pool, object)->used--;
+
+	*(void **) object = pool->free;
+	pool->free = object;
+}
+
+size_t pool_trim(struct pool * pool)
+{
+	size_t trimmed = 0;
+	void ** link;
+	struct pool_slab ** slab;
+	struct pool_slab * empty;
+
+	/* Drop the empty slabs' objects from the free list first, since the
+	 * links are stored inside the slabs. */
+	for(link = &pool->free; *link;) {
+		if(__slab_of(pool, *link)->used == 0)
+			*link = __next_free(*link);
+		else
+			link = *link;
+	}
+
+	for(slab = &pool->slabs; *slab;) {
+		if((*slab)->used > 0) {
+			slab = &(*slab)->next;
+			continue;
+		}
+
+		empty = *slab;
+		*slab = empty->next;
+		__unmap_slab(pool, empty);
+		trimmed++;
+	}
+
+	return trimmed;
+}
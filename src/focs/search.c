@@ -0,0 +1,167 @@
+/* search.c - Data Block Search Kernels
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "focs/search.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+#define __X86_SIMD
+#endif
+
+static size_t __find_scalar(const uint8_t * base,
+	                    const size_t count,
+	                    const size_t size,
+	                    const uint8_t * key)
+{
+	for(size_t i = 0; i < count; i++)
+		if(mem_eq(base + i * size, key, size))
+			return i;
+
+	return count;
+}
+
+#ifdef __X86_SIMD
+
+/* The vector kernels compare bytes, giving a mask with one bit per byte.  A
+ * block matches if all of its bits are set; folding the mask `log2(size)`
+ * times leaves that result in the bit for the first byte of each block, and
+ * `__first_bits()` selects those bits.  Since the vector width is a multiple
+ * of every supported size, blocks never straddle two vectors. */
+
+static inline uint32_t __first_bits(const size_t size, const size_t width)
+{
+	uint32_t bits = 0;
+
+	for(size_t i = 0; i < width; i += size)
+		bits |= (uint32_t) 1 << i;
+
+	return bits;
+}
+
+static inline uint32_t __fold(uint32_t mask,
+	                      const size_t size,
+	                      const uint32_t first)
+{
+	for(size_t shift = 1; shift < size; shift <<= 1)
+		mask &= mask >> shift;
+
+	return mask & first;
+}
+
+static inline void __repeat(uint8_t * pattern,
+	                    const size_t width,
+	                    const size_t size,
+	                    const uint8_t * key)
+{
+	for(size_t i = 0; i < width; i += size)
+		memcpy(pattern + i, key, size);
+}
+
+__attribute__((target("sse2")))
+static size_t __find_sse2(const uint8_t * base,
+	                  const size_t count,
+	                  const size_t size,
+	                  const uint8_t * key)
+{
+	size_t offset;
+	size_t bytes = count * size;
+	uint8_t pattern[16];
+	const size_t step = sizeof(pattern);
+	uint32_t first;
+	uint32_t mask;
+	__m128i needle;
+	__m128i block;
+
+	__repeat(pattern, step, size, key);
+	needle = _mm_loadu_si128((const __m128i *) pattern);
+	first  = __first_bits(size, step);
+
+	for(offset = 0; offset + step <= bytes; offset += step) {
+		block = _mm_loadu_si128((const __m128i *) (base + offset));
+		mask  = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+		mask  = __fold(mask, size, first);
+		if(mask)
+			return (offset + __builtin_ctz(mask)) / size;
+	}
+
+	return offset / size + __find_scalar(base + offset,
+	                                     count - offset / size,
+	                                     size,
+	                                     key);
+}
+
+__attribute__((target("avx2")))
+static size_t __find_avx2(const uint8_t * base,
+	                  const size_t count,
+	                  const size_t size,
+	                  const uint8_t * key)
+{
+	size_t offset;
+	size_t bytes = count * size;
+	uint8_t pattern[32];
+	const size_t step = sizeof(pattern);
+	uint32_t first;
+	uint32_t mask;
+	__m256i needle;
+	__m256i block;
+
+	__repeat(pattern, step, size, key);
+	needle = _mm256_loadu_si256((const __m256i *) pattern);
+	first  = __first_bits(size, step);
+
+	for(offset = 0; offset + step <= bytes; offset += step) {
+		block = _mm256_loadu_si256((const __m256i *) (base + offset));
+		mask  = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+		mask  = __fold(mask, size, first);
+		if(mask)
+			return (offset + __builtin_ctz(mask)) / size;
+	}
+
+	return offset / size + __find_scalar(base + offset,
+	                                     count - offset / size,
+	                                     size,
+	                                     key);
+}
+
+#endif /* __X86_SIMD */
+
+size_t mem_find(const void * base,
+	        const size_t count,
+	        const size_t size,
+	        const void * key)
+{
+	switch(size) {
+	case 1:
+	case 2:
+	case 4:
+	case 8:
+	case 16:
+#ifdef __X86_SIMD
+		if(__builtin_cpu_supports("avx2"))
+			return __find_avx2(base, count, size, key);
+		if(__builtin_cpu_supports("sse2"))
+			return __find_sse2(base, count, size, key);
+#endif
+		/* fall through */
+	default:
+		return __find_scalar(base, count, size, key);
+	}
+}
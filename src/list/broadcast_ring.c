@@ -0,0 +1,277 @@
+/* broadcast_ring.c - Single-Producer Broadcast Ring Implementation
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "list/broadcast_ring.h"
+
+/* Sequence numbers increase monotonically, and sequence `s` is always stored
+ * in slot `s % entries`.  The producer owns `published`, and each consumer
+ * owns its cursor's `sequence`; neither side ever writes the other's counter.
+ * Consumers release a block by advancing their cursor past it, and the
+ * producer may overwrite a slot once every active cursor has moved past the
+ * block in it.
+ *
+ * Scanning every cursor is expensive, so the producer remembers the lowest
+ * cursor it saw in `gate`, and only scans again when publishing would pass
+ * `gate + entries`.  Since cursors only ever move forward, a stale `gate` is
+ * always safe. */
+
+static inline __pure __nonulls void * __block(const broadcast_ring ring,
+	                                     const size_t sequence)
+{
+	size_t data = (size_t) DS_PRIV(ring)->data;
+	size_t index = sequence % DS_ENTRIES(ring);
+
+	return (void *) (data + index * DS_DATA_SIZE(ring));
+}
+
+static inline __nonulls struct br_cursor * __cursor(const broadcast_ring ring,
+	                                            const size_t consumer)
+{
+	return &DS_PRIV(ring)->cursors[consumer];
+}
+
+/* Describe `count` blocks starting at `sequence` as up to two spans. */
+static __nonulls void __spans(const broadcast_ring ring,
+	                      const size_t sequence,
+	                      const size_t count,
+	                      struct rb_span span[2])
+{
+	size_t first;
+
+	first = MIN(count, DS_ENTRIES(ring) - sequence % DS_ENTRIES(ring));
+	span[0].data  = __block(ring, sequence);
+	span[0].count = first;
+	span[1].data  = DS_PRIV(ring)->data;
+	span[1].count = count - first;
+}
+
+/* Find the number of blocks the producer may publish without overwriting a
+ * block some consumer still needs, rescanning the cursors if `gate` says
+ * there might not be room for `count` blocks. */
+static __nonulls size_t __room(broadcast_ring ring, const size_t count)
+{
+	size_t published = DS_PRIV(ring)->published;
+	size_t gate = DS_PRIV(ring)->gate;
+	size_t sequence;
+	struct br_cursor * cursor;
+
+	if(published + count - gate <= DS_ENTRIES(ring))
+		return count;
+
+	/* Pairs with the fence in br_subscribe(): either this scan sees a new
+	 * consumer, or that consumer starts after everything published so far.
+	 */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	gate = published;
+	for(size_t i = 0; i < DS_CONSUMERS(ring); i++) {
+		cursor = __cursor(ring, i);
+		if(!__atomic_load_n(&cursor->active, __ATOMIC_ACQUIRE))
+			continue;
+
+		sequence = __atomic_load_n(&cursor->sequence, __ATOMIC_ACQUIRE);
+		if((ssize_t) (sequence - gate) < 0)
+			gate = sequence;
+	}
+
+	/* A consumer that is still subscribing may briefly show a cursor more
+	 * than a lap behind. */
+	DS_PRIV(ring)->gate = gate;
+	if(published - gate >= DS_ENTRIES(ring))
+		return 0;
+
+	return MIN(count, DS_ENTRIES(ring) - (published - gate));
+}
+
+broadcast_ring br_create(const struct ds_properties * props)
+{
+	size_t size;
+	broadcast_ring ring;
+	struct broadcast_ring_priv * priv;
+
+	if(props->entries == 0 || props->consumers == 0)
+		return_with_errno(EINVAL, NULL);
+
+	/* The private area contains cache line aligned members, so the ring
+	 * itself must be allocated with the same alignment. */
+	ring = aligned_alloc(CACHE_LINE_SIZE, sizeof(*ring));
+	if(!ring)
+		return_with_errno(ENOMEM, NULL);
+
+	DS_INIT(ring, props);
+
+	priv = DS_PRIV(ring);
+	priv->published = 0;
+	priv->gate      = 0;
+	priv->cursors   = NULL;
+
+	priv->data = malloc(DS_DATA_SIZE(ring) * DS_ENTRIES(ring));
+	if(!priv->data)
+		goto_with_errno(ENOMEM, exit);
+
+	size = props->consumers * sizeof(struct br_cursor);
+	priv->cursors = aligned_alloc(CACHE_LINE_SIZE, size);
+	if(!priv->cursors)
+		goto_with_errno(ENOMEM, exit);
+
+	for(size_t i = 0; i < props->consumers; i++) {
+		priv->cursors[i].sequence = 0;
+		priv->cursors[i].active   = false;
+	}
+
+	return ring;
+
+exit:
+	free(priv->data);
+	free(ring);
+	return NULL;
+}
+
+void br_destroy(broadcast_ring * ring)
+{
+	free_null(DS_PRIV(*ring)->data);
+	free_null(DS_PRIV(*ring)->cursors);
+	DS_FREE(ring);
+}
+
+ssize_t br_subscribe(broadcast_ring ring)
+{
+	struct br_cursor * cursor;
+	size_t published;
+	bool inactive;
+
+	for(size_t i = 0; i < DS_CONSUMERS(ring); i++) {
+		cursor = __cursor(ring, i);
+
+		inactive = false;
+		if(!__atomic_compare_exchange_n(&cursor->active, &inactive,
+		                                true, false,
+		                                __ATOMIC_SEQ_CST,
+		                                __ATOMIC_RELAXED))
+			continue;
+
+		/* Until the producer sees this cursor, it may overwrite any
+		 * block it has not published yet, so start after the last
+		 * published block seen once the cursor is visible.  Storing the
+		 * cursor before marking it active, above, would not be enough:
+		 * the producer might have scanned the cursors just before. */
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		published = __atomic_load_n(&DS_PRIV(ring)->published,
+		                            __ATOMIC_ACQUIRE);
+		__atomic_store_n(&cursor->sequence, published,
+		                 __ATOMIC_RELEASE);
+
+		return i;
+	}
+
+	return_with_errno(EAGAIN, -1);
+}
+
+void br_unsubscribe(broadcast_ring ring, const size_t consumer)
+{
+	struct br_cursor * cursor = __cursor(ring, consumer);
+
+	__atomic_store_n(&cursor->active, false, __ATOMIC_RELEASE);
+}
+
+bool br_publish(broadcast_ring ring, const void * data)
+{
+	return br_publish_n(ring, data, 1) == 1;
+}
+
+size_t br_publish_n(broadcast_ring ring, const void * data, const size_t count)
+{
+	struct rb_span span[2];
+	size_t published = DS_PRIV(ring)->published;
+	size_t room;
+
+	room = __room(ring, count);
+	if(!room)
+		return 0;
+
+	__spans(ring, published, room, span);
+	memcpy(span[0].data, data, span[0].count * DS_DATA_SIZE(ring));
+	memcpy(span[1].data,
+	       (uint8_t *) data + span[0].count * DS_DATA_SIZE(ring),
+	       span[1].count * DS_DATA_SIZE(ring));
+
+	__atomic_store_n(&DS_PRIV(ring)->published,
+	                 published + room,
+	                 __ATOMIC_RELEASE);
+
+	return room;
+}
+
+size_t br_available(const broadcast_ring ring, const size_t consumer)
+{
+	size_t sequence;
+	size_t published;
+
+	sequence  = __atomic_load_n(&__cursor(ring, consumer)->sequence,
+	                            __ATOMIC_RELAXED);
+	published = __atomic_load_n(&DS_PRIV(ring)->published,
+	                            __ATOMIC_ACQUIRE);
+
+	return published - sequence;
+}
+
+size_t br_peek(broadcast_ring ring,
+               const size_t consumer,
+               const size_t count,
+               struct rb_span span[2])
+{
+	size_t sequence;
+	size_t peeked;
+
+	sequence = __atomic_load_n(&__cursor(ring, consumer)->sequence,
+	                           __ATOMIC_RELAXED);
+	peeked   = MIN(count, br_available(ring, consumer));
+	__spans(ring, sequence, peeked, span);
+
+	return peeked;
+}
+
+void br_release(broadcast_ring ring, const size_t consumer, const size_t count)
+{
+	struct br_cursor * cursor = __cursor(ring, consumer);
+	size_t sequence;
+
+	/* The release store keeps the producer from reusing the slots until
+	 * this consumer has finished reading them. */
+	sequence = __atomic_load_n(&cursor->sequence, __ATOMIC_RELAXED);
+	__atomic_store_n(&cursor->sequence, sequence + count, __ATOMIC_RELEASE);
+}
+
+size_t br_read(broadcast_ring ring,
+               const size_t consumer,
+               void * data,
+               const size_t count)
+{
+	struct rb_span span[2];
+	size_t read;
+
+	read = br_peek(ring, consumer, count, span);
+	memcpy(data, span[0].data, span[0].count * DS_DATA_SIZE(ring));
+	memcpy((uint8_t *) data + span[0].count * DS_DATA_SIZE(ring),
+	       span[1].data,
+	       span[1].count * DS_DATA_SIZE(ring));
+	br_release(ring, consumer, read);
+
+	return read;
+}
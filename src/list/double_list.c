@@ -20,20 +20,53 @@
 
 #include "list/double_list.h"
 
-static __pure struct dl_element * __create_element(__immutable(void) data,
-	                                           const size_t data_size)
+/* Each element holds its data inline; the elements of a pooled list come
+ * from its pool rather than from malloc(). */
+static struct dl_element * __create_element(const double_list list,
+	                                    __immutable(void) data)
 {
 	struct dl_element * elem;
 
-	malloc_rof(elem, sizeof(*elem), NULL);
-	malloc_gof(elem->data, data_size, exit);
+	if(DS_POOLED(list)) {
+		elem = pool_alloc(DS_PRIV(list)->pool);
+		if(!elem)
+			return NULL;
+	} else {
+		malloc_rof(elem, sizeof(*elem) + DS_DATA_SIZE(list), NULL);
+	}
 
-	memcpy(elem->data, data, data_size);
+	memcpy(elem->data, data, DS_DATA_SIZE(list));
 	return elem;
+}
 
-exit:
-	free(elem);
-	return NULL;
+static void __free_element(const double_list list, struct dl_element * elem)
+{
+	if(DS_POOLED(list))
+		pool_free(DS_PRIV(list)->pool, elem);
+	else
+		free(elem);
+}
+
+/* Release `elem`, but hand its data to the caller in memory the caller can
+ * free().  A malloc()ed element is reused for this by moving its data to the
+ * start of it; a pooled element's data has to be copied out of the pool. */
+static void * __take_data(const double_list list, struct dl_element * elem)
+{
+	void * data;
+
+	if(!elem)
+		return NULL;
+
+	if(DS_POOLED(list)) {
+		data = malloc(DS_DATA_SIZE(list));
+		if(data)
+			memcpy(data, elem->data, DS_DATA_SIZE(list));
+		pool_free(DS_PRIV(list)->pool, elem);
+	} else {
+		data = memmove(elem, elem->data, DS_DATA_SIZE(list));
+	}
+
+	return data;
 }
 
 static __pure bool __elem(const double_list list, __immutable(void) data)
@@ -47,19 +80,65 @@ static __pure bool __elem(const double_list list, __immutable(void) data)
 	return false;
 }
 
+static inline size_t __distance(const size_t a, const size_t b)
+{
+	return (a > b) ? a - b : b - a;
+}
+
+/* Readers may look up elements concurrently, so a lookup only uses and moves
+ * the finger if no other lookup is using it.  Writers always get it. */
+static inline bool __finger_grab(const double_list list)
+{
+	return !__atomic_test_and_set(&DS_PRIV(list)->finger_busy,
+	                              __ATOMIC_ACQUIRE);
+}
+
+static inline void __finger_drop(const double_list list)
+{
+	__atomic_clear(&DS_PRIV(list)->finger_busy, __ATOMIC_RELEASE);
+}
+
 static __nonulls struct dl_element * __fetch(const double_list list,
 	                                     const size_t pos)
 {
+	struct double_list_priv * priv = DS_PRIV(list);
 	struct dl_element * current;
+	size_t i;
+	bool finger;
 
 	if(pos >= __LENGTH(list))
 		return NULL;
 
-	current = __HEAD(list);
-	for(size_t i = 0; i < pos; i++)
-		current = current->next; /* `current` shouldn't ever be NULL
-		 	                  * in this context unless something
-					  * corrupted the list elsewhere. */
+	/* Walk from whichever of the head, the tail, and the finger is closest
+	 * to `pos`. */
+	if(pos <= __LENGTH(list) - 1 - pos) {
+		current = __HEAD(list);
+		i = 0;
+	} else {
+		current = __TAIL(list);
+		i = __LENGTH(list) - 1;
+	}
+
+	finger = __finger_grab(list);
+	if(finger && priv->finger &&
+	   __distance(priv->finger_pos, pos) < __distance(i, pos)) {
+		current = priv->finger;
+		i = priv->finger_pos;
+	}
+
+	/* `current` shouldn't ever be NULL in these loops unless something
+	 * corrupted the list elsewhere. */
+	for(; i < pos; i++)
+		current = current->next;
+	for(; i > pos; i--)
+		current = current->prev;
+
+	if(finger) {
+		priv->finger = current;
+		priv->finger_pos = pos;
+		__finger_drop(list);
+	}
+
 	return current;
 }
 
@@ -75,7 +154,7 @@ static __nonulls void __push_head(double_list list,
 		__TAIL(list) = current;
 	__HEAD(list) = current;
 
-
+	DS_PRIV(list)->finger_pos++;
 	(DS_PRIV(list)->length)++;
 }
 
@@ -92,6 +171,9 @@ static __nonulls struct dl_element * __pop_head(double_list list)
 	else
 		__TAIL(list) = NULL;
 
+	if(DS_PRIV(list)->finger == current)
+		DS_PRIV(list)->finger = NULL;
+	DS_PRIV(list)->finger_pos--;
 	(DS_PRIV(list)->length)--;
 
 	return current;
@@ -125,6 +207,8 @@ static __nonulls struct dl_element * __pop_tail(double_list list)
 	else
 		__HEAD(list) = NULL;
 
+	if(DS_PRIV(list)->finger == current)
+		DS_PRIV(list)->finger = NULL;
 	(DS_PRIV(list)->length)--;
 
 	return current;
@@ -175,6 +259,8 @@ static __nonulls struct dl_element * __remove(double_list list,
 		current->prev->next = current->next;
 		current->next->prev = current->prev;
 
+		/* The next element takes the removed one's position. */
+		DS_PRIV(list)->finger = current->next;
 		DS_PRIV(list)->length--;
 	}
 
@@ -196,6 +282,7 @@ static __nonulls void __remove_element(double_list list,
 	if(elem->next)
 		elem->next->prev = elem->prev;
 
+	DS_PRIV(list)->finger = NULL;
 	DS_PRIV(list)->length--;
 }
 
@@ -203,9 +290,10 @@ static void __delete_before(double_list list, struct dl_element * const mark)
 {
 	struct dl_element * current;
 
+	DS_PRIV(list)->finger = NULL;
+
 	linked_list_while_safe(list, current, current != mark) {
-		free(current->data);
-		free(current);
+		__free_element(list, current);
 
 		DS_PRIV(list)->length--;
 	}
@@ -220,9 +308,10 @@ static void __delete_after(double_list list, struct dl_element * const mark)
 {
 	struct dl_element * current;
 
+	DS_PRIV(list)->finger = NULL;
+
 	double_list_while_rev_safe(list, current, current != mark) {
-		free(current->data);
-		free(current);
+		__free_element(list, current);
 
 		DS_PRIV(list)->length--;
 	}
@@ -233,6 +322,20 @@ static void __delete_after(double_list list, struct dl_element * const mark)
 		__HEAD(list) = NULL;
 }
 
+/* Copy the data carried by `current` into `data`, then release `current`. */
+static bool __extract(const double_list list,
+	              struct dl_element * current,
+	              void * data)
+{
+	if(!current)
+		return false;
+
+	memcpy(data, current->data, DS_DATA_SIZE(list));
+	__free_element(list, current);
+
+	return true;
+}
+
 double_list dl_create(__immutable(struct ds_properties) props)
 {
 	double_list list;
@@ -246,11 +349,22 @@ double_list dl_create(__immutable(struct ds_properties) props)
 	priv->head = NULL;
 	priv->tail = NULL;
 	priv->length = 0;
+	priv->finger = NULL;
+	priv->finger_pos = 0;
+	priv->finger_busy = false;
+	priv->pool = NULL;
 
         priv->rwlock = rwlock_create();
 	if(!priv->rwlock)
 		goto exit;
 
+	if(DS_POOLED(list)) {
+		priv->pool = pool_create(sizeof(struct dl_element) +
+		                         DS_DATA_SIZE(list));
+		if(!priv->pool)
+			goto exit;
+	}
+
 	return list;
 
 exit:
@@ -264,9 +378,12 @@ void dl_destroy(double_list * list)
 
 	rwlock_writer_entry(DS_PRIV(*list)->rwlock);
 
-	linked_list_foreach_safe(*list, current) {
-		free(current->data);
-		free(current);
+	/* A pool releases all of its elements at once. */
+	if(DS_PRIV(*list)->pool) {
+		pool_destroy(&DS_PRIV(*list)->pool);
+	} else {
+		linked_list_foreach_safe(*list, current)
+			__free_element(*list, current);
 	}
 
 	rwlock_writer_exit(DS_PRIV(*list)->rwlock);
@@ -301,10 +418,10 @@ void dl_push_head(double_list list, __immutable(void) data)
 {
 	struct dl_element * current;
 
-	current = __create_element(data, DS_DATA_SIZE(list));
-
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	__push_head(list, current);
+	current = __create_element(list, data);
+	if(current)
+		__push_head(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 }
 
@@ -312,10 +429,10 @@ void dl_push_tail(double_list list, __immutable(void) data)
 {
 	struct dl_element * current;
 
-	current = __create_element(data, DS_DATA_SIZE(list));
-
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	__push_tail(list, current);
+	current = __create_element(list, data);
+	if(current)
+		__push_tail(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 }
 
@@ -326,13 +443,9 @@ void * dl_pop_head(double_list list)
 
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
 	current = __pop_head(list);
+	data = __take_data(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		data = current->data;
-		free(current);
-	}
-
 	return data;
 }
 
@@ -343,46 +456,64 @@ void * dl_pop_tail(double_list list)
 
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
 	current = __pop_tail(list);
+	data = __take_data(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		data = current->data;
-		free(current);
-	}
-
 	return data;
 }
 
-bool dl_insert(double_list list, __immutable(void) data, const size_t pos)
+bool dl_pop_head_into(double_list list, void * data)
 {
 	bool success;
 	struct dl_element * current;
 
-	current = __create_element(data, DS_DATA_SIZE(list));
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	current = __pop_head(list);
+	success = __extract(list, current, data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool dl_pop_tail_into(double_list list, void * data)
+{
+	bool success;
+	struct dl_element * current;
 
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	success = __insert(list, current, pos);
+	current = __pop_tail(list);
+	success = __extract(list, current, data);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
 	return success;
 }
 
-bool dl_delete(double_list list, const size_t pos)
+bool dl_insert(double_list list, __immutable(void) data, const size_t pos)
 {
+	bool success;
 	struct dl_element * current;
 
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	current = __remove(list, pos);
+	current = __create_element(list, data);
+	success = current && __insert(list, current, pos);
+	if(current && !success)
+		__free_element(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		free(current->data);
-		free(current);
+	return success;
+}
 
-		return true;
-	}
+bool dl_delete(double_list list, const size_t pos)
+{
+	struct dl_element * current;
 
-	return false;
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	current = __remove(list, pos);
+	if(current)
+		__free_element(list, current);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return current != NULL;
 }
 
 void * dl_remove(double_list list, const size_t pos)
@@ -392,13 +523,9 @@ void * dl_remove(double_list list, const size_t pos)
 
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
 	current = __remove(list, pos);
+	data = __take_data(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		data = current->data;
-		free(current);
-	}
-
 	return data;
 }
 
@@ -413,6 +540,19 @@ bool dl_elem(const double_list list, __immutable(void) data)
 	return success;
 }
 
+bool dl_remove_into(double_list list, const size_t pos, void * data)
+{
+	bool success;
+	struct dl_element * current;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	current = __remove(list, pos);
+	success = __extract(list, current, data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
 void * dl_fetch(const double_list list, const size_t pos)
 {
 	struct dl_element * current;
@@ -429,6 +569,7 @@ void * dl_fetch(const double_list list, const size_t pos)
 
 void dl_reverse(double_list list)
 {
+	struct double_list_priv * priv = DS_PRIV(list);
 	struct dl_element * current;
 	struct dl_element * tmp;
 
@@ -442,6 +583,8 @@ void dl_reverse(double_list list)
 	tmp = __HEAD(list);
 	__HEAD(list) = __TAIL(list);
 	__TAIL(list) = tmp;
+
+	priv->finger_pos = __LENGTH(list) - 1 - priv->finger_pos;
 }
 
 bool dl_any(const double_list list, const pred_fn p)
@@ -503,11 +646,13 @@ bool dl_filter(double_list list, const pred_fn p)
 			changed = true;
 
 			__remove_element(list, current);
-			free(current->data);
-			free(current);
+			__free_element(list, current);
 		}
 	}
 
+	if(changed && DS_PRIV(list)->pool)
+		pool_trim(DS_PRIV(list)->pool);
+
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
 	return changed;
@@ -535,6 +680,9 @@ bool dl_drop_while(double_list list, const pred_fn p)
 		__delete_before(list, NULL);
 	}
 
+	if(DS_PRIV(list)->pool && orig_length != DS_PRIV(list)->length)
+		pool_trim(DS_PRIV(list)->pool);
+
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
 	return (orig_length != DS_PRIV(list)->length);
@@ -558,6 +706,9 @@ bool dl_take_while(double_list list, const pred_fn p)
 		}
 	}
 
+	if(DS_PRIV(list)->pool && orig_length != DS_PRIV(list)->length)
+		pool_trim(DS_PRIV(list)->pool);
+
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
 	return (orig_length != DS_PRIV(list)->length);
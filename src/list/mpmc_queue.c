@@ -0,0 +1,183 @@
+/* mpmc_queue.c - Bounded Multi-Producer/Multi-Consumer Queue Implementation
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "list/mpmc_queue.h"
+
+/* Tickets handed out by `head` and `tail` increase monotonically, and ticket
+ * `t` always uses cell `t % entries`.  A cell's sequence number cycles through
+ * `t` (free for the producer holding ticket `t`), `t + 1` (full, ready for the
+ * consumer holding ticket `t`), and `t + entries` (free for the producer one
+ * lap later).  Producers and consumers claim tickets with a compare-and-swap
+ * and never touch each other's counter, so pushes only contend with pushes and
+ * pops only contend with pops. */
+
+static inline __pure __nonulls struct mq_cell * __cell(const mpmc_queue queue,
+	                                               const size_t ticket)
+{
+	size_t cells = (size_t) DS_PRIV(queue)->cells;
+	size_t index = ticket % DS_ENTRIES(queue);
+
+	return (struct mq_cell *) (cells + index * DS_PRIV(queue)->stride);
+}
+
+static __nonulls struct mq_cell * __claim(const mpmc_queue queue,
+	                                  size_t * counter,
+	                                  const size_t lag,
+	                                  size_t * ticket)
+{
+	struct mq_cell * cell;
+	size_t sequence;
+	ssize_t diff;
+
+	*ticket = __atomic_load_n(counter, __ATOMIC_RELAXED);
+	for(;;) {
+		cell = __cell(queue, *ticket);
+		sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+		diff = (ssize_t) (sequence - (*ticket + lag));
+
+		if(diff == 0) {
+			/* The cell is ready for us; try to take the ticket.  On
+			 * failure, `*ticket` is reloaded with the counter. */
+			if(__atomic_compare_exchange_n(counter, ticket,
+				                       *ticket + 1, true,
+				                       __ATOMIC_RELAXED,
+				                       __ATOMIC_RELAXED))
+				return cell;
+		} else if(diff < 0) {
+			/* The cell is still a lap behind: full or empty. */
+			return NULL;
+		} else {
+			/* Another thread took this ticket first. */
+			*ticket = __atomic_load_n(counter, __ATOMIC_RELAXED);
+		}
+	}
+}
+
+mpmc_queue mq_create(const struct ds_properties * props)
+{
+	mpmc_queue queue;
+	struct mpmc_queue_priv * priv;
+	struct mq_cell * cell;
+
+	if(props->entries == 0 || props->overwrite)
+		return_with_errno(EINVAL, NULL);
+
+	/* The private area contains cache line aligned members, so the queue
+	 * itself must be allocated with the same alignment. */
+	queue = aligned_alloc(CACHE_LINE_SIZE, sizeof(*queue));
+	if(!queue)
+		return_with_errno(ENOMEM, NULL);
+
+	DS_INIT(queue, props);
+
+	/* Round the cell size up so that every cell header stays aligned. */
+	priv = DS_PRIV(queue);
+	priv->stride = sizeof(struct mq_cell) + DS_DATA_SIZE(queue);
+	priv->stride = ((priv->stride + sizeof(size_t) - 1) / sizeof(size_t)) *
+		       sizeof(size_t);
+
+	priv->cells = malloc(priv->stride * DS_ENTRIES(queue));
+	if(!priv->cells)
+		goto_with_errno(ENOMEM, exit);
+
+	for(size_t i = 0; i < DS_ENTRIES(queue); i++) {
+		cell = __cell(queue, i);
+		cell->sequence = i;
+	}
+
+	priv->head = 0;
+	priv->tail = 0;
+
+	return queue;
+
+exit:
+	free(queue);
+	return NULL;
+}
+
+void mq_destroy(mpmc_queue * queue)
+{
+	free_null(DS_PRIV(*queue)->cells);
+	DS_FREE(queue);
+}
+
+size_t mq_size(const mpmc_queue queue)
+{
+	size_t head;
+	size_t tail;
+
+	/* Load `head` first so that the snapshot can't go negative. */
+	head = __atomic_load_n(&DS_PRIV(queue)->head, __ATOMIC_ACQUIRE);
+	tail = __atomic_load_n(&DS_PRIV(queue)->tail, __ATOMIC_ACQUIRE);
+
+	return MIN(tail - head, DS_ENTRIES(queue));
+}
+
+bool mq_empty(const mpmc_queue queue)
+{
+	return (mq_size(queue) <= 0);
+}
+
+bool mq_full(const mpmc_queue queue)
+{
+	return (mq_size(queue) >= DS_ENTRIES(queue));
+}
+
+bool mq_push(mpmc_queue queue, const void * data)
+{
+	struct mq_cell * cell;
+	size_t ticket;
+
+	cell = __claim(queue, &DS_PRIV(queue)->tail, 0, &ticket);
+	if(!cell)
+		return false;
+
+	memcpy(cell->data, data, DS_DATA_SIZE(queue));
+	__atomic_store_n(&cell->sequence, ticket + 1, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+void * mq_pop(mpmc_queue queue)
+{
+	struct mq_cell * cell;
+	size_t ticket;
+	void * data;
+
+	/* Don't allocate just to find out that the queue is empty. */
+	if(mq_empty(queue))
+		return NULL;
+
+	/* Allocate before claiming a cell, so that a claimed cell can always be
+	 * handed back to the producers. */
+	malloc_rof(data, DS_DATA_SIZE(queue), NULL);
+
+	cell = __claim(queue, &DS_PRIV(queue)->head, 1, &ticket);
+	if(!cell) {
+		free(data);
+		return NULL;
+	}
+
+	memcpy(data, cell->data, DS_DATA_SIZE(queue));
+	__atomic_store_n(&cell->sequence,
+		         ticket + DS_ENTRIES(queue),
+		         __ATOMIC_RELEASE);
+
+	return data;
+}
@@ -17,32 +17,158 @@
  * along with focs.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stddef.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "focs/block.h"
+#include "focs/search.h"
 #include "list/ring_buffer.h"
 #include "sync/rwlock.h"
 
-static bool __nonulls __elem(const ring_buffer buf, const void * data)
+/* ################### *
+ * # Optimistic Reads # *
+ * ################### */
+
+/* Every change made under the writer lock makes `seq` odd while it is in
+ * progress, and even again once it is complete.  A reader that finds the same
+ * even `seq` before and after reading the buffer knows no writer interfered,
+ * so queries normally neither write to shared memory nor wait for writers.
+ * After __OPTIMISTIC_TRIES failed attempts, readers fall back to the reader
+ * lock so that they cannot be starved by a busy writer. */
+
+#define __OPTIMISTIC_TRIES 4
+
+/* Evaluate `stmt` against a stable view of `buf`.  `stmt` may run several
+ * times, and must only read the buffer through __snapshot(). */
+#define __read_optimistic(buf, stmt)                                        \
+	do {                                                                \
+		size_t _seq;                                                \
+		size_t _try;                                                \
+		                                                            \
+		for(_try = 0; _try < __OPTIMISTIC_TRIES; _try++) {          \
+			_seq = __atomic_load_n(&DS_PRIV(buf)->seq,          \
+			                       __ATOMIC_ACQUIRE);           \
+			if(_seq & 1)                                        \
+				continue;                                   \
+			                                                    \
+			stmt;                                               \
+			                                                    \
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);            \
+			if(__atomic_load_n(&DS_PRIV(buf)->seq,              \
+			                   __ATOMIC_RELAXED) == _seq)       \
+				break;                                      \
+		}                                                           \
+		                                                            \
+		if(_try == __OPTIMISTIC_TRIES) {                            \
+			rwlock_reader_entry(DS_PRIV(buf)->rwlock);          \
+			stmt;                                               \
+			rwlock_reader_exit(DS_PRIV(buf)->rwlock);           \
+		}                                                           \
+	} while(0)
+
+/* Read the head index and length of `buf` once.  The result may be stale, but
+ * the length is always clamped to the capacity, so a view taken while a
+ * writer is active still only ever addresses blocks inside the storage. */
+static inline __nonulls void __snapshot(const ring_buffer buf,
+	                                size_t * head,
+	                                size_t * length)
 {
-	void * current;
+	size_t tail;
 
-	ring_buffer_foreach(buf, current)
-		if(memcmp(current, data, DS_DATA_SIZE(buf)) == 0)
-			return true;
+	*head = __atomic_load_n(&DS_PRIV(buf)->head, __ATOMIC_RELAXED);
+	tail  = __atomic_load_n(&DS_PRIV(buf)->tail, __ATOMIC_RELAXED);
 
-	return false;
+	*length = MIN(__distance(buf, *head, tail), __ENTRIES(buf));
+}
+
+static __nonulls size_t __snapshot_length(const ring_buffer buf)
+{
+	size_t head;
+	size_t length;
+
+	__snapshot(buf, &head, &length);
+
+	return length;
+}
+
+static __nonulls bool __snapshot_fetch(const ring_buffer buf,
+	                               const ssize_t pos,
+	                               void * data)
+{
+	size_t head;
+	size_t length;
+
+	__snapshot(buf, &head, &length);
+	if(!length)
+		return false;
+
+	head += mod(pos, (ssize_t) length);
+	memcpy(data, __slot(buf, head), DS_DATA_SIZE(buf));
+
+	return true;
+}
+
+static __nonulls bool __snapshot_elem(const ring_buffer buf, const void * data)
+{
+	size_t head;
+	size_t length;
+	size_t first;
+
+	__snapshot(buf, &head, &length);
+
+	/* Search the stored blocks as (at most) two contiguous arrays. */
+	first = MIN(length, __contiguous(buf, head));
+	if(mem_find(__slot(buf, head), first, DS_DATA_SIZE(buf), data) < first)
+		return true;
+
+	return mem_find(DS_PRIV(buf)->data,
+	                length - first,
+	                DS_DATA_SIZE(buf),
+	                data) < length - first;
 }
 
 static __nonulls void __push_head(ring_buffer buf, __immutable(void) data)
 {
-	DS_PRIV(buf)->head = __prev(buf, DS_PRIV(buf)->head);
-	memcpy(DS_PRIV(buf)->head, data, DS_DATA_SIZE(buf));
-	DS_PRIV(buf)->length = MIN(DS_PRIV(buf)->length + 1, DS_ENTRIES(buf));
+	struct ring_buffer_priv * priv = DS_PRIV(buf);
+
+	/* When overwriting, the block at the tail end falls off the buffer. */
+	if(__IS_FULL(buf))
+		priv->tail = __retreat(buf, priv->tail, 1);
+
+	priv->head = __retreat(buf, priv->head, 1);
+	memcpy(__slot(buf, priv->head), data, DS_DATA_SIZE(buf));
 }
 
 static __nonulls void __push_tail(ring_buffer buf, __immutable(void) data)
 {
-	memcpy(DS_PRIV(buf)->tail, data, DS_DATA_SIZE(buf));
-	DS_PRIV(buf)->tail = __next(buf, DS_PRIV(buf)->tail);
-	DS_PRIV(buf)->length = MIN(DS_PRIV(buf)->length + 1, DS_ENTRIES(buf));
+	struct ring_buffer_priv * priv = DS_PRIV(buf);
+
+	/* When overwriting, the block at the head end falls off the buffer. */
+	if(__IS_FULL(buf))
+		priv->head = __advance(buf, priv->head, 1);
+
+	memcpy(__slot(buf, priv->tail), data, DS_DATA_SIZE(buf));
+	priv->tail = __advance(buf, priv->tail, 1);
+}
+
+static __nonulls void __pop_head_into(ring_buffer buf, void * data)
+{
+	memcpy(data, __HEAD(buf), DS_DATA_SIZE(buf));
+	DS_PRIV(buf)->head = __advance(buf, DS_PRIV(buf)->head, 1);
+}
+
+static __nonulls void __pop_tail_into(ring_buffer buf, void * data)
+{
+	DS_PRIV(buf)->tail = __retreat(buf, DS_PRIV(buf)->tail, 1);
+	memcpy(data, __slot(buf, DS_PRIV(buf)->tail), DS_DATA_SIZE(buf));
 }
 
 static __nonulls void * __pop_head(ring_buffer buf)
@@ -50,9 +176,7 @@ static __nonulls void * __pop_head(ring_buffer buf)
 	void * data;
 
 	malloc_rof(data, DS_DATA_SIZE(buf), NULL);
-	memcpy(data, DS_PRIV(buf)->head, DS_DATA_SIZE(buf));
-	DS_PRIV(buf)->head = __next(buf, DS_PRIV(buf)->head);
-	DS_PRIV(buf)->length--;
+	__pop_head_into(buf, data);
 
 	return data;
 }
@@ -61,397 +185,1719 @@ static __nonulls void * __pop_tail(ring_buffer buf)
 {
 	void * data;
 
-	malloc_rof(data, DS_DATA_SIZE(buf), NULL);
-	DS_PRIV(buf)->tail = __prev(buf, DS_PRIV(buf)->tail);
-	memcpy(data, DS_PRIV(buf)->tail, DS_DATA_SIZE(buf));
-	DS_PRIV(buf)->length--;
+	malloc_rof(data, DS_DATA_SIZE(buf), NULL);
+	__pop_tail_into(buf, data);
+
+	return data;
+}
+
+/* Copy `count` blocks into the buffer, starting at logical index `index`.  The
+ * destination wraps around the end of the data area at most once. */
+static __nonulls void __copy_in(ring_buffer buf,
+	                        const size_t index,
+	                        const void * data,
+	                        const size_t count)
+{
+	size_t first;
+	size_t size = DS_DATA_SIZE(buf);
+
+	first = MIN(count, __contiguous(buf, index));
+	memcpy(__slot(buf, index), data, first * size);
+	memcpy(DS_PRIV(buf)->data,
+	       (uint8_t *) data + first * size,
+	       (count - first) * size);
+}
+
+/* Copy `count` blocks out of the buffer, starting at logical index `index`. */
+static __nonulls void __copy_out(const ring_buffer buf,
+	                         const size_t index,
+	                         void * data,
+	                         const size_t count)
+{
+	size_t first;
+	size_t size = DS_DATA_SIZE(buf);
+
+	first = MIN(count, __contiguous(buf, index));
+	memcpy(data, __slot(buf, index), first * size);
+	memcpy((uint8_t *) data + first * size,
+	       DS_PRIV(buf)->data,
+	       (count - first) * size);
+}
+
+/* Describe `count` blocks starting at logical index `index` as at most two
+ * contiguous spans of the backing store. */
+static __nonulls void __spans(const ring_buffer buf,
+	                      const size_t index,
+	                      const size_t count,
+	                      struct rb_span span[2])
+{
+	size_t first;
+
+	first = MIN(count, __contiguous(buf, index));
+	span[0].data  = __slot(buf, index);
+	span[0].count = first;
+	span[1].data  = DS_PRIV(buf)->data;
+	span[1].count = count - first;
+}
+
+/* Work out how many of `count` blocks can be pushed into `buf` and how many
+ * stored blocks have to be dropped to make room for them.  Returns the number
+ * of blocks that will actually be stored, which is never more than `entries`.
+ */
+static __nonulls size_t __make_room(const ring_buffer buf,
+	                            const size_t count,
+	                            size_t * drop)
+{
+	size_t space = __ENTRIES(buf) - __LENGTH(buf);
+
+	*drop = 0;
+	if(count <= space)
+		return count;
+
+	if(!DS_OVERWRITE(buf))
+		return space;
+
+	*drop = MIN(count, __ENTRIES(buf)) - space;
+	return MIN(count, __ENTRIES(buf));
+}
+
+/* Move the contents of `buf` into new storage for `entries` blocks, starting
+ * at the beginning of it, so the contents are copied with at most two
+ * memcpy() calls and no longer wrap.  A block partly read by rb_read_fd()
+ * sits just after the tail, and moves with the contents. */
+static __nonulls bool __resize(ring_buffer buf, const size_t entries)
+{
+	void * data;
+	size_t length;
+	size_t kept;
+	struct ring_buffer_priv * priv = DS_PRIV(buf);
+
+	length = __LENGTH(buf);
+	kept   = length + (priv->partial_in != 0);
+	if(entries < kept)
+		return_with_errno(EINVAL, false);
+
+	malloc_rof(data, entries * DS_DATA_SIZE(buf), false);
+	__copy_out(buf, priv->head, data, kept);
+	free(priv->data);
+
+	priv->data    = data;
+	priv->entries = entries;
+	priv->head    = 0;
+	priv->tail    = length;
+	priv->mask    = entries - 1;
+	priv->pow2    = (entries & priv->mask) == 0;
+
+	return true;
+}
+
+/* Make room for `count` more blocks in a growable buffer, at least doubling
+ * its capacity so that a run of pushes costs amortized O(1) per block.  If
+ * `buf` is not growable, or cannot grow, it is left alone. */
+static __nonulls void __grow(ring_buffer buf, const size_t count)
+{
+	size_t needed;
+
+	needed = __LENGTH(buf) + count;
+	if(!DS_GROWABLE(buf) || needed <= __ENTRIES(buf))
+		return;
+
+	__resize(buf, MAX(needed, 2 * __ENTRIES(buf)));
+}
+
+static __nonulls size_t __push_head_n(ring_buffer buf,
+	                              const void * data,
+	                              const size_t count)
+{
+	size_t drop;
+	size_t stored;
+	struct ring_buffer_priv * priv = DS_PRIV(buf);
+
+	/* If `data` is longer than the whole buffer, its leading blocks are the
+	 * ones that stay, since the rest fall off the tail. */
+	stored = __make_room(buf, count, &drop);
+	priv->tail = __retreat(buf, priv->tail, drop);
+	priv->head = __retreat(buf, priv->head, stored);
+	__copy_in(buf, priv->head, data, stored);
+
+	return DS_OVERWRITE(buf) ? count : stored;
+}
+
+static __nonulls size_t __push_tail_n(ring_buffer buf,
+	                              const void * data,
+	                              const size_t count)
+{
+	size_t drop;
+	size_t stored;
+	struct ring_buffer_priv * priv = DS_PRIV(buf);
+
+	/* If `data` is longer than the whole buffer, only its trailing blocks
+	 * survive, so skip straight to them. */
+	stored = __make_room(buf, count, &drop);
+	if(stored < count && DS_OVERWRITE(buf))
+		data = (uint8_t *) data + (count - stored) * DS_DATA_SIZE(buf);
+
+	priv->head = __advance(buf, priv->head, drop);
+	__copy_in(buf, priv->tail, data, stored);
+	priv->tail = __advance(buf, priv->tail, stored);
+
+	return DS_OVERWRITE(buf) ? count : stored;
+}
+
+static __nonulls size_t __pop_head_n(ring_buffer buf,
+	                             void * data,
+	                             const size_t count)
+{
+	size_t popped;
+
+	popped = MIN(count, __LENGTH(buf));
+	__copy_out(buf, DS_PRIV(buf)->head, data, popped);
+	DS_PRIV(buf)->head = __advance(buf, DS_PRIV(buf)->head, popped);
+
+	return popped;
+}
+
+static __nonulls size_t __pop_tail_n(ring_buffer buf,
+	                             void * data,
+	                             const size_t count)
+{
+	size_t popped;
+
+	popped = MIN(count, __LENGTH(buf));
+	DS_PRIV(buf)->tail = __retreat(buf, DS_PRIV(buf)->tail, popped);
+	__copy_out(buf, DS_PRIV(buf)->tail, data, popped);
+
+	return popped;
+}
+
+/* ###################################### *
+ * # Single-Producer/Single-Consumer Mode # *
+ * ###################################### */
+
+/* In SPSC mode, the producer is the only writer of `tail` and the consumer is
+ * the only writer of `head`.  Each side reads the other side's index with an
+ * acquire load before touching a data block, and publishes its own index with
+ * a release store afterwards, so a block is never read before it has been
+ * completely written, nor overwritten before it has been completely read. */
+
+static __nonulls size_t __spsc_length(const ring_buffer buf)
+{
+	size_t head;
+	size_t tail;
+
+	/* Load `head` first: `tail` never falls behind any earlier value of
+	 * `head`, so the computed distance is always in range. */
+	head = __atomic_load_n(&DS_PRIV(buf)->head, __ATOMIC_ACQUIRE);
+	tail = __atomic_load_n(&DS_PRIV(buf)->tail, __ATOMIC_ACQUIRE);
+
+	return __distance(buf, head, tail);
+}
+
+/* The number of free blocks after `tail`, as far as the producer knows.  The
+ * producer only reloads `head`, which the consumer writes on every pop, when
+ * its cached copy says there are fewer than `count` free blocks. */
+static __nonulls size_t __spsc_space(ring_buffer buf,
+	                             const size_t tail,
+	                             const size_t count)
+{
+	size_t head;
+	size_t space;
+	struct ring_buffer_priv * priv = DS_PRIV(buf);
+
+	space = __ENTRIES(buf) - __distance(buf, priv->head_cache, tail);
+	if(space < count) {
+		head  = __atomic_load_n(&priv->head, __ATOMIC_ACQUIRE);
+		space = __ENTRIES(buf) - __distance(buf, head, tail);
+		priv->head_cache = head;
+	}
+
+	return space;
+}
+
+/* The number of stored blocks after `head`, as far as the consumer knows,
+ * reloading `tail` only when the cached copy shows fewer than `count`. */
+static __nonulls size_t __spsc_stored(ring_buffer buf,
+	                              const size_t head,
+	                              const size_t count)
+{
+	size_t tail;
+	size_t stored;
+	struct ring_buffer_priv * priv = DS_PRIV(buf);
+
+	stored = __distance(buf, head, priv->tail_cache);
+	if(stored < count) {
+		tail   = __atomic_load_n(&priv->tail, __ATOMIC_ACQUIRE);
+		stored = __distance(buf, head, tail);
+		priv->tail_cache = tail;
+	}
+
+	return stored;
+}
+
+static __nonulls bool __spsc_push_tail(ring_buffer buf,
+	                               __immutable(void) data)
+{
+	size_t tail;
+
+	tail = __atomic_load_n(&DS_PRIV(buf)->tail, __ATOMIC_RELAXED);
+	if(__spsc_space(buf, tail, 1) == 0)
+		return false;
+
+	memcpy(__slot(buf, tail), data, DS_DATA_SIZE(buf));
+	__atomic_store_n(&DS_PRIV(buf)->tail,
+		         __advance(buf, tail, 1),
+		         __ATOMIC_RELEASE);
+
+	return true;
+}
+
+static __nonulls bool __spsc_pop_head_into(ring_buffer buf, void * data)
+{
+	size_t head;
+
+	head = __atomic_load_n(&DS_PRIV(buf)->head, __ATOMIC_RELAXED);
+	if(__spsc_stored(buf, head, 1) == 0)
+		return false;
+
+	memcpy(data, __slot(buf, head), DS_DATA_SIZE(buf));
+	__atomic_store_n(&DS_PRIV(buf)->head,
+		         __advance(buf, head, 1),
+		         __ATOMIC_RELEASE);
+
+	return true;
+}
+
+static __nonulls void * __spsc_pop_head(ring_buffer buf)
+{
+	void * data;
+
+	/* Only the consumer pops, so a non-empty buffer stays non-empty. */
+	if(__spsc_length(buf) <= 0)
+		return NULL;
+
+	malloc_rof(data, DS_DATA_SIZE(buf), NULL);
+	__spsc_pop_head_into(buf, data);
+
+	return data;
+}
+
+static __nonulls size_t __spsc_push_tail_n(ring_buffer buf,
+	                                   const void * data,
+	                                   const size_t count)
+{
+	size_t tail;
+	size_t pushed;
+
+	tail   = __atomic_load_n(&DS_PRIV(buf)->tail, __ATOMIC_RELAXED);
+	pushed = MIN(count, __spsc_space(buf, tail, count));
+
+	__copy_in(buf, tail, data, pushed);
+	__atomic_store_n(&DS_PRIV(buf)->tail,
+		         __advance(buf, tail, pushed),
+		         __ATOMIC_RELEASE);
+
+	return pushed;
+}
+
+static __nonulls size_t __spsc_pop_head_n(ring_buffer buf,
+	                                  void * data,
+	                                  const size_t count)
+{
+	size_t head;
+	size_t popped;
+
+	head   = __atomic_load_n(&DS_PRIV(buf)->head, __ATOMIC_RELAXED);
+	popped = MIN(count, __spsc_stored(buf, head, count));
+
+	__copy_out(buf, head, data, popped);
+	__atomic_store_n(&DS_PRIV(buf)->head,
+		         __advance(buf, head, popped),
+		         __ATOMIC_RELEASE);
+
+	return popped;
+}
+
+static __nonulls size_t __spsc_reserve(ring_buffer buf,
+	                               const size_t count,
+	                               struct rb_span span[2])
+{
+	size_t tail;
+	size_t reserved;
+
+	tail     = __atomic_load_n(&DS_PRIV(buf)->tail, __ATOMIC_RELAXED);
+	reserved = MIN(count, __spsc_space(buf, tail, count));
+	__spans(buf, tail, reserved, span);
+
+	return reserved;
+}
+
+static __nonulls void __spsc_commit(ring_buffer buf, const size_t count)
+{
+	size_t tail;
+
+	tail = __atomic_load_n(&DS_PRIV(buf)->tail, __ATOMIC_RELAXED);
+	__atomic_store_n(&DS_PRIV(buf)->tail,
+		         __advance(buf, tail, count),
+		         __ATOMIC_RELEASE);
+}
+
+static __nonulls size_t __spsc_peek(ring_buffer buf,
+	                            const size_t count,
+	                            struct rb_span span[2])
+{
+	size_t head;
+	size_t peeked;
+
+	head   = __atomic_load_n(&DS_PRIV(buf)->head, __ATOMIC_RELAXED);
+	peeked = MIN(count, __spsc_stored(buf, head, count));
+	__spans(buf, head, peeked, span);
+
+	return peeked;
+}
+
+static __nonulls void __spsc_release(ring_buffer buf, const size_t count)
+{
+	size_t head;
+
+	head = __atomic_load_n(&DS_PRIV(buf)->head, __ATOMIC_RELAXED);
+	__atomic_store_n(&DS_PRIV(buf)->head,
+		         __advance(buf, head, count),
+		         __ATOMIC_RELEASE);
+}
+
+/* The number of blocks from logical index `index` up to the physical end of
+ * the storage.  This deliberately ignores any mirror mapping: source and
+ * destination runs must be addressed through the same view of the storage
+ * for memmove() to see how they overlap. */
+static inline __pure __nonulls size_t __run_after(const ring_buffer buf,
+	                                          const size_t index)
+{
+	return __ENTRIES(buf) - __position(buf, index);
+}
+
+/* The number of blocks from the physical start of the storage up to, but not
+ * including, logical index `index`, wrapping to the whole storage at zero. */
+static inline __pure __nonulls size_t __run_before(const ring_buffer buf,
+	                                           const size_t index)
+{
+	return __position(buf, __retreat(buf, index, 1)) + 1;
+}
+
+/* Move the `count` blocks starting at index `start` one block towards the
+ * head.  Runs are split wherever the source or destination wraps, so this is
+ * at most three memmove() calls; they are made front to back, so no block is
+ * overwritten before it has been moved. */
+static __nonulls void __shift_forward(const ring_buffer buf,
+	                              const size_t start,
+	                              size_t count)
+{
+	size_t dst;
+	size_t src;
+	size_t run;
+	size_t size = DS_DATA_SIZE(buf);
+
+	src = __advance(buf, DS_PRIV(buf)->head, start);
+	dst = __retreat(buf, src, 1);
+	while(count > 0) {
+		run = MIN(count, __run_after(buf, src));
+		run = MIN(run, __run_after(buf, dst));
+		memmove(__slot(buf, dst), __slot(buf, src), run * size);
+
+		src = __advance(buf, src, run);
+		dst = __advance(buf, dst, run);
+		count -= run;
+	}
+}
+
+/* Move the `count` blocks starting at index `start` one block towards the
+ * tail, back to front, in at most three memmove() calls. */
+static __nonulls void __shift_backward(const ring_buffer buf,
+	                               const size_t start,
+	                               size_t count)
+{
+	size_t dst;
+	size_t src;
+	size_t run;
+	size_t size = DS_DATA_SIZE(buf);
+
+	src = __advance(buf, DS_PRIV(buf)->head, start + count);
+	dst = __advance(buf, src, 1);
+	while(count > 0) {
+		run = MIN(count, __run_before(buf, src));
+		run = MIN(run, __run_before(buf, dst));
+		src = __retreat(buf, src, run);
+		dst = __retreat(buf, dst, run);
+
+		memmove(__slot(buf, dst), __slot(buf, src), run * size);
+		count -= run;
+	}
+}
+
+/* Make room for a new block at `index` by moving the blocks on the shorter
+ * side of it outwards. */
+static __nonulls void __open_gap(ring_buffer buf, const size_t index)
+{
+	size_t length;
+
+	length = __LENGTH(buf);
+	if(index <= length - index) {
+		__shift_forward(buf, 0, index);
+		DS_PRIV(buf)->head = __retreat(buf, DS_PRIV(buf)->head, 1);
+	} else {
+		__shift_backward(buf, index, length - index);
+		DS_PRIV(buf)->tail = __advance(buf, DS_PRIV(buf)->tail, 1);
+	}
+}
+
+/* Shift the blocks on the shorter side of `index` over the top of it. */
+static __nonulls void __close_gap(ring_buffer buf, const size_t index)
+{
+	size_t length;
+
+	length = __LENGTH(buf);
+	if(index < length - 1 - index) {
+		__shift_backward(buf, 0, index);
+		DS_PRIV(buf)->head = __advance(buf, DS_PRIV(buf)->head, 1);
+	} else {
+		__shift_forward(buf, index + 1, length - 1 - index);
+		DS_PRIV(buf)->tail = __retreat(buf, DS_PRIV(buf)->tail, 1);
+	}
+}
+
+static __nonulls void __insert(ring_buffer buf,
+	                       const void * data,
+	                       const size_t index)
+{
+	void * addr;
+
+	if(!DS_OVERWRITE(buf))
+		__open_gap(buf, index);
+
+	addr = __index_to_addr(buf, index);
+	memcpy(addr, data, DS_DATA_SIZE(buf));
+}
+
+/* Remove the block at `index`, first copying it into `data` unless `data` is
+ * `NULL`. */
+static void __remove_into(ring_buffer buf, const size_t index, void * data)
+{
+	if(data)
+		memcpy(data, __index_to_addr(buf, index), DS_DATA_SIZE(buf));
+
+	__close_gap(buf, index);
+}
+
+static __nonulls void * __remove(ring_buffer buf, const size_t index)
+{
+	void * data;
+
+	malloc_rof(data, DS_DATA_SIZE(buf), NULL);
+	__remove_into(buf, index, data);
+
+	return data;
+}
+
+/* Reverse the `count` blocks starting at index `start` in place.  The two
+ * ends move inwards a contiguous run at a time, so each of the (at most
+ * three) runs is swapped by one call to mem_swap_reverse(). */
+static __nonulls void __reverse_range(ring_buffer buf,
+	                              const size_t start,
+	                              const size_t count)
+{
+	size_t front;
+	size_t back;
+	size_t run;
+	size_t pairs = count / 2;
+
+	front = __advance(buf, DS_PRIV(buf)->head, start);
+	back  = __advance(buf, front, count);
+	while(pairs > 0) {
+		run  = MIN(pairs, __run_after(buf, front));
+		run  = MIN(run, __run_before(buf, back));
+		back = __retreat(buf, back, run);
+
+		mem_swap_reverse(__slot(buf, front),
+		                 __slot(buf, back),
+		                 run,
+		                 DS_DATA_SIZE(buf));
+
+		front  = __advance(buf, front, run);
+		pairs -= run;
+	}
+}
+
+static __nonulls bool __reverse(ring_buffer buf)
+{
+	__reverse_range(buf, 0, __LENGTH(buf));
+	return true;
+}
+
+/* Copy `count` blocks from logical index `src` to logical index `dst`, a
+ * contiguous run at a time.  The two ranges must not overlap. */
+static __nonulls void __move(const ring_buffer buf,
+	                     size_t dst,
+	                     size_t src,
+	                     size_t count)
+{
+	size_t run;
+	size_t size = DS_DATA_SIZE(buf);
+
+	while(count > 0) {
+		run = MIN(count, __run_after(buf, src));
+		run = MIN(run, __run_after(buf, dst));
+		memcpy(__slot(buf, dst), __slot(buf, src), run * size);
+
+		src = __advance(buf, src, run);
+		dst = __advance(buf, dst, run);
+		count -= run;
+	}
+}
+
+/* Rotate `buf` so the block at index `k` becomes the head.  A full buffer's
+ * storage holds nothing but its contents, so only the indices move.
+ * Otherwise, if the free space can hold the shorter side of `k`, that side is
+ * copied across it; failing that, the buffer is rotated in place by three
+ * reversals. */
+static __nonulls void __rotate(ring_buffer buf, const size_t k)
+{
+	size_t length = __LENGTH(buf);
+	size_t space = __ENTRIES(buf) - length;
+	struct ring_buffer_priv * priv = DS_PRIV(buf);
+
+	if(k == 0)
+		return;
+
+	if(space == 0) {
+		priv->head = __advance(buf, priv->head, k);
+		priv->tail = __advance(buf, priv->tail, k);
+	} else if(k <= length - k && k <= space) {
+		__move(buf, priv->tail, priv->head, k);
+		priv->head = __advance(buf, priv->head, k);
+		priv->tail = __advance(buf, priv->tail, k);
+	} else if(length - k <= space) {
+		priv->head = __retreat(buf, priv->head, length - k);
+		priv->tail = __retreat(buf, priv->tail, length - k);
+		__move(buf, priv->head, priv->tail, length - k);
+	} else {
+		__reverse_range(buf, 0, k);
+		__reverse_range(buf, k, length - k);
+		__reverse_range(buf, 0, length);
+	}
+}
+
+static __nonulls void __map(const ring_buffer buf, const map_fn fn)
+{
+	void * current;
+
+	ring_buffer_foreach(buf, current)
+		fn(current);
+}
+
+static __pure __nonulls void * __foldr(const ring_buffer buf,
+	                               const foldr_fn fn,
+	                               const void * init)
+{
+	void * accumulator;
+	void * current;
+
+	malloc_rof(accumulator, DS_DATA_SIZE(buf), NULL);
+	memcpy(accumulator, init, DS_DATA_SIZE(buf));
+
+	ring_buffer_foreach(buf, current)
+		fn(current, accumulator);
+
+	return accumulator;
+}
+
+static __pure __nonulls void * __foldl(const ring_buffer buf,
+	                               const foldl_fn fn,
+	                               const void * init)
+{
+	void * accumulator;
+	void * current;
+
+	malloc_rof(accumulator, DS_DATA_SIZE(buf), NULL);
+	memcpy(accumulator, init, DS_DATA_SIZE(buf));
+
+	ring_buffer_foreach(buf, current)
+		fn(accumulator, current);
+
+	return accumulator;
+}
+
+static __pure __nonulls bool __any(const ring_buffer buf, const pred_fn pred)
+{
+	void * current;
+
+	ring_buffer_foreach(buf, current)
+		if(pred(current))
+			return true;
+
+	return false;
+}
+
+static __pure __nonulls bool __all(const ring_buffer buf, const pred_fn pred)
+{
+	void * current;
+
+	ring_buffer_foreach(buf, current)
+		if(!pred(current))
+			return false;
+
+	return (!__IS_EMPTY(buf));
+}
+
+static __nonulls void __filter(ring_buffer buf, const pred_fn pred)
+{
+	void * current;
+	size_t index;
+	size_t kept = 0;
+
+	/* Slide each block that satisfies `pred` down over the rejected ones,
+	 * keeping their order, then cut the tail off after the last of them. */
+	ring_buffer_foreach_i(buf, index, current) {
+		if(!pred(current))
+			continue;
+
+		if(kept != index)
+			memcpy(__index_to_addr(buf, kept),
+			       current,
+			       DS_DATA_SIZE(buf));
+		kept++;
+	}
+
+	DS_PRIV(buf)->tail = __advance(buf, DS_PRIV(buf)->head, kept);
+}
+
+static __nonulls void __drop_while(ring_buffer buf, const pred_fn pred)
+{
+	void * current;
+	size_t index;
+
+	ring_buffer_foreach_i(buf, index, current)
+		if(!pred(current))
+			break;
+
+	DS_PRIV(buf)->head = __advance(buf, DS_PRIV(buf)->head, index);
+}
+
+static __nonulls void __take_while(ring_buffer buf, const pred_fn pred)
+{
+	void * current;
+	size_t index;
+
+	ring_buffer_foreach_i(buf, index, current)
+		if(!pred(current))
+			break;
+
+	DS_PRIV(buf)->tail = __advance(buf, DS_PRIV(buf)->head, index);
+}
+
+static bool __has_space(const void * buf)
+{
+	return !rb_full((ring_buffer) buf);
+}
+
+static bool __has_data(const void * buf)
+{
+	return !rb_empty((ring_buffer) buf);
+}
+
+/* Map `size` bytes of anonymous shared memory twice, back to back, so that the
+ * second mapping mirrors the first. */
+static void * __map_mirror(const size_t size)
+{
+#ifdef MFD_CLOEXEC
+	int fd;
+	uint8_t * addr;
+	void * data = NULL;
+
+	fd = memfd_create("focs-ring-buffer", MFD_CLOEXEC);
+	if(fd < 0)
+		return NULL;
+
+	if(ftruncate(fd, size) < 0)
+		goto exit;
+
+	/* Reserve the whole range first, so nothing else can be mapped into the
+	 * gap between the two views. */
+	addr = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
+	            -1, 0);
+	if(addr == MAP_FAILED)
+		goto exit;
+
+	if(mmap(addr, size, PROT_READ | PROT_WRITE,
+	        MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+	   mmap(addr + size, size, PROT_READ | PROT_WRITE,
+	        MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		munmap(addr, 2 * size);
+		goto exit;
+	}
+
+	data = addr;
+
+exit:
+	close(fd);
+	return data;
+#else
+	(void) size;
+	return_with_errno(ENOTSUP, NULL);
+#endif
+}
+
+/* ################ *
+ * # Backing Files # *
+ * ################ */
+
+/* A file-backed buffer keeps its whole handle in the file, between a small
+ * header and the data blocks:
+ *
+ *   | header | handle | padding | data blocks ... |
+ *   0        __HANDLE_OFFSET    __data_offset()
+ *
+ * so `head`, `tail`, and `seq` are updated with ordinary stores into the
+ * shared mapping.  The handle's pointers and file descriptor are only
+ * meaningful to the process that mapped the file, and are reset each time it
+ * is opened. */
+
+#define __FILE_MAGIC    "FOCSRB\0\001"
+#define __HANDLE_OFFSET CACHE_LINE_SIZE
+
+struct __file_header {
+	char     magic[8];
+	uint64_t handle_size;
+	uint64_t data_size;
+	uint64_t entries;
+};
+
+static size_t __data_offset(void)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t end  = __HANDLE_OFFSET + sizeof(*(ring_buffer) NULL);
+
+	return (end + page - 1) / page * page;
+}
+
+static __nonulls size_t __file_size(const struct ds_properties * props)
+{
+	return __data_offset() + props->data_size * props->entries;
+}
+
+static __nonulls ring_buffer __file_handle(const void * base)
+{
+	return (ring_buffer) ((size_t) base + __HANDLE_OFFSET);
+}
+
+static __nonulls void * __file_base(const ring_buffer buf)
+{
+	return (void *) ((size_t) buf - __HANDLE_OFFSET);
+}
+
+/* Check that `header` and the handle `buf` describe a buffer shaped like
+ * `props`. */
+static __nonulls bool __file_valid(const struct __file_header * header,
+	                           const ring_buffer buf,
+	                           const char * magic,
+	                           const struct ds_properties * props)
+{
+	struct ring_buffer_priv * priv = DS_PRIV(buf);
+
+	if(memcmp(header->magic, magic, sizeof(header->magic)) != 0 ||
+	   header->handle_size != sizeof(*buf) ||
+	   header->data_size   != props->data_size ||
+	   header->entries     != props->entries)
+		return false;
+
+	if(priv->entries != props->entries ||
+	   priv->mask    != props->entries - 1 ||
+	   priv->pow2    != ((props->entries & priv->mask) == 0))
+		return false;
+
+	return __distance(buf, priv->head, priv->tail) <= props->entries;
+}
+
+/* Open and lock `props->path`, then map a new or recovered buffer from it. */
+static __nonulls ring_buffer __map_file(const struct ds_properties * props)
+{
+	int fd;
+	int err;
+	struct stat st;
+	struct __file_header * header;
+	struct ring_buffer_priv * priv;
+	ring_buffer buf;
+	void * base = MAP_FAILED;
+	size_t size = __file_size(props);
+	static const char blank[sizeof(header->magic)];
+
+	fd = open(props->path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if(fd < 0)
+		return NULL;
+
+	if(flock(fd, LOCK_EX | LOCK_NB) < 0 || fstat(fd, &st) < 0)
+		goto exit;
+	if(st.st_size != 0 && (size_t) st.st_size != size)
+		goto_with_errno(EINVAL, exit);
+	if(st.st_size == 0 && ftruncate(fd, size) < 0)
+		goto exit;
+
+	base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(base == MAP_FAILED)
+		goto exit;
+
+	header = base;
+	buf    = __file_handle(base);
+	priv   = DS_PRIV(buf);
+
+	if(memcmp(header->magic, blank, sizeof(blank)) == 0) {
+		/* A new file; the magic number is written last, so a crash
+		 * while laying the buffer out leaves the file blank. */
+		header->handle_size = sizeof(*buf);
+		header->data_size   = props->data_size;
+		header->entries     = props->entries;
+
+		priv->entries = props->entries;
+		priv->head    = 0;
+		priv->tail    = 0;
+		priv->mask    = priv->entries - 1;
+		priv->pow2    = (priv->entries & priv->mask) == 0;
+
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		memcpy(header->magic, __FILE_MAGIC, sizeof(header->magic));
+	} else if(!__file_valid(header, buf, __FILE_MAGIC, props)) {
+		goto_with_errno(EINVAL, exit);
+	}
+
+	/* A writer that crashed may have left `seq` odd, and the streams any
+	 * partial blocks came from are gone. */
+	priv->seq         = 0;
+	priv->head_cache  = priv->head;
+	priv->tail_cache  = priv->tail;
+	priv->partial_in  = 0;
+	priv->partial_out = 0;
+	priv->data        = (void *) ((size_t) base + __data_offset());
+	priv->fd          = fd;
+
+	return buf;
+
+exit:
+	err = errno;
+	if(base != MAP_FAILED)
+		munmap(base, size);
+	close(fd);
+	errno = err;
+
+	return NULL;
+}
+
+/* ######################### *
+ * # Shared Memory Segments # *
+ * ######################### */
+
+/* A shared buffer's segment holds the pointer-free part of its handle (from
+ * `entries` on), followed by a header and the data blocks:
+ *
+ *   | shared state | header | padding | data blocks ... |
+ *   0              __shm_header_offset() __shm_data_offset()
+ *
+ * Each process maps the segment just after a private page of its own, and
+ * places its handle so that `entries` falls on the start of the segment.  The
+ * process-local fields of the handle land in the private page, while `head`,
+ * `tail`, and the rest are the shared state itself, so the SPSC operations
+ * work on shared buffers unchanged. */
+
+#define __SHM_MAGIC     "FOCSRBS\001"
+#define __SHARED_OFFSET \
+	offsetof(typeof(*(ring_buffer) NULL), __DS_PRIV_NAME.entries)
+
+/* How many times to wait for another process to finish creating a segment. */
+#define __ATTACH_TRIES 1000
+
+static size_t __shm_header_offset(void)
+{
+	return sizeof(*(ring_buffer) NULL) - __SHARED_OFFSET;
+}
+
+static size_t __shm_data_offset(void)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t end  = __shm_header_offset() + sizeof(struct __file_header);
+
+	return (end + page - 1) / page * page;
+}
+
+static __nonulls size_t __shm_size(const struct ds_properties * props)
+{
+	return __shm_data_offset() + props->data_size * props->entries;
+}
+
+static __nonulls void * __shm_base(const ring_buffer buf)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+
+	return (void *) ((size_t) buf + __SHARED_OFFSET - page);
+}
+
+/* Wait for the creator of the segment open as `fd` to size it. */
+static bool __shm_sized(const int fd, const size_t size)
+{
+	struct stat st;
+
+	for(size_t try = 0; try < __ATTACH_TRIES; try++) {
+		if(fstat(fd, &st) < 0)
+			return false;
+		if((size_t) st.st_size == size)
+			return true;
+		if(st.st_size != 0)
+			return_with_errno(EINVAL, false);
+
+		sched_yield();
+	}
+
+	return_with_errno(EAGAIN, false);
+}
+
+/* Wait for the creator of a segment to lay out the buffer in it. */
+static __nonulls bool __shm_ready(const struct __file_header * header)
+{
+	static const char blank[sizeof(header->magic)];
+
+	for(size_t try = 0; try < __ATTACH_TRIES; try++) {
+		if(memcmp(header->magic, blank, sizeof(blank)) != 0) {
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			return true;
+		}
+
+		sched_yield();
+	}
+
+	return_with_errno(EAGAIN, false);
+}
+
+/* Create or attach to the shared memory segment `props->path`. */
+static __nonulls ring_buffer __map_shared(const struct ds_properties * props)
+{
+	int fd;
+	int err;
+	bool created = true;
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t size = __shm_size(props);
+	struct __file_header * header;
+	struct ring_buffer_priv * priv;
+	ring_buffer buf;
+	uint8_t * base = MAP_FAILED;
+
+	/* Whichever process creates the segment lays the buffer out in it. */
+	fd = shm_open(props->path, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if(fd < 0 && errno == EEXIST) {
+		created = false;
+		fd = shm_open(props->path, O_RDWR, 0600);
+	}
+	if(fd < 0)
+		return NULL;
+
+	if(created ? ftruncate(fd, size) < 0 : !__shm_sized(fd, size))
+		goto exit;
+
+	base = mmap(NULL, page + size, PROT_READ | PROT_WRITE,
+	            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(base == MAP_FAILED)
+		goto exit;
+	if(mmap(base + page, size, PROT_READ | PROT_WRITE,
+	        MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+		goto exit;
+
+	header = (struct __file_header *) (base + page + __shm_header_offset());
+	buf    = (ring_buffer) (base + page - __SHARED_OFFSET);
+	priv   = DS_PRIV(buf);
+
+	if(created) {
+		header->handle_size = sizeof(*buf);
+		header->data_size   = props->data_size;
+		header->entries     = props->entries;
+
+		priv->entries     = props->entries;
+		priv->head        = 0;
+		priv->tail        = 0;
+		priv->seq         = 0;
+		priv->head_cache  = 0;
+		priv->tail_cache  = 0;
+		priv->partial_in  = 0;
+		priv->partial_out = 0;
+		priv->mask        = priv->entries - 1;
+		priv->pow2        = (priv->entries & priv->mask) == 0;
+
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		memcpy(header->magic, __SHM_MAGIC, sizeof(header->magic));
+	} else if(!__shm_ready(header)) {
+		goto exit;
+	} else if(!__file_valid(header, buf, __SHM_MAGIC, props)) {
+		goto_with_errno(EINVAL, exit);
+	}
+
+	/* The mapping stays valid after the segment is closed. */
+	close(fd);
+	priv->data = base + page + __shm_data_offset();
+	priv->fd   = -1;
+
+	return buf;
+
+exit:
+	err = errno;
+	if(base != MAP_FAILED)
+		munmap(base, page + size);
+	close(fd);
+	errno = err;
+
+	return NULL;
+}
+
+ring_buffer rb_create(const struct ds_properties * props)
+{
+	ring_buffer buf;
+	struct ring_buffer_priv * priv;
+
+	if(props->entries == 0 || (props->spsc && props->overwrite))
+		return_with_errno(EINVAL, NULL);
+	if(props->growable &&
+	   (props->spsc || props->overwrite || props->mirror))
+		return_with_errno(EINVAL, NULL);
+	if(props->mirror &&
+	   (props->data_size * props->entries) % sysconf(_SC_PAGESIZE) != 0)
+		return_with_errno(EINVAL, NULL);
+
+	if(props->path && (props->mirror || props->growable))
+		return_with_errno(EINVAL, NULL);
+	if(props->shared && (!props->path || !props->spsc || props->blocking))
+		return_with_errno(EINVAL, NULL);
+
+	if(props->path) {
+		buf = props->shared ? __map_shared(props) : __map_file(props);
+		if(!buf)
+			return NULL;
+
+		DS_INIT(buf, props);
+		priv = DS_PRIV(buf);
+	} else {
+		/* The private area contains cache line aligned members,
+		 * so the buffer itself must be allocated with the same
+		 * alignment. */
+		buf = aligned_alloc(CACHE_LINE_SIZE, sizeof(*buf));
+		if(!buf)
+			return_with_errno(ENOMEM, NULL);
+
+		DS_INIT(buf, props);
+
+		/* Set up private data section. */
+		priv = DS_PRIV(buf);
+		priv->entries     = props->entries;
+		priv->data        = NULL;
+		priv->fd          = -1;
+		priv->head        = 0;
+		priv->tail        = 0;
+		priv->seq         = 0;
+		priv->head_cache  = 0;
+		priv->tail_cache  = 0;
+		priv->partial_in  = 0;
+		priv->partial_out = 0;
+		priv->mask        = priv->entries - 1;
+		priv->pow2        = (priv->entries & priv->mask) == 0;
+	}
+
+	priv->rwlock    = NULL;
+	priv->not_empty = NULL;
+	priv->not_full  = NULL;
+
+	if(DS_MIRROR(buf)) {
+		priv->data = __map_mirror(__SPACE(buf));
+		if(!priv->data)
+			goto exit;
+	} else if(!DS_PATH(buf)) {
+		priv->data = malloc(__SPACE(buf));
+		if(!priv->data)
+			goto_with_errno(ENOMEM, exit);
+	}
+
+	priv->rwlock = rwlock_create();
+	if(!priv->rwlock)
+		goto exit;
+
+	if(props->blocking) {
+		priv->not_empty = waitq_create();
+		if(!priv->not_empty)
+			goto exit;
+
+		priv->not_full = waitq_create();
+		if(!priv->not_full)
+			goto exit;
+	}
+
+	return buf;
 
-	return data;
+exit:
+	rb_destroy(&buf);
+	return NULL;
 }
 
-static __nonulls void * __shift_forward(const ring_buffer buf,
-	                                const size_t start,
-	                                const size_t end)
+void rb_destroy(ring_buffer * buf)
 {
-	void * dest;
-	void * front;
-	void * src;
+	int fd = DS_PRIV(*buf)->fd;
 
-	front = dest = __prev(buf, __index_to_addr(buf, start));
-	for(ssize_t i = start; i <= end; i++) {
-		src = __index_to_addr(buf, i);
-		memcpy(dest, src, DS_DATA_SIZE(buf));
-		dest = src;
+	/* Destroy the private data section. */
+	if(DS_MIRROR(*buf) && DS_PRIV(*buf)->data)
+		munmap(DS_PRIV(*buf)->data, 2 * __SPACE(*buf));
+	else if(!DS_PATH(*buf))
+		free_null(DS_PRIV(*buf)->data);
+	if(DS_PRIV(*buf)->rwlock)
+		rwlock_destroy(&DS_PRIV(*buf)->rwlock);
+	if(DS_PRIV(*buf)->not_empty)
+		waitq_destroy(&DS_PRIV(*buf)->not_empty);
+	if(DS_PRIV(*buf)->not_full)
+		waitq_destroy(&DS_PRIV(*buf)->not_full);
+
+	/* Deallocate the data structure.  The handle of a file-backed or
+	 * shared buffer lives in its mapping, so unmapping releases it. */
+	if(DS_SHARED(*buf)) {
+		munmap(__shm_base(*buf),
+		       sysconf(_SC_PAGESIZE) + __shm_size(DS_PROPS(*buf)));
+		*buf = NULL;
+	} else if(DS_PATH(*buf)) {
+		munmap(__file_base(*buf), __file_size(DS_PROPS(*buf)));
+		close(fd);
+		*buf = NULL;
+	} else {
+		DS_FREE(buf);
 	}
-
-	return front;
 }
 
-static __nonulls void * __shift_backward(const ring_buffer buf,
-	                                 const size_t start,
-	                                 const size_t end)
+ring_buffer rb_load(const char * path, const struct ds_properties * props)
 {
-	void * back;
-	void * dest;
-	void * src;
+	int fd;
+	int err;
+	bool quiet;
+	struct stat st;
+	ring_buffer src;
+	struct ring_buffer_priv * priv;
+	ring_buffer buf = NULL;
+	void * base = MAP_FAILED;
+	uint8_t * blocks = NULL;
+	size_t size = __file_size(props);
+	size_t seq = 0;
+	size_t head;
+	size_t tail;
+	size_t length;
+	size_t first;
+
+	if(props->path)
+		return_with_errno(EINVAL, NULL);
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+		return NULL;
+
+	if(fstat(fd, &st) < 0)
+		goto exit;
+	if((size_t) st.st_size != size)
+		goto_with_errno(EINVAL, exit);
 
-	back = dest = __next(buf, __index_to_addr(buf, end));
-	for(ssize_t i = end; i >= start; i--) {
-		src = __index_to_addr(buf, i);
-		memcpy(dest, src, DS_DATA_SIZE(buf));
-		dest = src;
+	base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	if(base == MAP_FAILED)
+		goto exit;
+	if(!__file_valid(base, __file_handle(base), __FILE_MAGIC, props))
+		goto_with_errno(EINVAL, exit);
+
+	malloc_gof(blocks, props->data_size * props->entries, exit);
+
+	/* If no process has the file open, it cannot change while it is copied.
+	 * Otherwise, copy it like an optimistic reader, retrying until no
+	 * writer interfered.  Checking `head` as well catches SPSC consumers,
+	 * which release blocks without touching `seq`.  A writer that crashed
+	 * mid-operation leaves `seq` odd for good, so while it is odd, keep
+	 * checking whether the file has been let go of. */
+	quiet = (flock(fd, LOCK_SH | LOCK_NB) == 0);
+	src   = __file_handle(base);
+	priv  = DS_PRIV(src);
+	for(;;) {
+		if(!quiet) {
+			seq = __atomic_load_n(&priv->seq, __ATOMIC_ACQUIRE);
+			if(seq & 1) {
+				quiet = (flock(fd, LOCK_SH | LOCK_NB) == 0);
+				if(!quiet) {
+					sched_yield();
+					continue;
+				}
+			}
+		}
+
+		head   = __atomic_load_n(&priv->head, __ATOMIC_RELAXED);
+		tail   = __atomic_load_n(&priv->tail, __ATOMIC_ACQUIRE);
+		length = MIN(__distance(src, head, tail), props->entries);
+		first  = MIN(length, props->entries - __position(src, head));
+
+		memcpy(blocks,
+		       (uint8_t *) base + __data_offset() +
+		       __position(src, head) * props->data_size,
+		       first * props->data_size);
+		memcpy(blocks + first * props->data_size,
+		       (uint8_t *) base + __data_offset(),
+		       (length - first) * props->data_size);
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if(quiet ||
+		   (__atomic_load_n(&priv->seq, __ATOMIC_RELAXED) == seq &&
+		    __atomic_load_n(&priv->head, __ATOMIC_RELAXED) == head))
+			break;
 	}
 
-	return back;
+	buf = rb_create(props);
+	if(buf)
+		rb_push_tail_n(buf, blocks, length);
+
+exit:
+	err = errno;
+	free(blocks);
+	if(base != MAP_FAILED)
+		munmap(base, size);
+	close(fd);
+	errno = err;
+
+	return buf;
 }
 
-static __nonulls void __open_gap(ring_buffer buf, const size_t index)
+bool rb_sync(const ring_buffer buf)
 {
-	size_t end;
-	void * mark;
+	if(!DS_PATH(buf) || DS_SHARED(buf))
+		return true;
 
-	end = DS_PRIV(buf)->length - 1;
-	if(index <= (end - index)) {
-		mark = __shift_forward(buf, 0, index);
-		DS_PRIV(buf)->head = mark;
-	} else {
-		mark = __shift_backward(buf, index, end);
-		DS_PRIV(buf)->tail = __next(buf, mark);
-	}
-
-	(DS_PRIV(buf)->length)++;
+	return msync(__file_base(buf), __file_size(DS_PROPS(buf)),
+	             MS_SYNC) == 0;
 }
 
-static __nonulls void __close_gap(ring_buffer buf, const size_t index)
+bool rb_reserve_capacity(ring_buffer buf, const size_t entries)
 {
-	size_t end;
+	bool success = true;
+	size_t added = 0;
 
-	end = DS_PRIV(buf)->length - 1;
-	if(index <= (end - index)) {
-		__shift_backward(buf, 0, index);
-		DS_PRIV(buf)->head = __next(buf, DS_PRIV(buf)->head);
-	} else {
-		__shift_forward(buf, index, end);
-		DS_PRIV(buf)->tail = __prev(buf, DS_PRIV(buf)->tail);
+	if(!DS_GROWABLE(buf))
+		return_with_errno(EINVAL, false);
+
+	__writer_entry(buf);
+	if(entries > __ENTRIES(buf)) {
+		added = entries - __ENTRIES(buf);
+		success = __resize(buf, entries);
 	}
+	__writer_exit(buf);
 
-	(DS_PRIV(buf)->length)--;
+	__wake_producers(buf, success ? added : 0);
+	return success;
 }
 
-static __nonulls void __insert(ring_buffer buf,
-	                       const void * data,
-	                       const size_t index)
+bool rb_shrink_to_fit(ring_buffer buf)
 {
-	void * addr;
+	bool success = true;
+	size_t length;
 
-	if(!DS_OVERWRITE(buf))
-		__open_gap(buf, index);
+	if(!DS_GROWABLE(buf))
+		return_with_errno(EINVAL, false);
 
-	addr = __index_to_addr(buf, index);
-	memcpy(addr, data, DS_DATA_SIZE(buf));
+	__writer_entry(buf);
+	length = __LENGTH(buf) + (DS_PRIV(buf)->partial_in != 0);
+	length = MAX(length, (size_t) 1);
+	if(length < __ENTRIES(buf))
+		success = __resize(buf, length);
+	__writer_exit(buf);
+
+	return success;
 }
 
-static __nonulls void * __remove(ring_buffer buf,
-	                         const size_t index,
-	                         const bool keep)
+size_t rb_capacity(const ring_buffer buf)
 {
-	void * addr;
-	void * data = NULL;
-
-	if(keep) {
-		addr = __index_to_addr(buf, index);
-		malloc_rof(data, DS_DATA_SIZE(buf), NULL);
-		memcpy(data, addr, DS_DATA_SIZE(buf));
-	}
-
-	__close_gap(buf, index);
-
-	return data;
+	return __atomic_load_n(&DS_PRIV(buf)->entries, __ATOMIC_RELAXED);
 }
 
-static __pure __nonulls void * __fetch(const ring_buffer buf,
-	                               const size_t index)
+size_t rb_size(const ring_buffer buf)
 {
-	void * addr;
-	void * data;
+	size_t size;
 
-	malloc_rof(data, DS_DATA_SIZE(buf), NULL);
-	addr = __index_to_addr(buf, index);
-	memcpy(data, addr, DS_DATA_SIZE(buf));
+	if(DS_SPSC(buf))
+		return __spsc_length(buf);
 
-	return data;
+	__read_optimistic(buf, size = __snapshot_length(buf));
+
+	return size;
 }
 
-static __nonulls bool __reverse(ring_buffer buf)
+bool rb_empty(const ring_buffer buf)
 {
-	void * sa1;
-	void * sa2;
-	void * tmp;
+	return (rb_size(buf) <= 0);
+}
 
-	malloc_rof(tmp, DS_DATA_SIZE(buf), false);
+bool rb_full(const ring_buffer buf)
+{
+	return (rb_size(buf) >= rb_capacity(buf));
+}
 
-	for(size_t i = 0; i < __LENGTH(buf) / 2; i++) {
-		sa1 = __index_to_addr(buf, i);
-		sa2 = __index_to_addr(buf, __LENGTH(buf) - 1 - i);
+bool rb_elem(const ring_buffer buf, const void * data)
+{
+	bool success;
 
-		memcpy(tmp, sa1, DS_DATA_SIZE(buf));
-		memcpy(sa1, sa2, DS_DATA_SIZE(buf));
-		memcpy(sa2, tmp, DS_DATA_SIZE(buf));
+	if(DS_GROWABLE(buf)) {
+		rwlock_reader_entry(DS_PRIV(buf)->rwlock);
+		success = __snapshot_elem(buf, data);
+		rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+	} else {
+		__read_optimistic(buf, success = __snapshot_elem(buf, data));
 	}
 
-	free_null(tmp);
-	return true;
+	return success;
 }
 
-static __nonulls void __map(const ring_buffer buf, const map_fn fn)
+bool rb_push_head(ring_buffer buf, const void * data)
 {
-	void * current;
+	bool success = false;
 
-	ring_buffer_foreach(buf, current)
-		fn(current);
+	__writer_entry(buf);
+	__grow(buf, 1);
+	if(!__IS_FULL(buf) || DS_OVERWRITE(buf)) {
+		__push_head(buf, data);
+		success = true;
+	}
+	__writer_exit(buf);
+
+	__wake_consumers(buf, success);
+	return success;
 }
 
-static __pure __nonulls void * __foldr(const ring_buffer buf,
-	                               const foldr_fn fn,
-	                               const void * init)
+bool rb_push_tail(ring_buffer buf, const void * data)
 {
-	void * accumulator;
-	void * current;
-
-	malloc_rof(accumulator, DS_DATA_SIZE(buf), NULL);
-	memcpy(accumulator, init, DS_DATA_SIZE(buf));
+	bool success = false;
 
-	ring_buffer_foreach(buf, current)
-		fn(current, accumulator);
+	if(DS_SPSC(buf)) {
+		success = __spsc_push_tail(buf, data);
+	} else {
+		__writer_entry(buf);
+		__grow(buf, 1);
+		if(!__IS_FULL(buf) || DS_OVERWRITE(buf)) {
+			__push_tail(buf, data);
+			success = true;
+		}
+		__writer_exit(buf);
+	}
 
-	return accumulator;
+	__wake_consumers(buf, success);
+	return success;
 }
 
-static __pure __nonulls void * __foldl(const ring_buffer buf,
-	                               const foldl_fn fn,
-	                               const void * init)
+void * rb_pop_head(ring_buffer buf)
 {
-	void * accumulator;
-	void * current;
-
-	malloc_rof(accumulator, DS_DATA_SIZE(buf), NULL);
-	memcpy(accumulator, init, DS_DATA_SIZE(buf));
+	void * data = NULL;
 
-	ring_buffer_foreach(buf, current)
-		fn(accumulator, current);
+	if(DS_SPSC(buf)) {
+		data = __spsc_pop_head(buf);
+	} else {
+		__writer_entry(buf);
+		if(!__IS_EMPTY(buf))
+			data = __pop_head(buf);
+		__writer_exit(buf);
+	}
 
-	return accumulator;
+	__wake_producers(buf, !!data);
+	return data;
 }
 
-static __pure __nonulls bool __any(const ring_buffer buf, const pred_fn pred)
+void * rb_pop_tail(ring_buffer buf)
 {
-	void * current;
+	void * data = NULL;
 
-	ring_buffer_foreach(buf, current)
-		if(pred(current))
-			return true;
+	__writer_entry(buf);
+	if(!__IS_EMPTY(buf))
+		data = __pop_tail(buf);
+	__writer_exit(buf);
 
-	return false;
+	__wake_producers(buf, !!data);
+	return data;
 }
 
-static __pure __nonulls bool __all(const ring_buffer buf, const pred_fn pred)
+size_t rb_push_head_n(ring_buffer buf, const void * data, const size_t count)
 {
-	void * current;
+	size_t pushed;
 
-	ring_buffer_foreach(buf, current)
-		if(!pred(current))
-			return false;
+	__writer_entry(buf);
+	__grow(buf, count);
+	pushed = __push_head_n(buf, data, count);
+	__writer_exit(buf);
 
-	return (!__IS_EMPTY(buf));
+	__wake_consumers(buf, pushed);
+	return pushed;
 }
 
-static __nonulls void __filter(ring_buffer buf, const pred_fn pred)
+size_t rb_push_tail_n(ring_buffer buf, const void * data, const size_t count)
 {
-	void * current;
-	size_t index;
+	size_t pushed;
 
-	ring_buffer_foreach_i(buf, index, current)
-		if(!pred(current))
-			__remove(buf, index, false);
+	if(DS_SPSC(buf)) {
+		pushed = __spsc_push_tail_n(buf, data, count);
+	} else {
+		__writer_entry(buf);
+		__grow(buf, count);
+		pushed = __push_tail_n(buf, data, count);
+		__writer_exit(buf);
+	}
+
+	__wake_consumers(buf, pushed);
+	return pushed;
 }
 
-static __nonulls void __drop_while(ring_buffer buf, const pred_fn pred)
+size_t rb_pop_head_n(ring_buffer buf, void * data, const size_t count)
 {
-	void * current;
-	size_t index;
-
-	ring_buffer_foreach_i(buf, index, current) {
-		if(!pred(current))
-			break;
+	size_t popped;
 
-		__remove(buf, index, false);
+	if(DS_SPSC(buf)) {
+		popped = __spsc_pop_head_n(buf, data, count);
+	} else {
+		__writer_entry(buf);
+		popped = __pop_head_n(buf, data, count);
+		__writer_exit(buf);
 	}
+
+	__wake_producers(buf, popped);
+	return popped;
 }
 
-static __nonulls void __take_while(ring_buffer buf, const pred_fn pred)
+size_t rb_pop_tail_n(ring_buffer buf, void * data, const size_t count)
 {
-	void * current;
-	size_t index;
-	bool passover = true;
+	size_t popped;
 
-	ring_buffer_foreach_i(buf, index, current) {
-		if(!pred(current))
-			passover = false;
+	__writer_entry(buf);
+	popped = __pop_tail_n(buf, data, count);
+	__writer_exit(buf);
 
-		if(!passover)
-			__remove(buf, index, false);
-	}
+	__wake_producers(buf, popped);
+	return popped;
 }
 
-ring_buffer rb_create(const struct ds_properties * props)
+size_t rb_reserve(ring_buffer buf, const size_t count, struct rb_span span[2])
 {
-	ring_buffer buf;
-	struct ring_buffer_priv * priv;
-
-	DS_ALLOC(buf);
-	if(!buf)
-		return_with_errno(ENOMEM, NULL);
+	size_t reserved;
 
-	DS_INIT(buf, props);
+	if(DS_SPSC(buf))
+		return __spsc_reserve(buf, count, span);
 
-	/* Set up private data section. */
-	priv = DS_PRIV(buf);
-	priv->data = malloc(__SPACE(buf));
-	if(!priv->data)
-		goto_with_errno(ENOMEM, exit);
+	/* The lock is held until the matching rb_commit(). */
+	__writer_entry(buf);
+	__grow(buf, count);
+	reserved = MIN(count, __ENTRIES(buf) - __LENGTH(buf));
+	__spans(buf, DS_PRIV(buf)->tail, reserved, span);
 
-	priv->head = priv->data;
-	priv->tail = priv->data;
-	priv->length = 0;
+	return reserved;
+}
 
-	priv->rwlock = rwlock_create();
-	if(!priv->rwlock)
-		goto exit;
+void rb_commit(ring_buffer buf, const size_t count)
+{
+	size_t committed;
+	struct ring_buffer_priv * priv = DS_PRIV(buf);
 
-	return buf;
+	if(DS_SPSC(buf)) {
+		committed = count;
+		__spsc_commit(buf, committed);
+	} else {
+		committed = MIN(count, __ENTRIES(buf) - __LENGTH(buf));
+		priv->tail = __advance(buf, priv->tail, committed);
+		__writer_exit(buf);
+	}
 
-exit:
-	rb_destroy(&buf);
-	return NULL;
+	__wake_consumers(buf, committed);
 }
 
-void rb_destroy(ring_buffer * buf)
+size_t rb_peek(ring_buffer buf, const size_t count, struct rb_span span[2])
 {
-	/* Destroy the private data section. */
-	free_null(DS_PRIV(*buf)->data);
-	rwlock_destroy(&DS_PRIV(*buf)->rwlock);
+	size_t peeked;
+
+	if(DS_SPSC(buf))
+		return __spsc_peek(buf, count, span);
+
+	/* The lock is held until the matching rb_release(). */
+	__writer_entry(buf);
+	peeked = MIN(count, __LENGTH(buf));
+	__spans(buf, DS_PRIV(buf)->head, peeked, span);
 
-	/* Deallocate the data structure. */
-	DS_FREE(buf);
+	return peeked;
 }
 
-size_t rb_size(const ring_buffer buf)
+void rb_release(ring_buffer buf, const size_t count)
 {
-	size_t size;
+	size_t released;
+	struct ring_buffer_priv * priv = DS_PRIV(buf);
 
-	rwlock_reader_entry(DS_PRIV(buf)->rwlock);
-	size = __LENGTH(buf);
-	rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+	if(DS_SPSC(buf)) {
+		released = count;
+		__spsc_release(buf, released);
+	} else {
+		released = MIN(count, __LENGTH(buf));
+		priv->head = __advance(buf, priv->head, released);
+		__writer_exit(buf);
+	}
 
-	return size;
+	__wake_producers(buf, released);
 }
 
-bool rb_empty(const ring_buffer buf)
+/* Describe the bytes of `span` after the first `skip` as I/O vectors. */
+static __nonulls int __iovecs(const ring_buffer buf,
+	                      const struct rb_span span[2],
+	                      const size_t skip,
+	                      struct iovec iov[2])
 {
-	bool success;
-
-	rwlock_reader_entry(DS_PRIV(buf)->rwlock);
-	success = __IS_EMPTY(buf);
-	rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+	iov[0].iov_base = (void *) ((size_t) span[0].data + skip);
+	iov[0].iov_len  = span[0].count * DS_DATA_SIZE(buf) - skip;
+	iov[1].iov_base = span[1].data;
+	iov[1].iov_len  = span[1].count * DS_DATA_SIZE(buf);
 
-	return success;
+	return span[1].count ? 2 : 1;
 }
 
-bool rb_full(const ring_buffer buf)
+ssize_t rb_read_fd(ring_buffer buf, const int fd, const size_t count)
 {
-	bool success;
+	struct rb_span span[2];
+	struct iovec iov[2];
+	size_t partial;
+	ssize_t bytes;
+	int err;
+
+	/* A partly read block is already inside the reserved space. */
+	if(!rb_reserve(buf, MAX(count, (size_t) 1), span)) {
+		rb_commit(buf, 0);
+		return_with_errno(ENOBUFS, -1);
+	}
 
-	rwlock_reader_entry(DS_PRIV(buf)->rwlock);
-	success = __IS_FULL(buf);
-	rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+	partial = DS_PRIV(buf)->partial_in;
+	bytes   = readv(fd, iov, __iovecs(buf, span, partial, iov));
+	if(bytes < 0) {
+		err = errno;
+		rb_commit(buf, 0);
+		return_with_errno(err, -1);
+	}
 
-	return success;
+	partial += bytes;
+	DS_PRIV(buf)->partial_in = partial % DS_DATA_SIZE(buf);
+	rb_commit(buf, partial / DS_DATA_SIZE(buf));
+
+	return bytes;
 }
 
-bool rb_elem(const ring_buffer buf, const void * data)
+ssize_t rb_write_fd(ring_buffer buf, const int fd, const size_t count)
 {
-	bool success;
+	struct rb_span span[2];
+	struct iovec iov[2];
+	size_t partial;
+	ssize_t bytes;
+	int err;
+
+	if(!rb_peek(buf, MAX(count, (size_t) 1), span)) {
+		rb_release(buf, 0);
+		return 0;
+	}
 
-	rwlock_reader_entry(DS_PRIV(buf)->rwlock);
-	success = __elem(buf, data);
-	rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+	partial = DS_PRIV(buf)->partial_out;
+	bytes   = writev(fd, iov, __iovecs(buf, span, partial, iov));
+	if(bytes < 0) {
+		err = errno;
+		rb_release(buf, 0);
+		return_with_errno(err, -1);
+	}
 
-	return success;
+	partial += bytes;
+	DS_PRIV(buf)->partial_out = partial % DS_DATA_SIZE(buf);
+	rb_release(buf, partial / DS_DATA_SIZE(buf));
+
+	return bytes;
 }
 
-bool rb_push_head(ring_buffer buf, const void * data)
+bool rb_pop_head_into(ring_buffer buf, void * data)
 {
 	bool success = false;
 
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
-	if(!__IS_FULL(buf) || DS_OVERWRITE(buf)) {
-		__push_head(buf, data);
-		success = true;
+	if(DS_SPSC(buf)) {
+		success = __spsc_pop_head_into(buf, data);
+	} else {
+		__writer_entry(buf);
+		if(!__IS_EMPTY(buf)) {
+			__pop_head_into(buf, data);
+			success = true;
+		}
+		__writer_exit(buf);
 	}
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
 
+	__wake_producers(buf, success);
 	return success;
 }
 
-bool rb_push_tail(ring_buffer buf, const void * data)
+bool rb_pop_tail_into(ring_buffer buf, void * data)
 {
 	bool success = false;
 
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
-	if(!__IS_FULL(buf) || DS_OVERWRITE(buf)) {
-		__push_tail(buf, data);
+	__writer_entry(buf);
+	if(!__IS_EMPTY(buf)) {
+		__pop_tail_into(buf, data);
 		success = true;
 	}
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	__writer_exit(buf);
 
+	__wake_producers(buf, success);
 	return success;
 }
 
-void * rb_pop_head(ring_buffer buf)
+bool rb_push_tail_wait(ring_buffer buf,
+	               const void * data,
+	               const struct timespec * timeout)
 {
-	void * data = NULL;
+	struct timespec deadline;
 
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
-	if(!__IS_EMPTY(buf))
-		data = __pop_head(buf);
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	if(!DS_BLOCKING(buf))
+		return_with_errno(EINVAL, false);
+	if(timeout)
+		waitq_deadline(&deadline, timeout);
 
-	return data;
+	while(!rb_push_tail(buf, data)) {
+		if(!waitq_wait(DS_PRIV(buf)->not_full, __has_space, buf,
+		               timeout ? &deadline : NULL))
+			return_with_errno(ETIMEDOUT, false);
+	}
+
+	return true;
 }
 
-void * rb_pop_tail(ring_buffer buf)
+bool rb_pop_head_wait(ring_buffer buf,
+	              void * data,
+	              const struct timespec * timeout)
 {
-	void * data = NULL;
+	struct timespec deadline;
 
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
-	if(!__IS_EMPTY(buf))
-		data = __pop_tail(buf);
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	if(!DS_BLOCKING(buf))
+		return_with_errno(EINVAL, false);
+	if(timeout)
+		waitq_deadline(&deadline, timeout);
 
-	return data;
+	while(!rb_pop_head_into(buf, data)) {
+		if(!waitq_wait(DS_PRIV(buf)->not_empty, __has_data, buf,
+		               timeout ? &deadline : NULL))
+			return_with_errno(ETIMEDOUT, false);
+	}
+
+	return true;
 }
 
 bool rb_insert(ring_buffer buf, const void * data, const ssize_t pos)
 {
 	bool success = false;
 
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+	__writer_entry(buf);
+	__grow(buf, 1);
 	if(!__IS_FULL(buf) || DS_OVERWRITE(buf)) {
 		__insert(buf, data, __INDEX_ABS(buf, pos));
 		success = true;
 	}
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	__writer_exit(buf);
 
+	__wake_consumers(buf, success);
 	return success;
 }
 
@@ -459,13 +1905,14 @@ bool rb_delete(ring_buffer buf, const ssize_t pos)
 {
 	bool success = false;
 
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+	__writer_entry(buf);
 	if(!__IS_EMPTY(buf)) {
-		__remove(buf, __INDEX_ABS(buf, pos), false);
+		__remove_into(buf, __INDEX_ABS(buf, pos), NULL);
 		success = true;
 	}
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	__writer_exit(buf);
 
+	__wake_producers(buf, success);
 	return success;
 }
 
@@ -473,42 +1920,80 @@ void * rb_remove(ring_buffer buf, const ssize_t pos)
 {
 	void * data = NULL;
 
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+	__writer_entry(buf);
 	if(!__IS_EMPTY(buf))
-		data = __remove(buf, __INDEX_ABS(buf, pos), true);
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+		data = __remove(buf, __INDEX_ABS(buf, pos));
+	__writer_exit(buf);
 
+	__wake_producers(buf, !!data);
 	return data;
 }
 
+bool rb_remove_into(ring_buffer buf, const ssize_t pos, void * data)
+{
+	bool success = false;
+
+	__writer_entry(buf);
+	if(!__IS_EMPTY(buf)) {
+		__remove_into(buf, __INDEX_ABS(buf, pos), data);
+		success = true;
+	}
+	__writer_exit(buf);
+
+	__wake_producers(buf, success);
+	return success;
+}
+
 void * rb_fetch(const ring_buffer buf, const ssize_t pos)
 {
-	void * data = NULL;
+	void * data;
 
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
-	if(!__IS_EMPTY(buf))
-		data = __fetch(buf, __INDEX_ABS(buf, pos));
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	malloc_rof(data, DS_DATA_SIZE(buf), NULL);
+	if(!rb_fetch_into(buf, pos, data))
+		free_null(data);
 
 	return data;
 }
 
+bool rb_fetch_into(const ring_buffer buf, const ssize_t pos, void * data)
+{
+	bool success;
+
+	if(DS_GROWABLE(buf)) {
+		rwlock_reader_entry(DS_PRIV(buf)->rwlock);
+		success = __snapshot_fetch(buf, pos, data);
+		rwlock_reader_exit(DS_PRIV(buf)->rwlock);
+	} else {
+		__read_optimistic(buf,
+		                  success = __snapshot_fetch(buf, pos, data));
+	}
+
+	return success;
+}
+
 bool rb_reverse(ring_buffer buf)
 {
 	bool success;
 
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+	__writer_entry(buf);
 	success = __reverse(buf);
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	__writer_exit(buf);
 
 	return success;
 }
 
+void rb_rotate(ring_buffer buf, const ssize_t k)
+{
+	__writer_entry(buf);
+	__rotate(buf, __INDEX_ABS(buf, k));
+	__writer_exit(buf);
+}
+
 void rb_map(ring_buffer buf, const map_fn fn)
 {
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+	__writer_entry(buf);
 	__map(buf, fn);
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	__writer_exit(buf);
 }
 
 void * rb_foldr(const ring_buffer buf, const foldr_fn fn, const void * init)
@@ -557,23 +2042,41 @@ bool rb_all(const ring_buffer buf, const pred_fn pred)
 
 void rb_filter(ring_buffer buf, const pred_fn pred)
 {
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+	size_t removed;
+
+	__writer_entry(buf);
+	removed = __LENGTH(buf);
 	__filter(buf, pred);
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	removed -= __LENGTH(buf);
+	__writer_exit(buf);
+
+	__wake_producers(buf, removed);
 }
 
 void rb_drop_while(ring_buffer buf, const pred_fn pred)
 {
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+	size_t removed;
+
+	__writer_entry(buf);
+	removed = __LENGTH(buf);
 	__drop_while(buf, pred);
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	removed -= __LENGTH(buf);
+	__writer_exit(buf);
+
+	__wake_producers(buf, removed);
 }
 
 void rb_take_while(ring_buffer buf, const pred_fn pred)
 {
-	rwlock_writer_entry(DS_PRIV(buf)->rwlock);
+	size_t removed;
+
+	__writer_entry(buf);
+	removed = __LENGTH(buf);
 	__take_while(buf, pred);
-	rwlock_writer_exit(DS_PRIV(buf)->rwlock);
+	removed -= __LENGTH(buf);
+	__writer_exit(buf);
+
+	__wake_producers(buf, removed);
 }
 
 #ifdef DEBUG
@@ -589,7 +2092,7 @@ void rb_dump(const ring_buffer buf)
 
 	priv = DS_PRIV(buf);
 
-	printf("Buffer length: %ld", priv->length);
+	printf("Buffer length: %lu", __LENGTH(buf));
 	if(__IS_EMPTY(buf))
 		puts(" (empty)\n");
 	else if(__IS_FULL(buf))
@@ -608,9 +2111,9 @@ void rb_dump(const ring_buffer buf)
 
 		if(addr == priv->data)
 			printf(" <data>");
-		if(addr == priv->head)
+		if(addr == __slot(buf, priv->head))
 			printf(" (head)");
-		if(addr == priv->tail)
+		if(addr == __slot(buf, priv->tail))
 			printf(" (tail)");
 
 		putchar('\n');
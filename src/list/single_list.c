@@ -20,25 +20,53 @@
 
 #include "list/single_list.h"
 
-static struct sl_element * __create_element(const void * data,
-	                                    const size_t data_size)
+/* Each element holds its data inline; the elements of a pooled list come
+ * from its pool rather than from malloc(). */
+static struct sl_element * __create_element(const single_list list,
+	                                    const void * data)
 {
 	struct sl_element * elem;
 
-	elem = malloc(sizeof(*elem));
-	if(!elem)
-		return_with_errno(ENOMEM, NULL);
-
-	elem->data = malloc(data_size);
-	if(!elem->data)
-		goto_with_errno(ENOMEM, exit);
+	if(DS_POOLED(list)) {
+		elem = pool_alloc(DS_PRIV(list)->pool);
+		if(!elem)
+			return NULL;
+	} else {
+		malloc_rof(elem, sizeof(*elem) + DS_DATA_SIZE(list), NULL);
+	}
 
-	memcpy(elem->data, data, data_size);
+	memcpy(elem->data, data, DS_DATA_SIZE(list));
 	return elem;
+}
 
-exit:
-	free(elem);
-	return NULL;
+static void __free_element(const single_list list, struct sl_element * elem)
+{
+	if(DS_POOLED(list))
+		pool_free(DS_PRIV(list)->pool, elem);
+	else
+		free(elem);
+}
+
+/* Release `elem`, but hand its data to the caller in memory the caller can
+ * free().  A malloc()ed element is reused for this by moving its data to the
+ * start of it; a pooled element's data has to be copied out of the pool. */
+static void * __take_data(const single_list list, struct sl_element * elem)
+{
+	void * data;
+
+	if(!elem)
+		return NULL;
+
+	if(DS_POOLED(list)) {
+		data = malloc(DS_DATA_SIZE(list));
+		if(data)
+			memcpy(data, elem->data, DS_DATA_SIZE(list));
+		pool_free(DS_PRIV(list)->pool, elem);
+	} else {
+		data = memmove(elem, elem->data, DS_DATA_SIZE(list));
+	}
+
+	return data;
 }
 
 bool __elem(single_list list, const void * data)
@@ -52,19 +80,53 @@ bool __elem(single_list list, const void * data)
 	return false;
 }
 
+/* Readers may look up elements concurrently, so a lookup only uses and moves
+ * the finger if no other lookup is using it.  Writers always get it. */
+static inline bool __finger_grab(const single_list list)
+{
+	return !__atomic_test_and_set(&DS_PRIV(list)->finger_busy,
+	                              __ATOMIC_ACQUIRE);
+}
+
+static inline void __finger_drop(const single_list list)
+{
+	__atomic_clear(&DS_PRIV(list)->finger_busy, __ATOMIC_RELEASE);
+}
+
 static struct sl_element * __lookup(const single_list list, const size_t pos)
 {
+	struct single_list_priv * priv = DS_PRIV(list);
 	struct sl_element * current;
+	size_t i;
+	bool finger;
 
 	if(pos >= DS_PRIV(list)->length)
 		return NULL;
 
-	size_t i;
-	linked_list_foreach_i(list, current, i)
-		if(i == pos)
-			return current;
+	if(pos == DS_PRIV(list)->length - 1)
+		return __TAIL(list);
 
-	return NULL;
+	/* Elements can only be reached going forward, so start from the finger
+	 * if it is not past `pos`. */
+	current = __HEAD(list);
+	i = 0;
+
+	finger = __finger_grab(list);
+	if(finger && priv->finger && priv->finger_pos <= pos) {
+		current = priv->finger;
+		i = priv->finger_pos;
+	}
+
+	for(; i < pos; i++)
+		current = current->next;
+
+	if(finger) {
+		priv->finger = current;
+		priv->finger_pos = pos;
+		__finger_drop(list);
+	}
+
+	return current;
 }
 
 static void __push_head(single_list list, struct sl_element * current)
@@ -75,6 +137,7 @@ static void __push_head(single_list list, struct sl_element * current)
 	if(!__TAIL(list))
 		__TAIL(list) = current;
 
+	DS_PRIV(list)->finger_pos++;
 	(DS_PRIV(list)->length)++;
 }
 
@@ -105,6 +168,9 @@ static struct sl_element * __pop_head(single_list list)
 	if(!__HEAD(list))
 		__TAIL(list) = NULL;
 
+	if(DS_PRIV(list)->finger == current)
+		DS_PRIV(list)->finger = NULL;
+	DS_PRIV(list)->finger_pos--;
 	(DS_PRIV(list)->length)--;
 
 	return current;
@@ -119,7 +185,7 @@ static struct sl_element * __pop_tail(single_list list)
 		return NULL;
 
 	/* Find the previous element. */
-	linked_list_while(list, prev, prev->next != __TAIL(list)) {}
+	prev = __lookup(list, DS_PRIV(list)->length - 2);
 
 	current = __TAIL(list);
 	__TAIL(list) = prev;
@@ -129,6 +195,8 @@ static struct sl_element * __pop_tail(single_list list)
 	else
 		__HEAD(list) = NULL;
 
+	if(DS_PRIV(list)->finger == current)
+		DS_PRIV(list)->finger = NULL;
 	(DS_PRIV(list)->length)--;
 
 	return current;
@@ -185,6 +253,8 @@ static void __delete(single_list list, struct sl_element * elem)
 {
 	struct sl_element * prev;
 
+	DS_PRIV(list)->finger = NULL;
+
 	linked_list_while(list, prev, prev->next != elem) {}
 
 	/* Fix head and tail. */
@@ -203,9 +273,10 @@ static void __delete_before(single_list list, struct sl_element * mark)
 {
 	struct sl_element * current;
 
+	DS_PRIV(list)->finger = NULL;
+
 	linked_list_while_safe(list, current, current != mark) {
-		free(current->data);
-		free(current);
+		__free_element(list, current);
 
 		(DS_PRIV(list)->length)--;
 	}
@@ -220,10 +291,11 @@ static void __delete_after(single_list list, struct sl_element * mark)
 	bool passover = true;
 	struct sl_element * current;
 
+	DS_PRIV(list)->finger = NULL;
+
 	linked_list_foreach_safe(list, current) {
 		if(!passover || !mark) {
-			free(current->data);
-			free(current);
+			__free_element(list, current);
 
 			(DS_PRIV(list)->length)--;
 		}
@@ -241,6 +313,7 @@ static void __delete_after(single_list list, struct sl_element * mark)
 
 void __reverse(single_list list)
 {
+	struct single_list_priv * priv = DS_PRIV(list);
 	struct sl_element * current;
 	struct sl_element * tmp = NULL;
 
@@ -253,6 +326,21 @@ void __reverse(single_list list)
 	tmp = __HEAD(list);
 	__HEAD(list) = __TAIL(list);
 	__TAIL(list) = tmp;
+	priv->finger_pos = __LENGTH(list) - 1 - priv->finger_pos;
+}
+
+/* Copy the data carried by `current` into `data`, then release `current`. */
+static bool __extract(const single_list list,
+	              struct sl_element * current,
+	              void * data)
+{
+	if(!current)
+		return false;
+
+	memcpy(data, current->data, DS_DATA_SIZE(list));
+	__free_element(list, current);
+
+	return true;
 }
 
 single_list sl_create(const struct ds_properties * props)
@@ -271,11 +359,22 @@ single_list sl_create(const struct ds_properties * props)
 	priv->head = NULL;
 	priv->tail = NULL;
 	priv->length = 0;
+	priv->finger = NULL;
+	priv->finger_pos = 0;
+	priv->finger_busy = false;
+	priv->pool = NULL;
 
         priv->rwlock = rwlock_create();
         if(!priv->rwlock)
                 goto exit;
 
+	if(DS_POOLED(list)) {
+		priv->pool = pool_create(sizeof(struct sl_element) +
+		                         DS_DATA_SIZE(list));
+		if(!priv->pool)
+			goto exit;
+	}
+
 	return list;
 
 exit:
@@ -289,9 +388,12 @@ void sl_destroy(single_list * list)
 
 	rwlock_writer_entry(DS_PRIV(*list)->rwlock);
 
-	linked_list_foreach_safe(*list, current) {
-		free(current->data);
-		free(current);
+	/* A pool releases all of its elements at once. */
+	if(DS_PRIV(*list)->pool) {
+		pool_destroy(&DS_PRIV(*list)->pool);
+	} else {
+		linked_list_foreach_safe(*list, current)
+			__free_element(*list, current);
 	}
 
 	rwlock_writer_exit(DS_PRIV(*list)->rwlock);
@@ -337,10 +439,10 @@ void sl_push_head(single_list list, const void * data)
 {
 	struct sl_element * current;
 
-	current = __create_element(data, DS_DATA_SIZE(list));
-
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	__push_head(list, current);
+	current = __create_element(list, data);
+	if(current)
+		__push_head(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 }
 
@@ -348,10 +450,10 @@ void sl_push_tail(single_list list, const void * data)
 {
 	struct sl_element * current;
 
-	current = __create_element(data, DS_DATA_SIZE(list));
-
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	__push_tail(list, current);
+	current = __create_element(list, data);
+	if(current)
+		__push_tail(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 }
 
@@ -362,13 +464,9 @@ void * sl_pop_head(single_list list)
 
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
 	current = __pop_head(list);
+	data = __take_data(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		data = current->data;
-		free(current);
-	}
-
 	return data;
 }
 
@@ -379,46 +477,64 @@ void * sl_pop_tail(single_list list)
 
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
 	current = __pop_tail(list);
+	data = __take_data(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		data = current->data;
-		free(current);
-	}
-
 	return data;
 }
 
-bool sl_insert(single_list list, const void * data, const size_t pos)
+bool sl_pop_head_into(single_list list, void * data)
 {
 	bool success;
 	struct sl_element * current;
 
-	current = __create_element(data, DS_DATA_SIZE(list));
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	current = __pop_head(list);
+	success = __extract(list, current, data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool sl_pop_tail_into(single_list list, void * data)
+{
+	bool success;
+	struct sl_element * current;
 
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	success = __insert(list, current, pos);
+	current = __pop_tail(list);
+	success = __extract(list, current, data);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
 	return success;
 }
 
-bool sl_delete(single_list list, const size_t pos)
+bool sl_insert(single_list list, const void * data, const size_t pos)
 {
+	bool success;
 	struct sl_element * current;
 
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
-	current = __remove(list, pos);
+	current = __create_element(list, data);
+	success = current && __insert(list, current, pos);
+	if(current && !success)
+		__free_element(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		free(current->data);
-		free(current);
+	return success;
+}
+
+bool sl_delete(single_list list, const size_t pos)
+{
+	struct sl_element * current;
 
-		return true;
-	}
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	current = __remove(list, pos);
+	if(current)
+		__free_element(list, current);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	return false;
+	return current != NULL;
 }
 
 void * sl_remove(single_list list, const size_t pos)
@@ -428,16 +544,25 @@ void * sl_remove(single_list list, const size_t pos)
 
 	rwlock_writer_entry(DS_PRIV(list)->rwlock);
 	current = __remove(list, pos);
+	data = __take_data(list, current);
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
-	if(current) {
-		data = current->data;
-		free(current);
-	}
-
 	return data;
 }
 
+bool sl_remove_into(single_list list, const size_t pos, void * data)
+{
+	bool success;
+	struct sl_element * current;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	current = __remove(list, pos);
+	success = __extract(list, current, data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
 void * sl_fetch(single_list list, const size_t pos)
 {
 	struct sl_element * current;
@@ -560,11 +685,13 @@ bool sl_filter(single_list list, const pred_fn pred)
 			changed = true;
 
 			__delete(list, current);
-			free(current->data);
-			free(current);
+			__free_element(list, current);
 		}
 	}
 
+	if(changed && DS_PRIV(list)->pool)
+		pool_trim(DS_PRIV(list)->pool);
+
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
 	return changed;
@@ -592,6 +719,9 @@ bool sl_drop_while(single_list list, const pred_fn pred)
 		__delete_before(list, NULL);
 	}
 
+	if(DS_PRIV(list)->pool && orig_length != DS_PRIV(list)->length)
+		pool_trim(DS_PRIV(list)->pool);
+
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
 	return (orig_length != DS_PRIV(list)->length);
@@ -618,6 +748,9 @@ bool sl_take_while(single_list list, const pred_fn pred)
 		prev = current;
 	}
 
+	if(DS_PRIV(list)->pool && orig_length != DS_PRIV(list)->length)
+		pool_trim(DS_PRIV(list)->pool);
+
 	rwlock_writer_exit(DS_PRIV(list)->rwlock);
 
 	return (orig_length != DS_PRIV(list)->length);
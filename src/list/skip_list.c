@@ -0,0 +1,658 @@
+/* skip_list.c - Indexable Skip List Implementation
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "list/skip_list.h"
+
+/* Positions here count the front of the list as zero, so the element at index
+ * `i` is at position `i + 1`.  Level zero links every element in order; each
+ * higher level links a quarter of the nodes of the level below, on average.
+ * A search walks forward along the highest level while the next node's
+ * position, the sum of the spans walked so far, is not past the target, and
+ * then drops down a level. */
+
+#define SEED 0x9e3779b97f4a7c15ULL
+
+#define __LEVEL(list)  (DS_PRIV(list)->level)
+#define __LENGTH(list) (DS_PRIV(list)->length)
+
+/* A node's links follow its data, aligned for the links. */
+static inline __pure size_t __links_offset(const skip_list list)
+{
+	size_t offset = DS_DATA_SIZE(list);
+
+	return offset + -offset % alignof(struct sk_link);
+}
+
+static inline __pure struct sk_link * __links(const skip_list list,
+	                                      const struct sk_node * node)
+{
+	return (struct sk_link *) (node->data + __links_offset(list));
+}
+
+/* Advance through the elements of a skip list in order. */
+#define __foreach(list, node)                         \
+	for(node = DS_PRIV(list)->head[0].next;       \
+	    node;                                     \
+	    node = __links(list, node)[0].next)
+
+/* Pick a new node's number of levels: each level after the first with
+ * probability one quarter. */
+static size_t __random_level(const skip_list list)
+{
+	uint64_t x = DS_PRIV(list)->seed;
+
+	/* xorshift64* */
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	DS_PRIV(list)->seed = x;
+	x *= 0x2545f4914f6cdd1dULL;
+
+	return 1 + __builtin_ctzll(x | (1ULL << (2 * (SK_MAX_LEVEL - 1)))) / 2;
+}
+
+static struct sk_node * __create_node(const skip_list list,
+	                              const void * data,
+	                              const size_t levels)
+{
+	struct sk_node * node;
+	size_t size = sizeof(*node) + __links_offset(list);
+
+	malloc_rof(node, size + levels * sizeof(struct sk_link), NULL);
+
+	node->levels = levels;
+	memcpy(node->data, data, DS_DATA_SIZE(list));
+
+	return node;
+}
+
+/* Find the links leading into position `pos` at each level, and the position
+ * each set of links belongs to. */
+static void __predecessors(const skip_list list,
+	                   const size_t pos,
+	                   struct sk_link * update[SK_MAX_LEVEL],
+	                   size_t rank[SK_MAX_LEVEL])
+{
+	struct sk_link * links = DS_PRIV(list)->head;
+	size_t traversed = 0;
+
+	for(size_t l = __LEVEL(list); l-- > 0;) {
+		while(links[l].next && traversed + links[l].span < pos) {
+			traversed += links[l].span;
+			links = __links(list, links[l].next);
+		}
+
+		update[l] = links;
+		rank[l]   = traversed;
+	}
+}
+
+static struct sk_node * __fetch(const skip_list list, const size_t pos)
+{
+	struct sk_link * links = DS_PRIV(list)->head;
+	struct sk_node * node = NULL;
+	size_t traversed = 0;
+
+	if(pos >= __LENGTH(list))
+		return NULL;
+
+	for(size_t l = __LEVEL(list); l-- > 0;) {
+		while(links[l].next && traversed + links[l].span <= pos + 1) {
+			traversed += links[l].span;
+			node  = links[l].next;
+			links = __links(list, node);
+		}
+
+		if(traversed == pos + 1)
+			break;
+	}
+
+	return node;
+}
+
+static bool __insert(skip_list list, const void * data, const size_t pos)
+{
+	struct sk_link * update[SK_MAX_LEVEL];
+	size_t rank[SK_MAX_LEVEL];
+	struct sk_link * links;
+	struct sk_node * node;
+	size_t levels;
+	size_t l;
+
+	if(pos > __LENGTH(list))
+		return false;
+
+	levels = __random_level(list);
+	node = __create_node(list, data, levels);
+	if(!node)
+		return false;
+
+	__predecessors(list, pos + 1, update, rank);
+
+	/* New levels start out empty, spanning the whole list. */
+	for(l = __LEVEL(list); l < levels; l++) {
+		DS_PRIV(list)->head[l].next = NULL;
+		DS_PRIV(list)->head[l].span = __LENGTH(list) + 1;
+		update[l] = DS_PRIV(list)->head;
+		rank[l]   = 0;
+	}
+	__LEVEL(list) = MAX(__LEVEL(list), levels);
+
+	/* The new node takes position `pos + 1`, and everything after it moves
+	 * up one. */
+	links = __links(list, node);
+	for(l = 0; l < levels; l++) {
+		links[l].next = update[l][l].next;
+		links[l].span = update[l][l].span - (pos - rank[l]);
+
+		update[l][l].next = node;
+		update[l][l].span = pos - rank[l] + 1;
+	}
+
+	for(; l < __LEVEL(list); l++)
+		update[l][l].span++;
+
+	__LENGTH(list)++;
+	return true;
+}
+
+/* Remove the element at index `pos`, copying it into `data` first unless
+ * `data` is `NULL`. */
+static bool __remove(skip_list list, const size_t pos, void * data)
+{
+	struct sk_link * update[SK_MAX_LEVEL];
+	size_t rank[SK_MAX_LEVEL];
+	struct sk_link * links;
+	struct sk_node * node;
+
+	if(pos >= __LENGTH(list))
+		return false;
+
+	__predecessors(list, pos + 1, update, rank);
+	node  = update[0][0].next;
+	links = __links(list, node);
+
+	for(size_t l = 0; l < __LEVEL(list); l++) {
+		if(update[l][l].next == node) {
+			update[l][l].next  = links[l].next;
+			update[l][l].span += links[l].span - 1;
+		} else {
+			update[l][l].span--;
+		}
+	}
+
+	while(__LEVEL(list) > 1 && !DS_PRIV(list)->head[__LEVEL(list) - 1].next)
+		__LEVEL(list)--;
+
+	__LENGTH(list)--;
+
+	if(data)
+		memcpy(data, node->data, DS_DATA_SIZE(list));
+	free(node);
+
+	return true;
+}
+
+/* Remove the element at index `pos` and return a copy the caller can free(). */
+static void * __take(skip_list list, const size_t pos)
+{
+	void * data;
+
+	if(pos >= __LENGTH(list))
+		return NULL;
+
+	malloc_rof(data, DS_DATA_SIZE(list), NULL);
+	__remove(list, pos, data);
+
+	return data;
+}
+
+/* Rebuild every level above level zero, and the length, from the elements
+ * linked at level zero.  Operations that rearrange or remove many elements at
+ * once only fix up level zero, then call this. */
+static void __relink(skip_list list)
+{
+	struct sk_link * last[SK_MAX_LEVEL];
+	size_t last_rank[SK_MAX_LEVEL];
+	struct sk_link * links;
+	struct sk_node * node;
+	size_t level = 1;
+	size_t rank = 0;
+
+	for(size_t l = 0; l < SK_MAX_LEVEL; l++) {
+		last[l]      = DS_PRIV(list)->head;
+		last_rank[l] = 0;
+	}
+
+	for(node = DS_PRIV(list)->head[0].next; node; node = links[0].next) {
+		links = __links(list, node);
+		rank++;
+
+		for(size_t l = 0; l < node->levels; l++) {
+			last[l][l].next = node;
+			last[l][l].span = rank - last_rank[l];
+			last[l]         = links;
+			last_rank[l]    = rank;
+		}
+
+		level = MAX(level, node->levels);
+	}
+
+	for(size_t l = 0; l < level; l++) {
+		last[l][l].next = NULL;
+		last[l][l].span = rank + 1 - last_rank[l];
+	}
+
+	__LEVEL(list)  = level;
+	__LENGTH(list) = rank;
+}
+
+/* Free every node from `node` onwards along level zero. */
+static void __free_from(const skip_list list, struct sk_node * node)
+{
+	struct sk_node * next;
+
+	for(; node; node = next) {
+		next = __links(list, node)[0].next;
+		free(node);
+	}
+}
+
+static bool __elem(const skip_list list, const void * data)
+{
+	struct sk_node * node;
+
+	__foreach(list, node)
+		if(DS_DATA_EQ(list, node->data, data))
+			return true;
+
+	return false;
+}
+
+/* Determine if `pred` returns `result` for some element of `list`. */
+static bool __find(const skip_list list, const pred_fn pred, const bool result)
+{
+	struct sk_node * node;
+
+	__foreach(list, node)
+		if(pred(node->data) == result)
+			return true;
+
+	return false;
+}
+
+skip_list sk_create(const struct ds_properties * props)
+{
+	skip_list list;
+	struct skip_list_priv * priv;
+
+	list = malloc(sizeof(*list));
+	if(!list)
+		return_with_errno(ENOMEM, NULL);
+
+	DS_INIT(list, props);
+
+	/* Private Area Initialization */
+	priv = DS_PRIV(list);
+	priv->head[0].next = NULL;
+	priv->head[0].span = 1;
+	priv->level = 1;
+	priv->length = 0;
+	priv->seed = SEED;
+
+	priv->rwlock = rwlock_create();
+	if(!priv->rwlock) {
+		free(list);
+		return NULL;
+	}
+
+	return list;
+}
+
+void sk_destroy(skip_list * list)
+{
+	rwlock_writer_entry(DS_PRIV(*list)->rwlock);
+	__free_from(*list, DS_PRIV(*list)->head[0].next);
+	rwlock_writer_exit(DS_PRIV(*list)->rwlock);
+	rwlock_destroy(&DS_PRIV(*list)->rwlock);
+
+	DS_FREE(list);
+}
+
+bool sk_empty(const skip_list list)
+{
+	bool empty;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	empty = __LENGTH(list) == 0;
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return empty;
+}
+
+size_t sk_size(const skip_list list)
+{
+	size_t length;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	length = __LENGTH(list);
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return length;
+}
+
+bool sk_elem(const skip_list list, const void * data)
+{
+	bool success;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	success = __elem(list, data);
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+void sk_push_head(skip_list list, const void * data)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	__insert(list, data, 0);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void sk_push_tail(skip_list list, const void * data)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	__insert(list, data, __LENGTH(list));
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void * sk_pop_head(skip_list list)
+{
+	void * data;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	data = __take(list, 0);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return data;
+}
+
+void * sk_pop_tail(skip_list list)
+{
+	void * data;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	data = __take(list, __LENGTH(list) - 1);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return data;
+}
+
+bool sk_pop_head_into(skip_list list, void * data)
+{
+	bool success;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	success = __remove(list, 0, data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool sk_pop_tail_into(skip_list list, void * data)
+{
+	bool success;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	success = __remove(list, __LENGTH(list) - 1, data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool sk_insert(skip_list list, const void * data, const size_t pos)
+{
+	bool success;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	success = __insert(list, data, pos);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool sk_delete(skip_list list, const size_t pos)
+{
+	bool success;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	success = __remove(list, pos, NULL);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+void * sk_remove(skip_list list, const size_t pos)
+{
+	void * data;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	data = __take(list, pos);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return data;
+}
+
+bool sk_remove_into(skip_list list, const size_t pos, void * data)
+{
+	bool success;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	success = __remove(list, pos, data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+void * sk_fetch(skip_list list, const size_t pos)
+{
+	struct sk_node * node;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	node = __fetch(list, pos);
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	if(node)
+		return node->data;
+
+	return NULL;
+}
+
+void sk_reverse(skip_list list)
+{
+	struct sk_link * links;
+	struct sk_node * node;
+	struct sk_node * next;
+	struct sk_node * prev = NULL;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	for(node = DS_PRIV(list)->head[0].next; node; node = next) {
+		links = __links(list, node);
+		next = links[0].next;
+		links[0].next = prev;
+		prev = node;
+	}
+
+	DS_PRIV(list)->head[0].next = prev;
+	__relink(list);
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void sk_map(skip_list list, const map_fn fn)
+{
+	struct sk_node * node;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	__foreach(list, node)
+		fn(node->data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void * sk_foldr(const skip_list list, const foldr_fn fn, const void * init)
+{
+	void * accumulator;
+	struct sk_node * node;
+
+	accumulator = malloc(DS_DATA_SIZE(list));
+	memcpy(accumulator, init, DS_DATA_SIZE(list));
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	__foreach(list, node)
+		fn(node->data, accumulator);
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return accumulator;
+}
+
+void * sk_foldl(const skip_list list, const foldl_fn fn, const void * init)
+{
+	void * accumulator;
+	struct sk_node * node;
+
+	accumulator = malloc(DS_DATA_SIZE(list));
+	memcpy(accumulator, init, DS_DATA_SIZE(list));
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	__foreach(list, node)
+		fn(accumulator, node->data);
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return accumulator;
+}
+
+bool sk_any(skip_list list, const pred_fn pred)
+{
+	bool success;
+
+	if(sk_empty(list))
+		return false;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	success = __find(list, pred, true);
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool sk_all(skip_list list, const pred_fn pred)
+{
+	bool success;
+
+	if(sk_empty(list))
+		return false;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	success = !__find(list, pred, false);
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool sk_filter(skip_list list, const pred_fn pred)
+{
+	bool changed = false;
+	struct sk_link * prev;
+	struct sk_node * node;
+	struct sk_node * next;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	prev = DS_PRIV(list)->head;
+	for(node = prev[0].next; node; node = next) {
+		next = __links(list, node)[0].next;
+
+		if(pred(node->data)) {
+			prev = __links(list, node);
+		} else {
+			prev[0].next = next;
+			free(node);
+			changed = true;
+		}
+	}
+
+	if(changed)
+		__relink(list);
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return changed;
+}
+
+bool sk_drop_while(skip_list list, const pred_fn pred)
+{
+	bool changed = false;
+	struct sk_node * node;
+	struct sk_node * next;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	node = DS_PRIV(list)->head[0].next;
+	while(node && pred(node->data)) {
+		next = __links(list, node)[0].next;
+		free(node);
+
+		node = next;
+		changed = true;
+	}
+
+	if(changed) {
+		DS_PRIV(list)->head[0].next = node;
+		__relink(list);
+	}
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return changed;
+}
+
+bool sk_take_while(skip_list list, const pred_fn pred)
+{
+	struct sk_link * prev;
+	struct sk_node * node;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	/* Find the first element that doesn't satisfy the predicate; delete
+	 * that element and every one after. */
+	prev = DS_PRIV(list)->head;
+	for(node = prev[0].next; node && pred(node->data); node = prev[0].next)
+		prev = __links(list, node);
+
+	if(node) {
+		prev[0].next = NULL;
+		__free_from(list, node);
+		__relink(list);
+	}
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return node != NULL;
+}
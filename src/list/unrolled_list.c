@@ -0,0 +1,772 @@
+/* unrolled_list.c - Unrolled Linked List Implementation
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "focs/block.h"
+#include "list/unrolled_list.h"
+
+/* Every node but the head and tail is kept at least half full: a full node is
+ * split in two before inserting into it, and a node that drops below half
+ * full after a removal absorbs the next node if their elements fit together.
+ * Pushing to either end of the list fills the end node before starting a new
+ * one, so lists built by pushing have full nodes. */
+
+#define __CAPACITY(list) (DS_PRIV(list)->capacity)
+
+static inline __pure void * __at(const unrolled_list list,
+	                         const struct ul_node * node,
+	                         const size_t i)
+{
+	return (void *) (node->data + i * DS_DATA_SIZE(list));
+}
+
+static struct ul_node * __create_node(const unrolled_list list)
+{
+	struct ul_node * node;
+
+	if(DS_POOLED(list)) {
+		node = pool_alloc(DS_PRIV(list)->pool);
+		if(!node)
+			return NULL;
+	} else {
+		malloc_rof(node,
+		           sizeof(*node) +
+		           __CAPACITY(list) * DS_DATA_SIZE(list),
+		           NULL);
+	}
+
+	node->next  = NULL;
+	node->count = 0;
+
+	return node;
+}
+
+static void __free_node(const unrolled_list list, struct ul_node * node)
+{
+	if(DS_POOLED(list))
+		pool_free(DS_PRIV(list)->pool, node);
+	else
+		free(node);
+}
+
+/* Unlink and free `node`, which follows `prev` (or is the head if `prev` is
+ * `NULL`). */
+static void __unlink(unrolled_list list,
+	             struct ul_node * prev,
+	             struct ul_node * node)
+{
+	if(prev)
+		prev->next = node->next;
+	else
+		__HEAD(list) = node->next;
+
+	if(__TAIL(list) == node)
+		__TAIL(list) = prev;
+
+	__free_node(list, node);
+}
+
+/* Free every node after `last`, or every node if `last` is `NULL`. */
+static void __truncate(unrolled_list list, struct ul_node * last)
+{
+	struct ul_node * node;
+	struct ul_node * next;
+
+	for(node = last ? last->next : __HEAD(list); node; node = next) {
+		next = node->next;
+		DS_PRIV(list)->length -= node->count;
+		__free_node(list, node);
+	}
+
+	__TAIL(list) = last;
+	if(last)
+		last->next = NULL;
+	else
+		__HEAD(list) = NULL;
+}
+
+/* Find the node holding position `pos`, and the index of `pos` within it.
+ * `prev` is set to the node before it.  If `pos` is the length of the list,
+ * `NULL` is returned and `prev` is the tail. */
+static struct ul_node * __locate(const unrolled_list list,
+	                         size_t pos,
+	                         size_t * index,
+	                         struct ul_node ** prev)
+{
+	struct ul_node * node;
+
+	*prev = NULL;
+	linked_list_foreach(list, node) {
+		if(pos < node->count)
+			break;
+
+		pos   -= node->count;
+		*prev  = node;
+	}
+
+	*index = pos;
+	return node;
+}
+
+/* Copy `data` into `node` at `index`, which must be at most `node->count`.
+ * The node must not be full. */
+static void __insert_at(unrolled_list list,
+	                struct ul_node * node,
+	                const size_t index,
+	                const void * data)
+{
+	memmove(__at(list, node, index + 1),
+	        __at(list, node, index),
+	        (node->count - index) * DS_DATA_SIZE(list));
+	memcpy(__at(list, node, index), data, DS_DATA_SIZE(list));
+
+	node->count++;
+	DS_PRIV(list)->length++;
+}
+
+/* Move the upper half of a full node's elements into a new node after it. */
+static struct ul_node * __split(unrolled_list list, struct ul_node * node)
+{
+	struct ul_node * next;
+	size_t keep = node->count / 2;
+
+	next = __create_node(list);
+	if(!next)
+		return NULL;
+
+	next->count = node->count - keep;
+	memcpy(next->data,
+	       __at(list, node, keep),
+	       next->count * DS_DATA_SIZE(list));
+	node->count = keep;
+
+	next->next = node->next;
+	node->next = next;
+	if(__TAIL(list) == node)
+		__TAIL(list) = next;
+
+	return next;
+}
+
+/* Absorb the node after `node` if `node` is less than half full and both
+ * nodes' elements fit in one. */
+static void __merge(unrolled_list list, struct ul_node * node)
+{
+	struct ul_node * next = node->next;
+
+	if(!next || node->count >= __CAPACITY(list) / 2 ||
+	   node->count + next->count > __CAPACITY(list))
+		return;
+
+	memcpy(__at(list, node, node->count),
+	       next->data,
+	       next->count * DS_DATA_SIZE(list));
+	node->count += next->count;
+
+	__unlink(list, node, next);
+}
+
+static bool __push_head(unrolled_list list, const void * data)
+{
+	struct ul_node * node = __HEAD(list);
+
+	if(!node || node->count == __CAPACITY(list)) {
+		node = __create_node(list);
+		if(!node)
+			return false;
+
+		node->next = __HEAD(list);
+		__HEAD(list) = node;
+		if(!__TAIL(list))
+			__TAIL(list) = node;
+	}
+
+	__insert_at(list, node, 0, data);
+	return true;
+}
+
+static bool __push_tail(unrolled_list list, const void * data)
+{
+	struct ul_node * node = __TAIL(list);
+
+	if(!node || node->count == __CAPACITY(list)) {
+		node = __create_node(list);
+		if(!node)
+			return false;
+
+		if(__TAIL(list))
+			__TAIL(list)->next = node;
+		__TAIL(list) = node;
+		if(!__HEAD(list))
+			__HEAD(list) = node;
+	}
+
+	__insert_at(list, node, node->count, data);
+	return true;
+}
+
+static bool __insert(unrolled_list list, const void * data, const size_t pos)
+{
+	struct ul_node * node;
+	struct ul_node * prev;
+	struct ul_node * next;
+	size_t index;
+
+	if(pos > DS_PRIV(list)->length)
+		return false;
+
+	node = __locate(list, pos, &index, &prev);
+	if(!node)
+		return __push_tail(list, data);
+
+	if(index == 0 && prev && prev->count < __CAPACITY(list)) {
+		/* Between two nodes; append to the first if it has room. */
+		node  = prev;
+		index = prev->count;
+	} else if(node->count == __CAPACITY(list)) {
+		next = __split(list, node);
+		if(!next)
+			return false;
+
+		if(index > node->count) {
+			index -= node->count;
+			node   = next;
+		}
+	}
+
+	__insert_at(list, node, index, data);
+	return true;
+}
+
+/* Remove the element at `pos`, copying it into `data` first unless `data` is
+ * `NULL`. */
+static bool __remove(unrolled_list list, const size_t pos, void * data)
+{
+	struct ul_node * node;
+	struct ul_node * prev;
+	size_t index;
+
+	if(pos >= DS_PRIV(list)->length)
+		return false;
+
+	node = __locate(list, pos, &index, &prev);
+	if(data)
+		memcpy(data, __at(list, node, index), DS_DATA_SIZE(list));
+
+	memmove(__at(list, node, index),
+	        __at(list, node, index + 1),
+	        (node->count - index - 1) * DS_DATA_SIZE(list));
+
+	node->count--;
+	DS_PRIV(list)->length--;
+
+	if(node->count == 0)
+		__unlink(list, prev, node);
+	else
+		__merge(list, node);
+
+	return true;
+}
+
+/* Remove the element at `pos` and return a copy the caller can free(). */
+static void * __take(unrolled_list list, const size_t pos)
+{
+	void * data;
+
+	if(pos >= DS_PRIV(list)->length)
+		return NULL;
+
+	malloc_rof(data, DS_DATA_SIZE(list), NULL);
+	__remove(list, pos, data);
+
+	return data;
+}
+
+static bool __elem(const unrolled_list list, const void * data)
+{
+	struct ul_node * node;
+
+	linked_list_foreach(list, node)
+		for(size_t i = 0; i < node->count; i++)
+			if(DS_DATA_EQ(list, __at(list, node, i), data))
+				return true;
+
+	return false;
+}
+
+/* Determine if `pred` returns `result` for some element of `list`. */
+static bool __find(const unrolled_list list,
+	           const pred_fn pred,
+	           const bool result)
+{
+	struct ul_node * node;
+
+	linked_list_foreach(list, node)
+		for(size_t i = 0; i < node->count; i++)
+			if(pred(__at(list, node, i)) == result)
+				return true;
+
+	return false;
+}
+
+static void __reverse(unrolled_list list)
+{
+	struct ul_node * node;
+	struct ul_node * tmp = NULL;
+	size_t half;
+
+	linked_list_foreach_safe(list, node) {
+		half = node->count / 2;
+		mem_swap_reverse(node->data,
+		                 __at(list, node, node->count - half),
+		                 half,
+		                 DS_DATA_SIZE(list));
+
+		node->next = tmp;
+		tmp = node;
+	}
+
+	/* Swap the list head and tail */
+	tmp = __HEAD(list);
+	__HEAD(list) = __TAIL(list);
+	__TAIL(list) = tmp;
+}
+
+unrolled_list ul_create(const struct ds_properties * props)
+{
+	unrolled_list list;
+	struct unrolled_list_priv * priv;
+
+	if(props->data_size == 0)
+		return_with_errno(EINVAL, NULL);
+
+	list = malloc(sizeof(*list));
+	if(!list)
+		return_with_errno(ENOMEM, NULL);
+
+	DS_INIT(list, props);
+
+	/* Private Area Initialization */
+	priv = DS_PRIV(list);
+	priv->head = NULL;
+	priv->tail = NULL;
+	priv->length = 0;
+	priv->capacity = MAX(CACHE_LINE_SIZE / DS_DATA_SIZE(list),
+	                     (size_t) UL_MIN_CAPACITY);
+	priv->pool = NULL;
+
+	priv->rwlock = rwlock_create();
+	if(!priv->rwlock)
+		goto exit;
+
+	if(DS_POOLED(list)) {
+		priv->pool = pool_create(sizeof(struct ul_node) +
+		                         priv->capacity * DS_DATA_SIZE(list));
+		if(!priv->pool)
+			goto exit;
+	}
+
+	return list;
+
+exit:
+	ul_destroy(&list);
+	return NULL;
+}
+
+void ul_destroy(unrolled_list * list)
+{
+	rwlock_writer_entry(DS_PRIV(*list)->rwlock);
+
+	/* A pool releases all of its nodes at once. */
+	if(DS_PRIV(*list)->pool)
+		pool_destroy(&DS_PRIV(*list)->pool);
+	else
+		__truncate(*list, NULL);
+
+	rwlock_writer_exit(DS_PRIV(*list)->rwlock);
+	rwlock_destroy(&DS_PRIV(*list)->rwlock);
+
+	DS_FREE(list);
+}
+
+bool ul_empty(const unrolled_list list)
+{
+	bool empty;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	empty = DS_PRIV(list)->length == 0;
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return empty;
+}
+
+size_t ul_size(const unrolled_list list)
+{
+	size_t length;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	length = DS_PRIV(list)->length;
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return length;
+}
+
+bool ul_elem(const unrolled_list list, const void * data)
+{
+	bool success;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	success = __elem(list, data);
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+void ul_push_head(unrolled_list list, const void * data)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	__push_head(list, data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void ul_push_tail(unrolled_list list, const void * data)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	__push_tail(list, data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void * ul_pop_head(unrolled_list list)
+{
+	void * data;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	data = __take(list, 0);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return data;
+}
+
+void * ul_pop_tail(unrolled_list list)
+{
+	void * data;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	data = __take(list, DS_PRIV(list)->length - 1);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return data;
+}
+
+bool ul_pop_head_into(unrolled_list list, void * data)
+{
+	bool success;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	success = __remove(list, 0, data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool ul_pop_tail_into(unrolled_list list, void * data)
+{
+	bool success;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	success = __remove(list, DS_PRIV(list)->length - 1, data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool ul_insert(unrolled_list list, const void * data, const size_t pos)
+{
+	bool success;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	success = __insert(list, data, pos);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool ul_delete(unrolled_list list, const size_t pos)
+{
+	bool success;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	success = __remove(list, pos, NULL);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+void * ul_remove(unrolled_list list, const size_t pos)
+{
+	void * data;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	data = __take(list, pos);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return data;
+}
+
+bool ul_remove_into(unrolled_list list, const size_t pos, void * data)
+{
+	bool success;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	success = __remove(list, pos, data);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+void * ul_fetch(unrolled_list list, const size_t pos)
+{
+	struct ul_node * node;
+	struct ul_node * prev;
+	void * data = NULL;
+	size_t index;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	if(pos < DS_PRIV(list)->length) {
+		node = __locate(list, pos, &index, &prev);
+		data = __at(list, node, index);
+	}
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return data;
+}
+
+void ul_reverse(unrolled_list list)
+{
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	__reverse(list);
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void ul_map(unrolled_list list, const map_fn fn)
+{
+	struct ul_node * node;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+	linked_list_foreach(list, node)
+		for(size_t i = 0; i < node->count; i++)
+			fn(__at(list, node, i));
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+}
+
+void * ul_foldr(const unrolled_list list, const foldr_fn fn, const void * init)
+{
+	void * accumulator;
+	struct ul_node * node;
+
+	accumulator = malloc(DS_DATA_SIZE(list));
+	memcpy(accumulator, init, DS_DATA_SIZE(list));
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	linked_list_foreach(list, node)
+		for(size_t i = 0; i < node->count; i++)
+			fn(__at(list, node, i), accumulator);
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return accumulator;
+}
+
+void * ul_foldl(const unrolled_list list, const foldl_fn fn, const void * init)
+{
+	void * accumulator;
+	struct ul_node * node;
+
+	accumulator = malloc(DS_DATA_SIZE(list));
+	memcpy(accumulator, init, DS_DATA_SIZE(list));
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	linked_list_foreach(list, node)
+		for(size_t i = 0; i < node->count; i++)
+			fn(accumulator, __at(list, node, i));
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return accumulator;
+}
+
+bool ul_any(unrolled_list list, const pred_fn pred)
+{
+	bool success;
+
+	if(ul_empty(list))
+		return false;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	success = __find(list, pred, true);
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool ul_all(unrolled_list list, const pred_fn pred)
+{
+	bool success;
+
+	if(ul_empty(list))
+		return false;
+
+	rwlock_reader_entry(DS_PRIV(list)->rwlock);
+	success = !__find(list, pred, false);
+	rwlock_reader_exit(DS_PRIV(list)->rwlock);
+
+	return success;
+}
+
+bool ul_filter(unrolled_list list, const pred_fn pred)
+{
+	size_t orig_length;
+	size_t length = 0;
+	size_t kept = 0;
+	struct ul_node * node;
+	struct ul_node * out;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	orig_length = DS_PRIV(list)->length;
+
+	/* Copy each element that satisfies the predicate down to the next free
+	 * slot at `out`, filling the nodes from the head.  `out` never passes
+	 * the node being read, and a node's count only changes once `out` has
+	 * moved past it. */
+	out = __HEAD(list);
+	linked_list_foreach(list, node) {
+		for(size_t i = 0; i < node->count; i++) {
+			if(!pred(__at(list, node, i)))
+				continue;
+
+			if(kept == __CAPACITY(list)) {
+				out->count = kept;
+				out = out->next;
+				kept = 0;
+			}
+
+			if(out != node || kept != i)
+				memcpy(__at(list, out, kept),
+				       __at(list, node, i),
+				       DS_DATA_SIZE(list));
+
+			kept++;
+			length++;
+		}
+	}
+
+	if(length) {
+		out->count = kept;
+		__truncate(list, out);
+	} else {
+		__truncate(list, NULL);
+	}
+
+	DS_PRIV(list)->length = length;
+
+	if(DS_PRIV(list)->pool && orig_length != length)
+		pool_trim(DS_PRIV(list)->pool);
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return (orig_length != length);
+}
+
+bool ul_drop_while(unrolled_list list, const pred_fn pred)
+{
+	size_t orig_length;
+	size_t i = 0;
+	struct ul_node * node;
+	struct ul_node * next;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	orig_length = DS_PRIV(list)->length;
+
+	/* Free each node whose elements all satisfy the predicate, then drop
+	 * the leading elements of the node holding the first one that doesn't.
+	 */
+	for(node = __HEAD(list); node; node = next) {
+		for(i = 0; i < node->count && pred(__at(list, node, i)); i++) {}
+		if(i < node->count)
+			break;
+
+		next = node->next;
+		DS_PRIV(list)->length -= node->count;
+		__free_node(list, node);
+	}
+
+	__HEAD(list) = node;
+	if(!node) {
+		__TAIL(list) = NULL;
+	} else if(i > 0) {
+		memmove(node->data,
+		        __at(list, node, i),
+		        (node->count - i) * DS_DATA_SIZE(list));
+		node->count -= i;
+		DS_PRIV(list)->length -= i;
+	}
+
+	if(DS_PRIV(list)->pool && orig_length != DS_PRIV(list)->length)
+		pool_trim(DS_PRIV(list)->pool);
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return (orig_length != DS_PRIV(list)->length);
+}
+
+bool ul_take_while(unrolled_list list, const pred_fn pred)
+{
+	size_t orig_length;
+	size_t i = 0;
+	struct ul_node * node;
+	struct ul_node * prev = NULL;
+
+	rwlock_writer_entry(DS_PRIV(list)->rwlock);
+
+	orig_length = DS_PRIV(list)->length;
+
+	/* Find the first element that doesn't satisfy the predicate; delete
+	 * that element and every one after. */
+	linked_list_foreach(list, node) {
+		for(i = 0; i < node->count && pred(__at(list, node, i)); i++) {}
+		if(i < node->count)
+			break;
+
+		prev = node;
+	}
+
+	if(node && i > 0) {
+		DS_PRIV(list)->length -= node->count - i;
+		node->count = i;
+		__truncate(list, node);
+	} else if(node) {
+		__truncate(list, prev);
+	}
+
+	if(DS_PRIV(list)->pool && orig_length != DS_PRIV(list)->length)
+		pool_trim(DS_PRIV(list)->pool);
+
+	rwlock_writer_exit(DS_PRIV(list)->rwlock);
+
+	return (orig_length != DS_PRIV(list)->length);
+}
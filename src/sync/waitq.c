@@ -0,0 +1,133 @@
+/* waitq.c - Wait Queue Implementation
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sync/waitq.h"
+
+struct waitq * waitq_create(void)
+{
+	int err;
+	struct waitq * waitq;
+	pthread_condattr_t attr;
+
+	malloc_rof(waitq, sizeof(*waitq), NULL);
+
+	err = pthread_mutex_init(&waitq->lock, NULL);
+	if(err)
+		goto_with_errno(err, exit);
+
+	/* Deadlines are measured on the monotonic clock, so that they are not
+	 * affected by changes to the system time. */
+	err = pthread_condattr_init(&attr);
+	if(err)
+		goto_with_errno(err, exit_mutex_destroy);
+
+	err = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	if(!err)
+		err = pthread_cond_init(&waitq->cond, &attr);
+	pthread_condattr_destroy(&attr);
+	if(err)
+		goto_with_errno(err, exit_mutex_destroy);
+
+	waitq->waiters = 0;
+
+	return waitq;
+
+exit_mutex_destroy:
+	pthread_mutex_destroy(&waitq->lock);
+
+exit:
+	free(waitq);
+	return NULL;
+}
+
+void waitq_destroy(struct waitq ** waitq)
+{
+	pthread_mutex_destroy(&(*waitq)->lock);
+	pthread_cond_destroy(&(*waitq)->cond);
+
+	free(*waitq);
+	*waitq = NULL;
+}
+
+bool waitq_wait(struct waitq * waitq,
+                const pred_fn ready,
+                const void * arg,
+                const struct timespec * deadline)
+{
+	int err = 0;
+	bool success;
+
+	pthread_mutex_lock(&waitq->lock);
+
+	/* Pairs with the fence in waitq_wake(): either the waker sees this
+	 * waiter, or this waiter sees the waker's change to the condition. */
+	__atomic_fetch_add(&waitq->waiters, 1, __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	while(!(success = ready(arg)) && err != ETIMEDOUT) {
+		if(deadline)
+			err = pthread_cond_timedwait(&waitq->cond,
+			                             &waitq->lock,
+			                             deadline);
+		else
+			pthread_cond_wait(&waitq->cond, &waitq->lock);
+	}
+
+	__atomic_fetch_sub(&waitq->waiters, 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&waitq->lock);
+
+	return success;
+}
+
+void waitq_wake(struct waitq * waitq, const size_t count)
+{
+	size_t waiters;
+
+	if(!count)
+		return;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	waiters = __atomic_load_n(&waitq->waiters, __ATOMIC_RELAXED);
+	if(!waiters)
+		return;
+
+	/* Wake only as many waiters as can make progress. */
+	pthread_mutex_lock(&waitq->lock);
+	if(count >= waiters) {
+		pthread_cond_broadcast(&waitq->cond);
+	} else {
+		for(size_t i = 0; i < count; i++)
+			pthread_cond_signal(&waitq->cond);
+	}
+	pthread_mutex_unlock(&waitq->lock);
+}
+
+void waitq_deadline(struct timespec * deadline,
+                    const struct timespec * timeout)
+{
+	clock_gettime(CLOCK_MONOTONIC, deadline);
+
+	deadline->tv_sec  += timeout->tv_sec;
+	deadline->tv_nsec += timeout->tv_nsec;
+	if(deadline->tv_nsec >= 1000000000L) {
+		deadline->tv_sec  += deadline->tv_nsec / 1000000000L;
+		deadline->tv_nsec %= 1000000000L;
+	}
+}
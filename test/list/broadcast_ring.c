@@ -0,0 +1,271 @@
+/* broadcast_ring.c - Unit Tests for the Broadcast Ring API
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <check.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "list/broadcast_ring.h"
+
+static const struct ds_properties props = {
+	.data_size = sizeof(uint32_t),
+	.entries   = 10,
+	.consumers = 3,
+};
+
+static broadcast_ring ring;
+
+void setup(void)
+{
+	ring = br_create(&props);
+}
+
+void takedown(void)
+{
+	br_destroy(&ring);
+}
+
+START_TEST(test_br_create)
+{
+	ck_assert(ring);
+}
+END_TEST
+
+START_TEST(test_br_create_invalid)
+{
+	broadcast_ring r;
+	struct ds_properties bad_props = props;
+
+	bad_props.entries = 0;
+	r = br_create(&bad_props);
+	ck_assert(!r);
+	ck_assert_int_eq(errno, EINVAL);
+
+	bad_props.entries   = props.entries;
+	bad_props.consumers = 0;
+	r = br_create(&bad_props);
+	ck_assert(!r);
+	ck_assert_int_eq(errno, EINVAL);
+}
+END_TEST
+
+START_TEST(test_br_subscribe)
+{
+	ssize_t consumers[3];
+
+	for(size_t i = 0; i < 3; i++) {
+		consumers[i] = br_subscribe(ring);
+		ck_assert_int_ge(consumers[i], 0);
+	}
+
+	ck_assert_int_eq(br_subscribe(ring), -1);
+	ck_assert_int_eq(errno, EAGAIN);
+
+	/* Identifiers are reused after unsubscribing. */
+	br_unsubscribe(ring, consumers[1]);
+	ck_assert_int_eq(br_subscribe(ring), consumers[1]);
+}
+END_TEST
+
+START_TEST(test_br_publish_unsubscribed)
+{
+	ssize_t consumer;
+	uint32_t out;
+
+	/* With no consumers, nothing holds the producer back. */
+	for(uint32_t n = 0; n < 3 * props.entries; n++)
+		ck_assert(br_publish(ring, &n));
+
+	/* A new consumer only sees blocks published after it subscribed. */
+	consumer = br_subscribe(ring);
+	ck_assert_int_ge(consumer, 0);
+	ck_assert_int_eq(br_available(ring, consumer), 0);
+
+	out = 100;
+	ck_assert(br_publish(ring, &out));
+	ck_assert_int_eq(br_read(ring, consumer, &out, 1), 1);
+	ck_assert_int_eq(out, 100);
+}
+END_TEST
+
+START_TEST(test_br_broadcast)
+{
+	ssize_t fast;
+	ssize_t slow;
+	uint32_t in[15];
+	uint32_t out[15];
+
+	fast = br_subscribe(ring);
+	slow = br_subscribe(ring);
+
+	for(uint32_t n = 0; n < 15; n++)
+		in[n] = n;
+
+	/* The producer can only get a lap ahead of the slowest consumer. */
+	ck_assert_int_eq(br_publish_n(ring, in, 15), props.entries);
+	ck_assert(!br_publish(ring, &in[10]));
+
+	/* Every consumer sees every block. */
+	ck_assert_int_eq(br_read(ring, fast, out, 15), props.entries);
+	ck_assert_mem_eq(out, in, props.entries * sizeof(*in));
+	ck_assert(!br_publish(ring, &in[10]));
+
+	ck_assert_int_eq(br_read(ring, slow, out, 4), 4);
+	ck_assert_mem_eq(out, in, 4 * sizeof(*in));
+
+	/* The slow consumer freed room for four blocks, which wrap. */
+	ck_assert_int_eq(br_publish_n(ring, in + 10, 5), 4);
+	ck_assert_int_eq(br_available(ring, fast), 4);
+	ck_assert_int_eq(br_available(ring, slow), props.entries);
+
+	ck_assert_int_eq(br_read(ring, slow, out, 15), props.entries);
+	ck_assert_mem_eq(out, in + 4, props.entries * sizeof(*in));
+
+	/* Now the first consumer is the slowest, and holds the producer. */
+	ck_assert_int_eq(br_publish_n(ring, in, 10), 6);
+	ck_assert_int_eq(br_available(ring, fast), props.entries);
+	ck_assert_int_eq(br_available(ring, slow), 6);
+
+	/* Only unsubscribing the slowest consumer makes room. */
+	br_unsubscribe(ring, slow);
+	ck_assert(!br_publish(ring, &in[14]));
+	br_unsubscribe(ring, fast);
+	ck_assert(br_publish(ring, &in[14]));
+}
+END_TEST
+
+START_TEST(test_br_peek_release)
+{
+	ssize_t consumer;
+	uint32_t in[10];
+	struct rb_span span[2];
+
+	consumer = br_subscribe(ring);
+
+	for(uint32_t n = 0; n < 10; n++)
+		in[n] = n;
+
+	/* Move the cursor so that the next blocks wrap. */
+	ck_assert_int_eq(br_publish_n(ring, in, 7), 7);
+	ck_assert_int_eq(br_peek(ring, consumer, 10, span), 7);
+	br_release(ring, consumer, 7);
+
+	ck_assert_int_eq(br_publish_n(ring, in, 6), 6);
+	ck_assert_int_eq(br_peek(ring, consumer, 10, span), 6);
+	ck_assert_int_eq(span[0].count, 3);
+	ck_assert_int_eq(span[1].count, 3);
+	ck_assert_mem_eq(span[0].data, in, 3 * sizeof(*in));
+	ck_assert_mem_eq(span[1].data, in + 3, 3 * sizeof(*in));
+
+	br_release(ring, consumer, 2);
+	ck_assert_int_eq(br_available(ring, consumer), 4);
+}
+END_TEST
+
+#define CONSUMERS 3
+#define TRANSFERS 100000
+
+static void * consumer(void * arg)
+{
+	ssize_t id = *(ssize_t *) arg;
+	uint32_t out[8];
+	uint32_t expected = 0;
+	size_t read;
+
+	while(expected < TRANSFERS) {
+		while(!(read = br_read(ring, id, out, 8)))
+			sched_yield();
+
+		for(size_t i = 0; i < read; i++)
+			if(out[i] != expected++)
+				return (void *) 1;
+	}
+
+	return NULL;
+}
+
+START_TEST(test_br_threaded)
+{
+	pthread_t consumers[CONSUMERS];
+	ssize_t ids[CONSUMERS];
+	void * result;
+
+	for(size_t i = 0; i < CONSUMERS; i++) {
+		ids[i] = br_subscribe(ring);
+		ck_assert_int_ge(ids[i], 0);
+		pthread_create(&consumers[i], NULL, consumer, &ids[i]);
+	}
+
+	for(uint32_t n = 0; n < TRANSFERS; n++)
+		while(!br_publish(ring, &n))
+			sched_yield();
+
+	/* Every consumer must have seen every value, in order. */
+	for(size_t i = 0; i < CONSUMERS; i++) {
+		pthread_join(consumers[i], &result);
+		ck_assert(!result);
+	}
+}
+END_TEST
+
+Suite * br_suite(void)
+{
+	Suite * suite;
+	TCase * case_br_create;
+	TCase * case_br_publish;
+	TCase * case_br_threaded;
+
+	suite = suite_create("Broadcast Ring");
+
+	case_br_create   = tcase_create("br_create");
+	case_br_publish  = tcase_create("br_publish");
+	case_br_threaded = tcase_create("br_threaded");
+
+	tcase_add_checked_fixture(case_br_create,   setup, takedown);
+	tcase_add_checked_fixture(case_br_publish,  setup, takedown);
+	tcase_add_checked_fixture(case_br_threaded, setup, takedown);
+
+	tcase_add_test(case_br_create,   test_br_create);
+	tcase_add_test(case_br_create,   test_br_create_invalid);
+	tcase_add_test(case_br_create,   test_br_subscribe);
+	tcase_add_test(case_br_publish,  test_br_publish_unsubscribed);
+	tcase_add_test(case_br_publish,  test_br_broadcast);
+	tcase_add_test(case_br_publish,  test_br_peek_release);
+	tcase_add_test(case_br_threaded, test_br_threaded);
+
+	suite_add_tcase(suite, case_br_create);
+	suite_add_tcase(suite, case_br_publish);
+	suite_add_tcase(suite, case_br_threaded);
+
+	return suite;
+}
+
+int main(void)
+{
+	Suite * suite_br;
+	SRunner * suite_runner;
+
+	suite_br = br_suite();
+
+	suite_runner = srunner_create(suite_br);
+	srunner_run_all(suite_runner, CK_NORMAL);
+	srunner_free(suite_runner);
+
+	return 0;
+}
@@ -230,6 +230,39 @@ START_TEST(test_dl_pop_head_multiple)
 }
 END_TEST
 
+START_TEST(test_dl_pop_into)
+{
+	uint8_t in1 = 1;
+	uint8_t in2 = 2;
+	uint8_t in3 = 3;
+	uint8_t out = 0;
+	double_list list;
+
+	list = dl_create(&props);
+	dl_push_tail(list, &in1);
+	dl_push_tail(list, &in2);
+	dl_push_tail(list, &in3);
+
+	ck_assert(dl_pop_head_into(list, &out));
+	ck_assert_int_eq(out, in1);
+	ck_assert(dl_pop_tail_into(list, &out));
+	ck_assert_int_eq(out, in3);
+	ck_assert(dl_pop_tail_into(list, &out));
+	ck_assert_int_eq(out, in2);
+
+	/* Popping an empty list leaves `out` untouched. */
+	ck_assert(!dl_pop_head_into(list, &out));
+	ck_assert(!dl_pop_tail_into(list, &out));
+	ck_assert_int_eq(out, in2);
+
+	ck_assert(!DS_PRIV(list)->head);
+	ck_assert(!DS_PRIV(list)->tail);
+	ck_assert(dl_empty(list));
+
+	dl_destroy(&list);
+}
+END_TEST
+
 START_TEST(test_dl_pop_tail_empty)
 {
 	void * val;
@@ -570,6 +603,41 @@ START_TEST(test_dl_remove_multiple)
 }
 END_TEST
 
+START_TEST(test_dl_remove_into)
+{
+	uint8_t in1 = 1;
+	uint8_t in2 = 2;
+	uint8_t in3 = 3;
+	uint8_t out = 0;
+	double_list list;
+
+	/* Create linked list: [1, 2, 3] */
+	list = dl_create(&props);
+	dl_push_tail(list, &in1);
+	dl_push_tail(list, &in2);
+	dl_push_tail(list, &in3);
+
+	/* [1, 2, 3] -> [1, 3] (2) */
+	ck_assert(dl_remove_into(list, 1, &out));
+	ck_assert_int_eq(out, in2);
+	/* [1, 3] -> [1] (3) */
+	ck_assert(dl_remove_into(list, 1, &out));
+	ck_assert_int_eq(out, in3);
+	/* [1] -> [1] (out of range) */
+	ck_assert(!dl_remove_into(list, 1, &out));
+	ck_assert_int_eq(out, in3);
+	/* [1] -> [] (1) */
+	ck_assert(dl_remove_into(list, 0, &out));
+	ck_assert_int_eq(out, in1);
+
+	ck_assert(!DS_PRIV(list)->head);
+	ck_assert(!DS_PRIV(list)->tail);
+	ck_assert(dl_empty(list));
+
+	dl_destroy(&list);
+}
+END_TEST
+
 START_TEST(test_dl_fetch_empty)
 {
 	void * val1;
@@ -661,6 +729,131 @@ START_TEST(test_dl_fetch_multiple)
 }
 END_TEST
 
+static const struct ds_properties finger_props = {
+	.data_size = sizeof(uint32_t),
+};
+
+static bool pred_any32(__unused uint32_t * n)
+{
+	return true;
+}
+
+/* Fetch every element of `list`, forwards and then backwards. */
+static void check_fetch(const double_list list,
+	                const uint32_t * expected,
+	                const size_t length)
+{
+	ck_assert_int_eq(dl_size(list), length);
+
+	for(size_t i = 0; i < length; i++)
+		ck_assert_int_eq(*(uint32_t *) dl_fetch(list, i), expected[i]);
+	for(size_t i = length; i-- > 0;)
+		ck_assert_int_eq(*(uint32_t *) dl_fetch(list, i), expected[i]);
+
+	ck_assert(!dl_fetch(list, length));
+}
+
+/**
+ * Positional access starts from the element found by the last positional
+ * access; check that it stays correct as the list changes around it.
+ */
+START_TEST(test_dl_fetch_finger)
+{
+	uint32_t expected[64];
+	size_t length = 0;
+	size_t pos;
+	size_t at;
+	uint32_t in;
+	uint32_t out;
+	double_list list;
+
+	list = dl_create(&finger_props);
+
+	for(in = 0; in < 32; in++) {
+		dl_push_tail(list, &in);
+		expected[length++] = in;
+	}
+
+	check_fetch(list, expected, length);
+	ck_assert_int_eq(*(uint32_t *) dl_fetch(list, 20), 20);
+	ck_assert_ptr_eq(DS_PRIV(list)->finger->data, dl_fetch(list, 20));
+	ck_assert_int_eq(DS_PRIV(list)->finger_pos, 20);
+
+	for(in = 32; in < 64; in++) {
+		/* Move the finger, then change the list somewhere else. */
+		at = (in * 11) % length;
+		ck_assert_int_eq(*(uint32_t *) dl_fetch(list, at),
+		                 expected[at]);
+		pos = (in * 5) % length;
+
+		switch(in % 6) {
+		case 0:
+			dl_push_head(list, &in);
+			pos = 0;
+			/* fall through */
+		case 1:
+		case 5:
+			if(in % 6)
+				ck_assert(dl_insert(list, &in, pos));
+			memmove(&expected[pos + 1],
+			        &expected[pos],
+			        (length - pos) * sizeof(*expected));
+			expected[pos] = in;
+			length++;
+			break;
+		case 3:
+			pos = 0;
+			ck_assert(dl_pop_head_into(list, &out));
+			/* fall through */
+		case 2:
+			if(in % 6 == 2)
+				ck_assert(dl_remove_into(list, pos, &out));
+			ck_assert_int_eq(out, expected[pos]);
+			memmove(&expected[pos],
+			        &expected[pos + 1],
+			        (length - pos - 1) * sizeof(*expected));
+			length--;
+
+			/* The element after the one removed takes its place. */
+			if(pos < length)
+				ck_assert_int_eq(*(uint32_t *)
+				                 dl_fetch(list, pos),
+				                 expected[pos]);
+			break;
+		case 4:
+			ck_assert(dl_pop_tail_into(list, &out));
+			ck_assert_int_eq(out, expected[--length]);
+			break;
+		}
+
+		if(at < length)
+			ck_assert_int_eq(*(uint32_t *) dl_fetch(list, at),
+			                 expected[at]);
+		if(pos < length)
+			ck_assert_int_eq(*(uint32_t *) dl_fetch(list, pos),
+			                 expected[pos]);
+		check_fetch(list, expected, length);
+	}
+
+	at = length / 3;
+	ck_assert_int_eq(*(uint32_t *) dl_fetch(list, at), expected[at]);
+
+	dl_reverse(list);
+	for(size_t i = 0; i < length / 2; i++) {
+		in = expected[i];
+		expected[i] = expected[length - 1 - i];
+		expected[length - 1 - i] = in;
+	}
+	ck_assert_int_eq(*(uint32_t *) dl_fetch(list, at), expected[at]);
+	check_fetch(list, expected, length);
+
+	ck_assert(dl_drop_while(list, (pred_fn) pred_any32));
+	check_fetch(list, expected, 0);
+
+	dl_destroy(&list);
+}
+END_TEST
+
 START_TEST(test_dl_elem_empty)
 {
 	bool found;
@@ -1466,6 +1659,134 @@ START_TEST(test_dl_foldl_multiple)
 }
 END_TEST
 
+/**
+ * Test that data larger than the element's own fields is stored inline and
+ * aligned, and that popping it hands back an intact copy.
+ */
+START_TEST(test_dl_inline)
+{
+	uint8_t in[40];
+	uint8_t * out;
+	struct dl_element * current;
+	double_list list;
+	struct ds_properties inline_props = {
+		.data_size = sizeof(in),
+	};
+
+	list = dl_create(&inline_props);
+	ck_assert(list);
+
+	for(size_t i = 0; i < 3; i++) {
+		memset(in, i + 1, sizeof(in));
+		dl_push_tail(list, in);
+	}
+
+	linked_list_foreach(list, current) {
+		ck_assert_ptr_eq(current->data,
+		                 (uint8_t *) current + sizeof(*current));
+		ck_assert_int_eq((uintptr_t) current->data %
+		                 alignof(max_align_t), 0);
+	}
+
+	for(size_t i = 0; i < 3; i++) {
+		memset(in, i + 1, sizeof(in));
+		out = dl_pop_head(list);
+
+		ck_assert(out);
+		ck_assert_mem_eq(out, in, sizeof(in));
+		free(out);
+	}
+
+	dl_destroy(&list);
+}
+END_TEST
+
+static const struct ds_properties pooled_props = {
+	.data_size = sizeof(uint32_t),
+	.pooled    = true,
+};
+
+static size_t slab_count(const struct pool * pool)
+{
+	size_t count = 0;
+
+	for(struct pool_slab * slab = pool->slabs; slab; slab = slab->next)
+		count++;
+
+	return count;
+}
+
+static bool pred_even(uint32_t * n)
+{
+	return *n % 2 == 0;
+}
+
+static bool pred_small(uint32_t * n)
+{
+	return *n < 10;
+}
+
+/**
+ * Test a pooled list across several slabs: elements freed by pops are reused,
+ * and filtering away most of the list releases the emptied slabs.
+ */
+START_TEST(test_dl_pooled)
+{
+	uint32_t in;
+	uint32_t out;
+	uint32_t * data;
+	size_t slabs;
+	double_list list;
+
+	list = dl_create(&pooled_props);
+	ck_assert(list);
+	ck_assert(DS_PRIV(list)->pool);
+
+	for(in = 0; in < 10000; in++)
+		dl_push_tail(list, &in);
+	slabs = slab_count(DS_PRIV(list)->pool);
+	ck_assert_int_gt(slabs, 1);
+
+	/* Popped elements are reused rather than allocating more slabs. */
+	for(in = 0; in < 1000; in++) {
+		ck_assert(dl_pop_head_into(list, &out));
+		ck_assert_int_eq(out, in);
+		dl_push_tail(list, &out);
+	}
+	ck_assert_int_eq(slab_count(DS_PRIV(list)->pool), slabs);
+
+	/* Popped data belongs to the caller. */
+	data = dl_pop_head(list);
+	ck_assert(data);
+	ck_assert_int_eq(*data, 1000);
+	free(data);
+
+	in = 1000;
+	ck_assert(dl_insert(list, &in, 1));
+	ck_assert_int_eq(*(uint32_t *) dl_fetch(list, 1), 1000);
+	ck_assert(dl_remove_into(list, 1, &out));
+	ck_assert_int_eq(out, 1000);
+	ck_assert(dl_delete(list, 0));
+	ck_assert_int_eq(dl_size(list), 9998);
+
+	/* Only the even values below ten survive. */
+	ck_assert(dl_filter(list, (pred_fn) pred_even));
+	ck_assert(dl_filter(list, (pred_fn) pred_small));
+	ck_assert_int_eq(dl_size(list), 5);
+	ck_assert_int_eq(slab_count(DS_PRIV(list)->pool), 1);
+
+	for(in = 0; in < 10; in += 2) {
+		ck_assert(dl_pop_head_into(list, &out));
+		ck_assert_int_eq(out, in);
+	}
+	ck_assert(dl_empty(list));
+
+	for(in = 0; in < 100; in++)
+		dl_push_head(list, &in);
+	dl_destroy(&list);
+}
+END_TEST
+
 Suite * dl_suite(void)
 {
 	Suite * suite;
@@ -1489,6 +1810,7 @@ Suite * dl_suite(void)
 	TCase * case_dl_reverse;
 	TCase * case_dl_foldl;
 	TCase * case_dl_foldr;
+	TCase * case_dl_pool;
 
 	suite = suite_create("Linked List");
 
@@ -1512,6 +1834,7 @@ Suite * dl_suite(void)
 	case_dl_reverse = tcase_create("dl_reverse");
 	case_dl_foldl = tcase_create("dl_foldl");
 	case_dl_foldr = tcase_create("dl_foldr");
+	case_dl_pool = tcase_create("dl_pool");
 
 	tcase_add_test(case_dl_alloc, test_dl_alloc);
 	tcase_add_test(case_dl_empty, test_dl_empty_true);
@@ -1523,9 +1846,11 @@ Suite * dl_suite(void)
 	tcase_add_test(case_dl_pop_head, test_dl_pop_head_empty);
 	tcase_add_test(case_dl_pop_head, test_dl_pop_head_single);
 	tcase_add_test(case_dl_pop_head, test_dl_pop_head_multiple);
+	tcase_add_test(case_dl_pop_head, test_dl_inline);
 	tcase_add_test(case_dl_pop_tail, test_dl_pop_tail_empty);
 	tcase_add_test(case_dl_pop_tail, test_dl_pop_tail_single);
 	tcase_add_test(case_dl_pop_tail, test_dl_pop_tail_multiple);
+	tcase_add_test(case_dl_pop_tail, test_dl_pop_into);
 	tcase_add_test(case_dl_insert, test_dl_insert_single);
 	tcase_add_test(case_dl_insert, test_dl_insert_multiple);
 	tcase_add_test(case_dl_delete, test_dl_delete_empty);
@@ -1534,9 +1859,11 @@ Suite * dl_suite(void)
 	tcase_add_test(case_dl_remove, test_dl_remove_empty);
 	tcase_add_test(case_dl_remove, test_dl_remove_single);
 	tcase_add_test(case_dl_remove, test_dl_remove_multiple);
+	tcase_add_test(case_dl_remove, test_dl_remove_into);
 	tcase_add_test(case_dl_fetch, test_dl_fetch_empty);
 	tcase_add_test(case_dl_fetch, test_dl_fetch_single);
 	tcase_add_test(case_dl_fetch, test_dl_fetch_multiple);
+	tcase_add_test(case_dl_fetch, test_dl_fetch_finger);
 	tcase_add_test(case_dl_elem, test_dl_elem_empty);
 	tcase_add_test(case_dl_elem, test_dl_elem_single);
 	tcase_add_test(case_dl_elem, test_dl_elem_multiple);
@@ -1567,6 +1894,7 @@ Suite * dl_suite(void)
 	tcase_add_test(case_dl_foldl, test_dl_foldl_empty);
 	tcase_add_test(case_dl_foldl, test_dl_foldl_single);
 	tcase_add_test(case_dl_foldl, test_dl_foldl_multiple);
+	tcase_add_test(case_dl_pool, test_dl_pooled);
 
 	suite_add_tcase(suite, case_dl_alloc);
 	suite_add_tcase(suite, case_dl_empty);
@@ -1588,6 +1916,7 @@ Suite * dl_suite(void)
 	suite_add_tcase(suite, case_dl_reverse);
 	suite_add_tcase(suite, case_dl_foldr);
 	suite_add_tcase(suite, case_dl_foldl);
+	suite_add_tcase(suite, case_dl_pool);
 
 	return suite;
 }
@@ -0,0 +1,229 @@
+/* mpmc_queue.c - Unit Tests for the Multi-Producer/Multi-Consumer Queue API
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <check.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "list/mpmc_queue.h"
+
+static const struct ds_properties props = {
+	.data_size = sizeof(uint32_t),
+	.entries   = 10,
+};
+
+static mpmc_queue queue;
+
+void setup(void)
+{
+	queue = mq_create(&props);
+}
+
+void takedown(void)
+{
+	mq_destroy(&queue);
+}
+
+START_TEST(test_mq_create)
+{
+	ck_assert(queue);
+	ck_assert(mq_empty(queue));
+	ck_assert(!mq_full(queue));
+	ck_assert_int_eq(mq_size(queue), 0);
+}
+END_TEST
+
+START_TEST(test_mq_create_invalid)
+{
+	mpmc_queue q;
+	struct ds_properties bad_props = props;
+
+	bad_props.entries = 0;
+	q = mq_create(&bad_props);
+	ck_assert(!q);
+	ck_assert_int_eq(errno, EINVAL);
+
+	bad_props.entries = props.entries;
+	bad_props.overwrite = true;
+	q = mq_create(&bad_props);
+	ck_assert(!q);
+	ck_assert_int_eq(errno, EINVAL);
+}
+END_TEST
+
+START_TEST(test_mq_push_pop_single)
+{
+	uint32_t in = 1;
+	uint32_t * out;
+
+	ck_assert(mq_push(queue, &in));
+	ck_assert_int_eq(mq_size(queue), 1);
+
+	out = mq_pop(queue);
+
+	ck_assert(out);
+	ck_assert_int_eq(*out, in);
+	ck_assert(mq_empty(queue));
+
+	free(out);
+}
+END_TEST
+
+START_TEST(test_mq_pop_empty)
+{
+	ck_assert(!mq_pop(queue));
+	ck_assert(mq_empty(queue));
+}
+END_TEST
+
+START_TEST(test_mq_push_full)
+{
+	uint32_t * out;
+	uint32_t in;
+
+	/* Fill and drain several times so that every cell is reused. */
+	for(size_t pass = 0; pass < 3; pass++) {
+		for(in = 0; in < props.entries; in++)
+			ck_assert(mq_push(queue, &in));
+
+		ck_assert(mq_full(queue));
+		ck_assert(!mq_push(queue, &in));
+
+		for(uint32_t i = 0; i < props.entries; i++) {
+			out = mq_pop(queue);
+
+			ck_assert(out);
+			ck_assert_int_eq(*out, i);
+
+			free(out);
+		}
+
+		ck_assert(mq_empty(queue));
+	}
+}
+END_TEST
+
+#define THREADS   4
+#define TRANSFERS 20000
+
+static void * producer(void * arg)
+{
+	uint32_t base = *(uint32_t *) arg;
+
+	for(uint32_t i = 0; i < TRANSFERS; i++) {
+		uint32_t value = base + i;
+
+		while(!mq_push(queue, &value))
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+static void * consumer(void * arg)
+{
+	uint64_t * sum = arg;
+	uint32_t * out;
+
+	for(uint32_t i = 0; i < TRANSFERS; i++) {
+		while(!(out = mq_pop(queue)))
+			sched_yield();
+
+		*sum += *out;
+		free(out);
+	}
+
+	return NULL;
+}
+
+START_TEST(test_mq_threaded)
+{
+	pthread_t producers[THREADS];
+	pthread_t consumers[THREADS];
+	uint32_t bases[THREADS];
+	uint64_t sums[THREADS] = {0};
+	uint64_t expected = 0;
+	uint64_t total = 0;
+
+	for(size_t i = 0; i < THREADS; i++) {
+		bases[i] = i * TRANSFERS;
+		pthread_create(&producers[i], NULL, producer, &bases[i]);
+		pthread_create(&consumers[i], NULL, consumer, &sums[i]);
+	}
+
+	for(size_t i = 0; i < THREADS; i++) {
+		pthread_join(producers[i], NULL);
+		pthread_join(consumers[i], NULL);
+	}
+
+	/* Every value pushed must have been popped exactly once. */
+	for(uint64_t i = 0; i < THREADS * TRANSFERS; i++)
+		expected += i;
+	for(size_t i = 0; i < THREADS; i++)
+		total += sums[i];
+
+	ck_assert(total == expected);
+	ck_assert(mq_empty(queue));
+}
+END_TEST
+
+Suite * mq_suite(void)
+{
+	Suite * suite;
+	TCase * case_mq_create;
+	TCase * case_mq_push_pop;
+	TCase * case_mq_threaded;
+
+	suite = suite_create("MPMC Queue");
+
+	case_mq_create   = tcase_create("mq_create");
+	case_mq_push_pop = tcase_create("mq_push_pop");
+	case_mq_threaded = tcase_create("mq_threaded");
+
+	tcase_add_checked_fixture(case_mq_create,   setup, takedown);
+	tcase_add_checked_fixture(case_mq_push_pop, setup, takedown);
+	tcase_add_checked_fixture(case_mq_threaded, setup, takedown);
+
+	tcase_add_test(case_mq_create,   test_mq_create);
+	tcase_add_test(case_mq_create,   test_mq_create_invalid);
+	tcase_add_test(case_mq_push_pop, test_mq_push_pop_single);
+	tcase_add_test(case_mq_push_pop, test_mq_pop_empty);
+	tcase_add_test(case_mq_push_pop, test_mq_push_full);
+	tcase_add_test(case_mq_threaded, test_mq_threaded);
+
+	suite_add_tcase(suite, case_mq_create);
+	suite_add_tcase(suite, case_mq_push_pop);
+	suite_add_tcase(suite, case_mq_threaded);
+
+	return suite;
+}
+
+int main(void)
+{
+	Suite * suite_mq;
+	SRunner * suite_runner;
+
+	suite_mq = mq_suite();
+
+	suite_runner = srunner_create(suite_mq);
+	srunner_run_all(suite_runner, CK_NORMAL);
+	srunner_free(suite_runner);
+
+	return 0;
+}
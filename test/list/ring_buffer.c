@@ -18,6 +18,11 @@
  */
 
 #include <check.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "list/array.h"
 #include "list/ring_buffer.h"
@@ -274,6 +279,404 @@ START_TEST(test_rb_pop_tail_multiple)
 }
 END_TEST
 
+START_TEST(test_rb_pop_into)
+{
+	uint8_t in[] = {1, 2, 3};
+	uint8_t out = 0;
+	ring_buffer buf = NULL;
+
+	/* Create list: [1, 2, 3] */
+	buf = rb_create(&props);
+	rb_push_tail(buf, &in[0]);
+	rb_push_tail(buf, &in[1]);
+	rb_push_tail(buf, &in[2]);
+
+	ck_assert(rb_pop_head_into(buf, &out));
+	ck_assert_int_eq(out, in[0]);
+	ck_assert(rb_pop_tail_into(buf, &out));
+	ck_assert_int_eq(out, in[2]);
+	ck_assert(rb_pop_head_into(buf, &out));
+	ck_assert_int_eq(out, in[1]);
+
+	/* Popping an empty buffer leaves `out` untouched. */
+	ck_assert(!rb_pop_head_into(buf, &out));
+	ck_assert(!rb_pop_tail_into(buf, &out));
+	ck_assert_int_eq(out, in[1]);
+	ck_assert(rb_empty(buf));
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_push_tail_n)
+{
+	uint8_t in[] = {1, 2, 3, 4, 5, 6, 7};
+	uint8_t out[array_size(in) + 5];
+	uint8_t scratch[8];
+	size_t count;
+
+	/* Move the head near the end of storage so the batch has to wrap. */
+	for(size_t i = 0; i < array_size(scratch); i++)
+		rb_push_tail(buffer, &in[0]);
+	count = rb_pop_head_n(buffer, scratch, array_size(scratch));
+	ck_assert_int_eq(count, array_size(scratch));
+
+	count = rb_push_tail_n(buffer, in, array_size(in));
+	ck_assert_int_eq(count, array_size(in));
+	ck_assert_int_eq(rb_size(buffer), array_size(in));
+
+	/* Asking for more than the buffer holds returns what there is. */
+	count = rb_pop_head_n(buffer, out, array_size(out));
+	ck_assert_int_eq(count, array_size(in));
+	ck_assert(memcmp(in, out, sizeof(in)) == 0);
+	ck_assert(rb_empty(buffer));
+}
+END_TEST
+
+START_TEST(test_rb_push_tail_n_full)
+{
+	uint8_t in[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+	uint8_t out[array_size(in)];
+	size_t count;
+
+	count = rb_push_tail_n(buffer, in, array_size(in));
+
+	ck_assert_int_eq(count, props.entries);
+	ck_assert(rb_full(buffer));
+
+	count = rb_pop_head_n(buffer, out, array_size(out));
+	ck_assert_int_eq(count, props.entries);
+	ck_assert(memcmp(in, out, props.entries) == 0);
+}
+END_TEST
+
+START_TEST(test_rb_push_n_overwrite)
+{
+	uint8_t in[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+	uint8_t out[array_size(in)];
+	struct ds_properties ow_props = props;
+	ring_buffer buf;
+	size_t count;
+
+	ow_props.overwrite = true;
+	buf = rb_create(&ow_props);
+
+	/* Only the last `entries` blocks pushed onto the tail survive. */
+	count = rb_push_tail_n(buf, in, array_size(in));
+	ck_assert_int_eq(count, array_size(in));
+	ck_assert(rb_full(buf));
+
+	count = rb_pop_head_n(buf, out, array_size(out));
+	ck_assert_int_eq(count, ow_props.entries);
+	ck_assert(memcmp(in + 2, out, ow_props.entries) == 0);
+
+	/* Pushing onto the head of a full buffer drops blocks off the tail. */
+	rb_push_tail_n(buf, in, ow_props.entries);
+	count = rb_push_head_n(buf, in + 10, 2);
+	ck_assert_int_eq(count, 2);
+
+	count = rb_pop_head_n(buf, out, array_size(out));
+	ck_assert_int_eq(count, ow_props.entries);
+	ck_assert(memcmp(in + 10, out, 2) == 0);
+	ck_assert(memcmp(in, out + 2, ow_props.entries - 2) == 0);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_push_head_n)
+{
+	uint8_t first[] = {4, 5};
+	uint8_t second[] = {1, 2, 3};
+	uint8_t expected[] = {1, 2, 3, 4, 5};
+	uint8_t out[array_size(expected)];
+	size_t count;
+
+	rb_push_head_n(buffer, first, array_size(first));
+	count = rb_push_head_n(buffer, second, array_size(second));
+	ck_assert_int_eq(count, array_size(second));
+
+	count = rb_pop_head_n(buffer, out, array_size(out));
+	ck_assert_int_eq(count, array_size(expected));
+	ck_assert(memcmp(expected, out, sizeof(expected)) == 0);
+}
+END_TEST
+
+START_TEST(test_rb_pop_tail_n)
+{
+	uint8_t in[] = {1, 2, 3, 4, 5};
+	uint8_t out[3];
+	uint8_t * rest;
+	size_t count;
+
+	rb_push_head_n(buffer, in, array_size(in));
+	count = rb_pop_tail_n(buffer, out, array_size(out));
+
+	/* The popped blocks keep their order from the buffer. */
+	ck_assert_int_eq(count, array_size(out));
+	ck_assert(memcmp(in + 2, out, array_size(out)) == 0);
+	ck_assert_int_eq(rb_size(buffer), 2);
+
+	rest = rb_pop_tail(buffer);
+	ck_assert_int_eq(*rest, in[1]);
+	free(rest);
+
+	ck_assert_int_eq(rb_pop_tail_n(buffer, out, array_size(out)), 1);
+	ck_assert_int_eq(out[0], in[0]);
+	ck_assert_int_eq(rb_pop_tail_n(buffer, out, array_size(out)), 0);
+}
+END_TEST
+
+/**
+ * Test that a reservation wrapping around the end of the storage is split into
+ * two spans, and that only committed blocks become visible.
+ */
+START_TEST(test_rb_reserve_commit)
+{
+	uint8_t out[10];
+	uint8_t * block;
+	size_t reserved;
+	struct rb_span span[2];
+
+	/* Move the tail to slot 7 of 10. */
+	for(uint8_t i = 0; i < 7; i++)
+		rb_push_tail(buffer, &i);
+	ck_assert_int_eq(rb_pop_head_n(buffer, out, 7), 7);
+
+	reserved = rb_reserve(buffer, 5, span);
+	ck_assert_int_eq(reserved, 5);
+	ck_assert_int_eq(span[0].count, 3);
+	ck_assert_int_eq(span[1].count, 2);
+	ck_assert(span[1].data == DS_PRIV(buffer)->data);
+
+	for(size_t i = 0; i < 2; i++) {
+		block = span[i].data;
+		for(size_t j = 0; j < span[i].count; j++)
+			block[j] = 10 + (i ? span[0].count : 0) + j;
+	}
+	rb_commit(buffer, 4);
+
+	ck_assert_int_eq(rb_size(buffer), 4);
+	ck_assert_int_eq(rb_pop_head_n(buffer, out, 10), 4);
+	for(uint8_t i = 0; i < 4; i++)
+		ck_assert_int_eq(out[i], 10 + i);
+
+	/* A reservation never exceeds the free space. */
+	ck_assert_int_eq(rb_push_tail_n(buffer, out, 8), 8);
+	ck_assert_int_eq(rb_reserve(buffer, 5, span), 2);
+	rb_commit(buffer, 0);
+	ck_assert_int_eq(rb_size(buffer), 8);
+}
+END_TEST
+
+START_TEST(test_rb_peek_release)
+{
+	uint8_t in[] = {0, 1, 2, 3, 4, 5, 6, 7};
+	uint8_t out;
+	uint8_t * block;
+	size_t peeked;
+	struct rb_span span[2];
+
+	ck_assert_int_eq(rb_peek(buffer, 1, span), 0);
+	rb_release(buffer, 0);
+
+	/* Create list wrapping from slot 6: [0, 1, 2, 3, 4, 5, 6, 7] */
+	for(size_t i = 0; i < 6; i++) {
+		rb_push_tail(buffer, &in[0]);
+		rb_pop_head_into(buffer, &out);
+	}
+	rb_push_tail_n(buffer, in, 8);
+
+	peeked = rb_peek(buffer, 20, span);
+	ck_assert_int_eq(peeked, 8);
+	ck_assert_int_eq(span[0].count, 4);
+	ck_assert_int_eq(span[1].count, 4);
+
+	block = span[1].data;
+	ck_assert_int_eq(block[0], in[4]);
+	rb_release(buffer, 5);
+
+	ck_assert_int_eq(rb_size(buffer), 3);
+	ck_assert(rb_pop_head_into(buffer, &out));
+	ck_assert_int_eq(out, in[5]);
+}
+END_TEST
+
+/**
+ * Test reading from and writing to pipes, with blocks split between calls and
+ * data wrapping around the end of the buffer.
+ */
+START_TEST(test_rb_fd)
+{
+	uint8_t in[20];
+	uint8_t out[20];
+	uint32_t block;
+	int from[2], to[2];
+	ring_buffer fd_buffer;
+	struct ds_properties fd_props = {
+		.data_size = sizeof(uint32_t),
+		.entries   = 4,
+	};
+
+	for(size_t i = 0; i < sizeof(in); i++)
+		in[i] = i;
+
+	fd_buffer = rb_create(&fd_props);
+	ck_assert_ptr_ne(fd_buffer, NULL);
+	ck_assert_int_eq(pipe(from), 0);
+	ck_assert_int_eq(pipe(to), 0);
+
+	/* Move the head to slot 3, so the data wraps. */
+	for(size_t i = 0; i < 3; i++) {
+		rb_push_tail(fd_buffer, &block);
+		rb_pop_head_into(fd_buffer, &block);
+	}
+
+	/* An empty buffer writes nothing. */
+	ck_assert_int_eq(rb_write_fd(fd_buffer, to[1], 4), 0);
+
+	/* 6 bytes are one block and half of another. */
+	ck_assert_int_eq(write(from[1], in, 6), 6);
+	ck_assert_int_eq(rb_read_fd(fd_buffer, from[0], 4), 6);
+	ck_assert_int_eq(rb_size(fd_buffer), 1);
+
+	/* The next read completes the partial block. */
+	ck_assert_int_eq(write(from[1], in + 6, 10), 10);
+	ck_assert_int_eq(rb_read_fd(fd_buffer, from[0], 4), 10);
+	ck_assert_int_eq(rb_size(fd_buffer), 4);
+	ck_assert(rb_pop_head_into(fd_buffer, &block));
+	ck_assert_mem_eq(&block, in, sizeof(block));
+
+	ck_assert_int_eq(write(from[1], in + 16, 4), 4);
+	ck_assert_int_eq(rb_read_fd(fd_buffer, from[0], 4), 4);
+	errno = 0;
+	ck_assert_int_eq(rb_read_fd(fd_buffer, from[0], 4), -1);
+	ck_assert_int_eq(errno, ENOBUFS);
+
+	/* The remaining 16 bytes are written back out, wrapped and in order. */
+	ck_assert_int_eq(rb_write_fd(fd_buffer, to[1], 4), 16);
+	ck_assert(rb_empty(fd_buffer));
+	ck_assert_int_eq(read(to[0], out, sizeof(out)), 16);
+	ck_assert_mem_eq(out, in + 4, 16);
+
+	/* End of file. */
+	close(from[1]);
+	ck_assert_int_eq(rb_read_fd(fd_buffer, from[0], 4), 0);
+
+	close(from[0]);
+	close(to[0]);
+	close(to[1]);
+	rb_destroy(&fd_buffer);
+}
+END_TEST
+
+/**
+ * Test that a growable buffer keeps a partly read block when it grows.
+ */
+START_TEST(test_rb_fd_growable)
+{
+	const char in[] = "AAAABBBBCCCCDDDD";
+	uint32_t block;
+	int from[2];
+	ring_buffer fd_buffer;
+	struct ds_properties fd_props = {
+		.data_size = sizeof(uint32_t),
+		.entries   = 2,
+		.growable  = true,
+	};
+
+	fd_buffer = rb_create(&fd_props);
+	ck_assert_ptr_ne(fd_buffer, NULL);
+	ck_assert_int_eq(pipe(from), 0);
+
+	ck_assert_int_eq(write(from[1], in, 6), 6);
+	ck_assert_int_eq(rb_read_fd(fd_buffer, from[0], 2), 6);
+	ck_assert_int_eq(rb_size(fd_buffer), 1);
+
+	/* Reserving three more blocks grows the buffer. */
+	ck_assert_int_eq(write(from[1], in + 6, 10), 10);
+	ck_assert_int_eq(rb_read_fd(fd_buffer, from[0], 3), 10);
+	ck_assert_int_gt(rb_capacity(fd_buffer), 2);
+	ck_assert_int_eq(rb_size(fd_buffer), 4);
+
+	for(size_t i = 0; i < 4; i++) {
+		ck_assert(rb_pop_head_into(fd_buffer, &block));
+		ck_assert_mem_eq(&block, in + 4 * i, sizeof(block));
+	}
+
+	/* Shrinking keeps a partly read block as well. */
+	ck_assert_int_eq(write(from[1], in, 6), 6);
+	ck_assert_int_eq(rb_read_fd(fd_buffer, from[0], 4), 6);
+	ck_assert(rb_shrink_to_fit(fd_buffer));
+	ck_assert_int_eq(rb_capacity(fd_buffer), 2);
+
+	ck_assert_int_eq(write(from[1], in + 6, 2), 2);
+	ck_assert_int_eq(rb_read_fd(fd_buffer, from[0], 1), 2);
+	ck_assert(rb_pop_head_into(fd_buffer, &block));
+	ck_assert_mem_eq(&block, in, sizeof(block));
+	ck_assert(rb_pop_head_into(fd_buffer, &block));
+	ck_assert_mem_eq(&block, in + 4, sizeof(block));
+
+	close(from[0]);
+	close(from[1]);
+	rb_destroy(&fd_buffer);
+}
+END_TEST
+
+/**
+ * Test that a mirrored buffer presents wrapped contents as one contiguous span.
+ * Page-sized blocks give a capacity of 3, which also covers non-power-of-two
+ * indexing.
+ */
+START_TEST(test_rb_mirror)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+	uint8_t * in;
+	uint8_t * out;
+	struct rb_span span[2];
+	struct ds_properties mirror_props = {
+		.data_size = page,
+		.entries   = 3,
+		.mirror    = true,
+	};
+	ring_buffer buf;
+
+	buf = rb_create(&mirror_props);
+	ck_assert(buf);
+
+	in  = malloc(3 * page);
+	out = malloc(3 * page);
+	for(size_t i = 0; i < 3 * page; i++)
+		in[i] = i % 251;
+
+	/* Move the head to the last slot, then fill the buffer. */
+	for(size_t i = 0; i < 2; i++) {
+		rb_push_tail(buf, in);
+		rb_pop_head_into(buf, out);
+	}
+	ck_assert_int_eq(rb_push_tail_n(buf, in, 3), 3);
+
+	ck_assert_int_eq(rb_peek(buf, 3, span), 3);
+	ck_assert_int_eq(span[0].count, 3);
+	ck_assert_int_eq(span[1].count, 0);
+	ck_assert(memcmp(span[0].data, in, 3 * page) == 0);
+	rb_release(buf, 1);
+
+	ck_assert_int_eq(rb_pop_head_n(buf, out, 3), 2);
+	ck_assert(memcmp(out, in + page, 2 * page) == 0);
+
+	free(in);
+	free(out);
+	rb_destroy(&buf);
+
+	/* The storage must be a whole number of pages. */
+	mirror_props.data_size = page + 1;
+	buf = rb_create(&mirror_props);
+	ck_assert(!buf);
+	ck_assert_int_eq(errno, EINVAL);
+}
+END_TEST
+
 START_TEST(test_rb_insert_single)
 {
 	bool success;
@@ -307,7 +710,7 @@ END_TEST
 START_TEST(test_rb_insert_multiple)
 {
 	uint8_t in[] = {1, 2, 3, 4};
-	bool success[3];
+	bool success[4];
 	uint8_t * out[4];
 	ring_buffer buf = NULL;
 
@@ -347,6 +750,44 @@ START_TEST(test_rb_insert_multiple)
 }
 END_TEST
 
+/**
+ * Insert at each index in turn into a buffer whose contents wrap around the end
+ * of its storage, and check that the other blocks keep their order.
+ */
+START_TEST(test_rb_insert_wrapped)
+{
+	size_t length = props.entries - 1;
+	uint8_t marker = 0xFF;
+	uint8_t out;
+	ring_buffer buf = NULL;
+
+	for(size_t pos = 0; pos < length; pos++) {
+		buf = rb_create(&props);
+
+		/* Move the head part way through the storage first. */
+		for(uint8_t i = 0; i < 6; i++) {
+			rb_push_tail(buf, &i);
+			rb_pop_head_into(buf, &out);
+		}
+		for(uint8_t i = 0; i < length; i++)
+			rb_push_tail(buf, &i);
+
+		ck_assert(rb_insert(buf, &marker, pos));
+		ck_assert(rb_full(buf));
+
+		for(uint8_t i = 0; i <= length; i++) {
+			ck_assert(rb_pop_head_into(buf, &out));
+			if(i == pos)
+				ck_assert_int_eq(out, marker);
+			else
+				ck_assert_int_eq(out, i - (i > pos));
+		}
+
+		rb_destroy(&buf);
+	}
+}
+END_TEST
+
 START_TEST(test_rb_fetch_empty)
 {
 	uint8_t * out[2];
@@ -412,6 +853,154 @@ START_TEST(test_rb_fetch_multiple)
 }
 END_TEST
 
+START_TEST(test_rb_fetch_into)
+{
+	uint8_t in[] = {0, 1, 2};
+	uint8_t out = 0xFF;
+	ring_buffer buf = NULL;
+
+	buf = rb_create(&props);
+	ck_assert(!rb_fetch_into(buf, 0, &out));
+	ck_assert_int_eq(out, 0xFF);
+
+	/* Create list: [0, 1, 2] */
+	rb_push_tail(buf, &in[0]);
+	rb_push_tail(buf, &in[1]);
+	rb_push_tail(buf, &in[2]);
+
+	ck_assert(rb_fetch_into(buf, 1, &out));
+	ck_assert_int_eq(out, in[1]);
+	ck_assert(rb_fetch_into(buf, -1, &out));
+	ck_assert_int_eq(out, in[2]);
+	ck_assert_int_eq(rb_size(buf), 3);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+/**
+ * Delete each index in turn from a buffer whose contents wrap around the end of
+ * its storage, and check that the remaining blocks keep their order.
+ */
+/* Fill a block with a filler byte, except for a distinguishing last byte. */
+static void make_block(uint8_t * block, const size_t size, const uint8_t n)
+{
+	memset(block, 0xAA, size);
+	block[size - 1] = n;
+}
+
+START_TEST(test_rb_elem)
+{
+	const size_t sizes[] = {1, 2, 3, 4, 8, 16, 24};
+	uint8_t block[32];
+	ring_buffer buf;
+
+	for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		struct ds_properties elem_props = props;
+
+		elem_props.data_size = sizes[s];
+		elem_props.entries   = 100;
+		buf = rb_create(&elem_props);
+		ck_assert(buf);
+
+		/* Wrap the contents around the end of the storage. */
+		for(uint8_t n = 0; n < 60; n++) {
+			make_block(block, sizes[s], n);
+			ck_assert(rb_push_tail(buf, block));
+		}
+		for(uint8_t n = 0; n < 60; n++)
+			ck_assert(rb_pop_head_into(buf, block));
+		for(uint8_t n = 0; n < 97; n++) {
+			make_block(block, sizes[s], n);
+			ck_assert(rb_push_tail(buf, block));
+		}
+
+		for(uint8_t n = 0; n < 97; n++) {
+			make_block(block, sizes[s], n);
+			ck_assert(rb_elem(buf, block));
+		}
+		for(uint8_t n = 97; n < 120; n++) {
+			make_block(block, sizes[s], n);
+			ck_assert(!rb_elem(buf, block));
+		}
+
+		/* Bytes spanning two adjacent blocks must not match. */
+		if(sizes[s] > 1) {
+			memset(block, 0xAA, sizes[s]);
+			block[0] = 5;
+			ck_assert(!rb_elem(buf, block));
+		}
+
+		rb_destroy(&buf);
+	}
+}
+END_TEST
+
+START_TEST(test_rb_delete)
+{
+	size_t entries = props.entries;
+	uint8_t out;
+	ring_buffer buf = NULL;
+
+	for(size_t pos = 0; pos < entries; pos++) {
+		buf = rb_create(&props);
+
+		/* Move the head part way through the storage first. */
+		for(uint8_t i = 0; i < entries / 2; i++) {
+			rb_push_tail(buf, &i);
+			rb_pop_head_into(buf, &out);
+		}
+		for(uint8_t i = 0; i < entries; i++)
+			rb_push_tail(buf, &i);
+
+		ck_assert(rb_delete(buf, pos));
+		ck_assert_int_eq(rb_size(buf), entries - 1);
+
+		for(uint8_t i = 0; i < entries; i++) {
+			if(i == pos)
+				continue;
+
+			ck_assert(rb_pop_head_into(buf, &out));
+			ck_assert_int_eq(out, i);
+		}
+		ck_assert(rb_empty(buf));
+
+		rb_destroy(&buf);
+	}
+}
+END_TEST
+
+START_TEST(test_rb_remove_into)
+{
+	uint8_t in[] = {1, 2, 3, 4};
+	uint8_t out = 0;
+	ring_buffer buf = NULL;
+
+	/* Create list: [1, 2, 3, 4] */
+	buf = rb_create(&props);
+	for(size_t i = 0; i < 4; i++)
+		rb_push_tail(buf, &in[i]);
+
+	/* [1, 2, 3, 4] -> [1, 2, 4] (3) */
+	ck_assert(rb_remove_into(buf, 2, &out));
+	ck_assert_int_eq(out, in[2]);
+	/* [1, 2, 4] -> [2, 4] (1) */
+	ck_assert(rb_remove_into(buf, 0, &out));
+	ck_assert_int_eq(out, in[0]);
+	/* [2, 4] -> [2] (4) */
+	ck_assert(rb_remove_into(buf, -1, &out));
+	ck_assert_int_eq(out, in[3]);
+	/* [2] -> [] (2) */
+	ck_assert(rb_remove_into(buf, 0, &out));
+	ck_assert_int_eq(out, in[1]);
+
+	ck_assert(!rb_remove_into(buf, 0, &out));
+	ck_assert(rb_empty(buf));
+
+	rb_destroy(&buf);
+}
+END_TEST
+
 START_TEST(test_rb_reverse_empty)
 {
 	bool success;
@@ -446,6 +1035,111 @@ START_TEST(test_rb_reverse)
 }
 END_TEST
 
+/* Reverse a wrapped buffer of `length` blocks of `size` bytes, and check the
+ * result. */
+static void check_reverse_wide(const uint8_t * in,
+	                       const size_t size,
+	                       const size_t length)
+{
+	uint8_t out[130 * 12];
+	ring_buffer buf;
+	struct ds_properties wide_props = {
+		.data_size = size,
+		.entries   = 150,
+	};
+
+	buf = rb_create(&wide_props);
+	ck_assert_ptr_ne(buf, NULL);
+
+	/* Start near the end of the storage so the contents wrap. */
+	for(size_t i = 0; i < 140; i++) {
+		rb_push_tail(buf, in);
+		rb_pop_head_into(buf, out);
+	}
+
+	rb_push_tail_n(buf, in, length);
+	ck_assert(rb_reverse(buf));
+	ck_assert_int_eq(rb_pop_head_n(buf, out, length), length);
+
+	for(size_t i = 0; i < length; i++)
+		ck_assert_mem_eq(out + i * size,
+		                 in + (length - 1 - i) * size,
+		                 size);
+
+	rb_destroy(&buf);
+}
+
+/**
+ * Test reversal of wrapped buffers with each vectorized block size, with
+ * lengths that leave a partial vector in the middle, and an odd block size.
+ */
+START_TEST(test_rb_reverse_wide)
+{
+	size_t sizes[] = {1, 2, 4, 8, 12};
+	size_t lengths[] = {2, 7, 33, 130};
+	uint8_t in[130 * 12];
+
+	for(size_t i = 0; i < sizeof(in); i++)
+		in[i] = i * 7;
+
+	for(size_t s = 0; s < array_size(sizes); s++)
+		for(size_t l = 0; l < array_size(lengths); l++)
+			check_reverse_wide(in, sizes[s], lengths[l]);
+}
+END_TEST
+
+/* Rotate a wrapped buffer of `length` blocks by `k`, and check the result. */
+static void check_rotate(const size_t entries,
+	                 const size_t length,
+	                 const ssize_t k)
+{
+	uint8_t in[16];
+	uint8_t out[16];
+	uint8_t junk;
+	ring_buffer buf;
+	struct ds_properties rotate_props = {
+		.data_size = sizeof(uint8_t),
+		.entries   = entries,
+	};
+
+	for(size_t i = 0; i < array_size(in); i++)
+		in[i] = i;
+
+	buf = rb_create(&rotate_props);
+	ck_assert_ptr_ne(buf, NULL);
+
+	for(size_t i = 0; i < entries - 3; i++) {
+		rb_push_tail(buf, &junk);
+		rb_pop_head_into(buf, &junk);
+	}
+
+	rb_push_tail_n(buf, in, length);
+	rb_rotate(buf, k);
+	ck_assert_int_eq(rb_size(buf), length);
+	ck_assert_int_eq(rb_pop_head_n(buf, out, length), length);
+
+	for(size_t i = 0; i < length; i++)
+		ck_assert_int_eq(out[i], in[(i + k + length) % length]);
+
+	rb_destroy(&buf);
+}
+
+/**
+ * Test every rotation of every length of a wrapped buffer, which covers full
+ * buffers, copying either side across the free space, and rotating in place.
+ */
+START_TEST(test_rb_rotate)
+{
+	size_t entries[] = {10, 16};
+	ssize_t length;
+
+	for(size_t e = 0; e < array_size(entries); e++)
+		for(length = 0; length <= (ssize_t) entries[e]; length++)
+			for(ssize_t k = -length; k <= length; k++)
+				check_rotate(entries[e], length, k);
+}
+END_TEST
+
 void increment(void * n)
 {
 	(*(uint8_t *) n)++;
@@ -621,6 +1315,952 @@ START_TEST(test_rb_all)
 }
 END_TEST
 
+bool even(const void * data)
+{
+	return (*(uint8_t *) data) % 2 == 0;
+}
+
+bool lt5(const void * data)
+{
+	return (*(uint8_t *) data) < 5;
+}
+
+/* Fill `buffer` with [0, 1, ..., 9], wrapped part way around its storage. */
+static void fill_wrapped(void)
+{
+	uint8_t out;
+
+	for(uint8_t i = 0; i < 6; i++) {
+		rb_push_tail(buffer, &i);
+		rb_pop_head_into(buffer, &out);
+	}
+	for(uint8_t i = 0; i < 10; i++)
+		rb_push_tail(buffer, &i);
+}
+
+START_TEST(test_rb_filter)
+{
+	uint8_t out[10];
+
+	/* Adjacent rejected elements must not be skipped over. */
+	fill_wrapped();
+	rb_filter(buffer, even);
+
+	ck_assert_int_eq(rb_size(buffer), 5);
+	ck_assert_int_eq(rb_pop_head_n(buffer, out, 10), 5);
+	for(size_t i = 0; i < 5; i++)
+		ck_assert_int_eq(out[i], 2 * i);
+
+	fill_wrapped();
+	rb_filter(buffer, lt0);
+	ck_assert(rb_empty(buffer));
+}
+END_TEST
+
+START_TEST(test_rb_drop_while)
+{
+	uint8_t out[10];
+
+	fill_wrapped();
+	rb_drop_while(buffer, lt5);
+
+	ck_assert_int_eq(rb_pop_head_n(buffer, out, 10), 5);
+	for(size_t i = 0; i < 5; i++)
+		ck_assert_int_eq(out[i], 5 + i);
+
+	fill_wrapped();
+	rb_drop_while(buffer, gte0);
+	ck_assert(rb_empty(buffer));
+}
+END_TEST
+
+START_TEST(test_rb_take_while)
+{
+	uint8_t out[10];
+
+	fill_wrapped();
+	rb_take_while(buffer, lt5);
+
+	ck_assert_int_eq(rb_pop_head_n(buffer, out, 10), 5);
+	for(size_t i = 0; i < 5; i++)
+		ck_assert_int_eq(out[i], i);
+
+	fill_wrapped();
+	rb_take_while(buffer, gte0);
+	ck_assert_int_eq(rb_size(buffer), 10);
+}
+END_TEST
+
+static const struct ds_properties grow_props = {
+	.data_size = sizeof(uint32_t),
+	.entries   = 4,
+	.growable  = true,
+};
+
+/**
+ * Test that a growable buffer grows when pushed onto while full, keeping the
+ * order of wrapped contents.
+ */
+START_TEST(test_rb_grow)
+{
+	uint32_t in[] = {100, 101, 102};
+	uint32_t out;
+	ring_buffer buf;
+
+	buf = rb_create(&grow_props);
+	ck_assert(buf);
+
+	/* Wrap the contents around the end of the storage: [2, 3, 4, 5] */
+	for(uint32_t i = 0; i < 4; i++)
+		ck_assert(rb_push_tail(buf, &i));
+	for(uint32_t i = 0; i < 2; i++)
+		ck_assert(rb_pop_head_into(buf, &out));
+	for(uint32_t i = 4; i < 6; i++)
+		ck_assert(rb_push_tail(buf, &i));
+	ck_assert(rb_full(buf));
+	ck_assert_int_eq(rb_capacity(buf), 4);
+
+	/* [2, 3, 4, 5, 6] */
+	ck_assert(rb_push_tail(buf, &(uint32_t){6}));
+	ck_assert_int_eq(rb_capacity(buf), 8);
+
+	/* [1, 2, ..., 6, 100, 101, 102] */
+	ck_assert(rb_push_tail_n(buf, in, array_size(in)) == array_size(in));
+	ck_assert(rb_full(buf));
+	ck_assert(rb_push_head(buf, &(uint32_t){1}));
+	ck_assert_int_eq(rb_capacity(buf), 16);
+	ck_assert_int_eq(rb_size(buf), 9);
+
+	for(uint32_t i = 1; i < 7; i++) {
+		ck_assert(rb_pop_head_into(buf, &out));
+		ck_assert_int_eq(out, i);
+	}
+	for(size_t i = 0; i < array_size(in); i++) {
+		ck_assert(rb_pop_head_into(buf, &out));
+		ck_assert_int_eq(out, in[i]);
+	}
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_reserve_capacity)
+{
+	uint32_t out;
+	ring_buffer buf;
+
+	buf = rb_create(&grow_props);
+	ck_assert(buf);
+
+	ck_assert(rb_reserve_capacity(buf, 100));
+	ck_assert_int_eq(rb_capacity(buf), 100);
+	ck_assert(rb_reserve_capacity(buf, 10));
+	ck_assert_int_eq(rb_capacity(buf), 100);
+
+	for(uint32_t i = 0; i < 50; i++)
+		rb_push_tail(buf, &i);
+	for(uint32_t i = 0; i < 45; i++)
+		rb_pop_head_into(buf, &out);
+
+	ck_assert(rb_shrink_to_fit(buf));
+	ck_assert_int_eq(rb_capacity(buf), 5);
+	ck_assert(rb_full(buf));
+	for(uint32_t i = 45; i < 50; i++) {
+		ck_assert(rb_pop_head_into(buf, &out));
+		ck_assert_int_eq(out, i);
+	}
+
+	ck_assert(rb_shrink_to_fit(buf));
+	ck_assert_int_eq(rb_capacity(buf), 1);
+
+	rb_destroy(&buf);
+
+	/* Only growable buffers can be resized. */
+	errno = 0;
+	ck_assert(!rb_reserve_capacity(buffer, 100));
+	ck_assert_int_eq(errno, EINVAL);
+	ck_assert(!rb_shrink_to_fit(buffer));
+	ck_assert_int_eq(rb_capacity(buffer), props.entries);
+}
+END_TEST
+
+/**
+ * Exercise a buffer at both ends across many wrap-arounds, comparing it
+ * against a plain array model of the same contents.
+ */
+static void check_wrapping(const struct ds_properties * wrap_props)
+{
+	uint8_t model[64];
+	size_t length = 0;
+	uint8_t * out;
+	ring_buffer buf;
+
+	buf = rb_create(wrap_props);
+	ck_assert(buf);
+
+	for(uint8_t n = 0; n < 200; n++) {
+		switch(n % 5) {
+		case 0:
+		case 1:
+			if(rb_push_tail(buf, &n))
+				model[length++] = n;
+			break;
+		case 2:
+			if(rb_push_head(buf, &n)) {
+				memmove(model + 1, model, length);
+				model[0] = n;
+				length++;
+			}
+			break;
+		case 3:
+			if((out = rb_pop_head(buf))) {
+				ck_assert_int_eq(*out, model[0]);
+				memmove(model, model + 1, --length);
+				free(out);
+			}
+			break;
+		case 4:
+			if((out = rb_pop_tail(buf))) {
+				ck_assert_int_eq(*out, model[--length]);
+				free(out);
+			}
+			break;
+		}
+
+		ck_assert_int_eq(rb_size(buf), length);
+
+		/* Walk the buffer both ways with the iteration macros. */
+		size_t i;
+		uint8_t * current;
+		ring_buffer_foreach_i(buf, i, current)
+			ck_assert_int_eq(*current, model[i]);
+		ring_buffer_foreach_i_rev(buf, i, current)
+			ck_assert_int_eq(*current, model[length - 1 - i]);
+	}
+
+	rb_destroy(&buf);
+}
+
+START_TEST(test_rb_wrap_pow2)
+{
+	struct ds_properties wrap_props = props;
+
+	wrap_props.entries = 8;
+	check_wrapping(&wrap_props);
+}
+END_TEST
+
+START_TEST(test_rb_wrap_non_pow2)
+{
+	struct ds_properties wrap_props = props;
+
+	wrap_props.entries = 7;
+	check_wrapping(&wrap_props);
+}
+END_TEST
+
+RING_BUFFER_DEFINE(u32_rb, uint32_t)
+
+/**
+ * Exercise the typed interface at both ends across many wrap-arounds,
+ * checking it against the generic interface on the same buffer.
+ */
+static void check_typed(const size_t entries)
+{
+	uint32_t model[16];
+	size_t length = 0;
+	uint32_t out;
+	ring_buffer buf;
+	struct ds_properties typed_props = {
+		.data_size = sizeof(uint32_t),
+		.entries   = entries,
+	};
+
+	buf = u32_rb_create(&typed_props);
+	ck_assert(buf);
+
+	for(uint32_t n = 0; n < 200; n++) {
+		uint32_t value = n * 0x01010101;
+
+		switch(n % 5) {
+		case 0:
+		case 1:
+			if(u32_rb_push_tail(buf, value))
+				model[length++] = value;
+			break;
+		case 2:
+			if(u32_rb_push_head(buf, value)) {
+				memmove(model + 1, model,
+				        length * sizeof(*model));
+				model[0] = value;
+				length++;
+			}
+			break;
+		case 3:
+			if(u32_rb_pop_head(buf, &out)) {
+				ck_assert_int_eq(out, model[0]);
+				length--;
+				memmove(model, model + 1,
+				        length * sizeof(*model));
+			}
+			break;
+		case 4:
+			if(u32_rb_pop_tail(buf, &out))
+				ck_assert_int_eq(out, model[--length]);
+			break;
+		}
+
+		ck_assert_int_eq(rb_size(buf), length);
+
+		size_t i;
+		uint32_t * current;
+		ring_buffer_typed_foreach_i(u32_rb, buf, i, current) {
+			ck_assert_int_eq(*current, model[i]);
+			ck_assert(rb_fetch_into(buf, i, &out));
+			ck_assert_int_eq(out, model[i]);
+		}
+	}
+
+	rb_destroy(&buf);
+}
+
+START_TEST(test_rb_typed)
+{
+	check_typed(8);
+	check_typed(7);
+}
+END_TEST
+
+START_TEST(test_rb_typed_overwrite)
+{
+	uint32_t out;
+	ring_buffer buf;
+	struct ds_properties typed_props = {
+		.data_size = sizeof(uint32_t),
+		.entries   = 4,
+		.overwrite = true,
+	};
+
+	/* The data size must match the type. */
+	ck_assert(!u32_rb_create(&props));
+	ck_assert_int_eq(errno, EINVAL);
+
+	buf = u32_rb_create(&typed_props);
+	ck_assert(buf);
+
+	for(uint32_t n = 0; n < 6; n++)
+		ck_assert(u32_rb_push_tail(buf, n));
+	ck_assert_int_eq(rb_size(buf), 4);
+
+	/* Pushing at the head drops the block at the tail. */
+	ck_assert(u32_rb_push_head(buf, 100));
+	ck_assert(u32_rb_pop_tail(buf, &out));
+	ck_assert_int_eq(out, 4);
+	ck_assert(u32_rb_pop_head(buf, &out));
+	ck_assert_int_eq(out, 100);
+	ck_assert(u32_rb_pop_head(buf, &out));
+	ck_assert_int_eq(out, 2);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_file)
+{
+	char path[] = "/tmp/focs-rb-XXXXXX";
+	uint32_t out;
+	ring_buffer buf;
+	ring_buffer copy;
+	struct ds_properties file_props = {
+		.data_size = sizeof(uint32_t),
+		.entries   = 10,
+		.path      = path,
+	};
+	struct ds_properties copy_props = file_props;
+	struct ds_properties bad_props  = file_props;
+	pid_t child;
+	int status;
+	int ready[2];
+	int fd;
+
+	copy_props.path    = NULL;
+	bad_props.entries  = 8;
+
+	fd = mkstemp(path);
+	ck_assert_int_ge(fd, 0);
+	close(fd);
+
+	buf = rb_create(&file_props);
+	ck_assert(buf);
+	ck_assert(rb_empty(buf));
+
+	/* Leave the contents wrapped around the end of the storage. */
+	for(uint32_t n = 0; n < 10; n++)
+		ck_assert(rb_push_tail(buf, &n));
+	for(uint32_t n = 0; n < 8; n++)
+		ck_assert(rb_pop_head_into(buf, &out));
+	for(uint32_t n = 10; n < 12; n++)
+		ck_assert(rb_push_tail(buf, &n));
+
+	/* The file can only be attached once, but can be copied while it is. */
+	ck_assert(!rb_create(&file_props));
+	ck_assert_int_eq(errno, EWOULDBLOCK);
+
+	copy = rb_load(path, &copy_props);
+	ck_assert(copy);
+	ck_assert_int_eq(rb_size(copy), 4);
+	for(uint32_t n = 8; n < 12; n++) {
+		ck_assert(rb_pop_head_into(copy, &out));
+		ck_assert_int_eq(out, n);
+	}
+	rb_destroy(&copy);
+
+	ck_assert(rb_sync(buf));
+	rb_destroy(&buf);
+	ck_assert(!buf);
+
+	/* The buffer is recovered from the file, and can be used as normal. */
+	ck_assert(!rb_create(&bad_props));
+	ck_assert_int_eq(errno, EINVAL);
+
+	buf = rb_create(&file_props);
+	ck_assert(buf);
+	ck_assert_int_eq(rb_size(buf), 4);
+	for(uint32_t n = 12; n < 18; n++)
+		ck_assert(rb_push_tail(buf, &n));
+	ck_assert(rb_full(buf));
+	for(uint32_t n = 8; n < 18; n++) {
+		ck_assert(rb_pop_head_into(buf, &out));
+		ck_assert_int_eq(out, n);
+	}
+	rb_destroy(&buf);
+
+	/* A process that crashes in the middle of a write leaves the file
+	 * marked as being written.  A copy started while it still had the file
+	 * open finishes once it is gone. */
+	ck_assert_int_eq(pipe(ready), 0);
+	child = fork();
+	ck_assert_int_ge(child, 0);
+	if(child == 0) {
+		buf = rb_create(&file_props);
+		if(!buf)
+			_exit(1);
+		for(uint32_t n = 0; n < 3; n++)
+			rb_push_tail(buf, &n);
+		DS_PRIV(buf)->seq++;
+
+		if(write(ready[1], "", 1) != 1)
+			_exit(1);
+		usleep(100000);
+		_exit(0);
+	}
+	ck_assert_int_eq(read(ready[0], &out, 1), 1);
+	close(ready[0]);
+	close(ready[1]);
+
+	copy = rb_load(path, &copy_props);
+	ck_assert(copy);
+	ck_assert_int_eq(rb_size(copy), 3);
+	rb_destroy(&copy);
+
+	ck_assert_int_eq(waitpid(child, &status, 0), child);
+	ck_assert(WIFEXITED(status));
+	ck_assert_int_eq(WEXITSTATUS(status), 0);
+
+	unlink(path);
+}
+END_TEST
+
+START_TEST(test_rb_shared)
+{
+	char path[64];
+	uint32_t out;
+	pid_t child;
+	int status;
+	ring_buffer buf;
+	struct ds_properties shm_props = {
+		.data_size = sizeof(uint32_t),
+		.entries   = 16,
+		.spsc      = true,
+		.shared    = true,
+		.path      = path,
+	};
+	struct ds_properties bad_props = shm_props;
+
+	snprintf(path, sizeof(path), "/focs-rb-%d", (int) getpid());
+	shm_unlink(path);
+
+	buf = rb_create(&shm_props);
+	ck_assert(buf);
+
+	/* Attaching with a different capacity fails. */
+	bad_props.entries = 8;
+	ck_assert(!rb_create(&bad_props));
+	ck_assert_int_eq(errno, EINVAL);
+
+	/* Nothing in another process could wake a waiter, so shared buffers
+	 * cannot block. */
+	bad_props = shm_props;
+	bad_props.blocking = true;
+	ck_assert(!rb_create(&bad_props));
+	ck_assert_int_eq(errno, EINVAL);
+
+	errno = 0;
+	ck_assert(!rb_pop_head_wait(buf, &out, NULL));
+	ck_assert_int_eq(errno, EINVAL);
+
+	/* A child process attaches to the segment and produces into it. */
+	child = fork();
+	ck_assert_int_ge(child, 0);
+	if(child == 0) {
+		ring_buffer producer = rb_create(&shm_props);
+
+		if(!producer)
+			_exit(1);
+		for(uint32_t n = 0; n < 1000; n++)
+			while(!rb_push_tail(producer, &n))
+				sched_yield();
+
+		rb_destroy(&producer);
+		_exit(0);
+	}
+
+	for(uint32_t n = 0; n < 1000; n++) {
+		while(!rb_pop_head_into(buf, &out))
+			sched_yield();
+		ck_assert_int_eq(out, n);
+	}
+
+	ck_assert_int_eq(waitpid(child, &status, 0), child);
+	ck_assert(WIFEXITED(status));
+	ck_assert_int_eq(WEXITSTATUS(status), 0);
+	ck_assert(rb_empty(buf));
+
+	rb_destroy(&buf);
+	shm_unlink(path);
+}
+END_TEST
+
+START_TEST(test_rb_create_invalid)
+{
+	ring_buffer buf;
+	struct ds_properties bad_props = props;
+
+	bad_props.entries = 0;
+	buf = rb_create(&bad_props);
+
+	ck_assert(!buf);
+	ck_assert_int_eq(errno, EINVAL);
+
+	bad_props = props;
+	bad_props.growable  = true;
+	bad_props.overwrite = true;
+	buf = rb_create(&bad_props);
+
+	ck_assert(!buf);
+	ck_assert_int_eq(errno, EINVAL);
+
+	bad_props = props;
+	bad_props.shared = true;
+	bad_props.path   = "/focs-rb-invalid";
+	buf = rb_create(&bad_props);
+
+	ck_assert(!buf);
+	ck_assert_int_eq(errno, EINVAL);
+
+	bad_props = props;
+	bad_props.growable = true;
+	bad_props.path     = "/tmp/focs-rb-invalid";
+	buf = rb_create(&bad_props);
+
+	ck_assert(!buf);
+	ck_assert_int_eq(errno, EINVAL);
+}
+END_TEST
+
+static const struct ds_properties spsc_props = {
+	.data_size = sizeof(uint32_t),
+	.entries   = 10,
+	.spsc      = true,
+};
+
+START_TEST(test_rb_spsc_overwrite)
+{
+	ring_buffer buf;
+	struct ds_properties bad_props = spsc_props;
+
+	bad_props.overwrite = true;
+	buf = rb_create(&bad_props);
+
+	ck_assert(!buf);
+	ck_assert_int_eq(errno, EINVAL);
+}
+END_TEST
+
+START_TEST(test_rb_spsc_fill_drain)
+{
+	uint32_t * out;
+	uint32_t in;
+	ring_buffer buf;
+
+	buf = rb_create(&spsc_props);
+	ck_assert(buf);
+
+	/* Fill the buffer completely, wrapping around the end of storage. */
+	for(size_t pass = 0; pass < 3; pass++) {
+		for(in = 0; in < spsc_props.entries; in++)
+			ck_assert(rb_push_tail(buf, &in));
+
+		ck_assert(rb_full(buf));
+		ck_assert(!rb_push_tail(buf, &in));
+		ck_assert_int_eq(rb_size(buf), spsc_props.entries);
+
+		for(uint32_t i = 0; i < spsc_props.entries; i++) {
+			out = rb_pop_head(buf);
+
+			ck_assert(out);
+			ck_assert_int_eq(*out, i);
+
+			free(out);
+		}
+
+		ck_assert(rb_empty(buf));
+		ck_assert(!rb_pop_head(buf));
+	}
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_spsc_batch)
+{
+	uint32_t in[7];
+	uint32_t out[array_size(in)];
+	uint32_t next = 0;
+	uint32_t expected = 0;
+	ring_buffer buf;
+
+	buf = rb_create(&spsc_props);
+	ck_assert(buf);
+
+	for(size_t pass = 0; pass < 10; pass++) {
+		size_t pushed;
+		size_t popped;
+
+		for(size_t i = 0; i < array_size(in); i++)
+			in[i] = next + i;
+
+		pushed = rb_push_tail_n(buf, in, array_size(in));
+		ck_assert(pushed > 0);
+		next += pushed;
+
+		popped = rb_pop_head_n(buf, out, 4);
+		for(size_t i = 0; i < popped; i++)
+			ck_assert_int_eq(out[i], expected++);
+	}
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+#define SPSC_TRANSFERS 100000
+
+/* Produce values in place, in reservations of varying size. */
+static void * spsc_span_producer(void * arg)
+{
+	uint32_t next = 0;
+	uint32_t * block;
+	size_t reserved;
+	struct rb_span span[2];
+	ring_buffer buf = arg;
+
+	while(next < SPSC_TRANSFERS) {
+		reserved = MIN(next % 7 + 1, SPSC_TRANSFERS - next);
+		reserved = rb_reserve(buf, reserved, span);
+		if(!reserved) {
+			rb_commit(buf, 0);
+			sched_yield();
+			continue;
+		}
+
+		for(size_t i = 0; i < 2; i++) {
+			block = span[i].data;
+			for(size_t j = 0; j < span[i].count; j++)
+				block[j] = next++;
+		}
+		rb_commit(buf, reserved);
+	}
+
+	return NULL;
+}
+
+static void * spsc_producer(void * arg)
+{
+	ring_buffer buf = arg;
+
+	for(uint32_t i = 0; i < SPSC_TRANSFERS; i++)
+		while(!rb_push_tail(buf, &i))
+			sched_yield();
+
+	return NULL;
+}
+
+START_TEST(test_rb_spsc_threaded)
+{
+	uint32_t * out;
+	pthread_t producer;
+	ring_buffer buf;
+
+	buf = rb_create(&spsc_props);
+	ck_assert(buf);
+
+	pthread_create(&producer, NULL, spsc_producer, buf);
+
+	/* Every value must arrive exactly once, in order. */
+	for(uint32_t i = 0; i < SPSC_TRANSFERS; i++) {
+		while(!(out = rb_pop_head(buf)))
+			sched_yield();
+
+		ck_assert_int_eq(*out, i);
+		free(out);
+	}
+
+	pthread_join(producer, NULL);
+
+	ck_assert(rb_empty(buf));
+	rb_destroy(&buf);
+}
+END_TEST
+
+START_TEST(test_rb_spsc_span)
+{
+	uint32_t expected = 0;
+	uint32_t * block;
+	size_t peeked;
+	pthread_t producer;
+	struct rb_span span[2];
+	ring_buffer buf;
+
+	buf = rb_create(&spsc_props);
+	ck_assert(buf);
+
+	pthread_create(&producer, NULL, spsc_span_producer, buf);
+
+	/* Every value must arrive exactly once, in order. */
+	while(expected < SPSC_TRANSFERS) {
+		peeked = rb_peek(buf, 5, span);
+		if(!peeked) {
+			rb_release(buf, 0);
+			sched_yield();
+			continue;
+		}
+
+		for(size_t i = 0; i < 2; i++) {
+			block = span[i].data;
+			for(size_t j = 0; j < span[i].count; j++)
+				ck_assert_int_eq(block[j], expected++);
+		}
+		rb_release(buf, peeked);
+	}
+
+	pthread_join(producer, NULL);
+
+	ck_assert(rb_empty(buf));
+	rb_destroy(&buf);
+}
+END_TEST
+
+/**
+ * Test that SPSC pushes and pops still see the right amount of room and data
+ * after another operation has moved the head or tail behind their backs.
+ */
+START_TEST(test_rb_spsc_resync)
+{
+	uint32_t in;
+	uint32_t out;
+	size_t pushed = 0;
+	ring_buffer buf;
+
+	buf = rb_create(&spsc_props);
+	ck_assert(buf);
+
+	/* Leave the producer's copy of the head at the real head. */
+	for(in = 0; in < spsc_props.entries; in++)
+		ck_assert(rb_push_tail(buf, &in));
+	for(size_t i = 0; i < spsc_props.entries; i++)
+		ck_assert(rb_pop_head_into(buf, &out));
+	ck_assert(rb_push_tail(buf, &in));
+
+	/* Moving the head backwards leaves one block less room. */
+	ck_assert(rb_push_head(buf, &in));
+	while(rb_push_tail(buf, &in))
+		pushed++;
+	ck_assert_int_eq(pushed, spsc_props.entries - 2);
+	ck_assert(rb_full(buf));
+
+	/* Dropping blocks from the tail leaves the consumer less to pop. */
+	ck_assert(rb_pop_tail_into(buf, &out));
+	for(size_t i = 0; i < spsc_props.entries - 1; i++)
+		ck_assert(rb_pop_head_into(buf, &out));
+	ck_assert(!rb_pop_head_into(buf, &out));
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+static const struct ds_properties blocking_props = {
+	.data_size = sizeof(uint8_t),
+	.entries   = 10,
+	.blocking  = true,
+};
+
+START_TEST(test_rb_wait_timeout)
+{
+	uint8_t in = 1;
+	uint8_t out;
+	struct timespec timeout = { .tv_sec = 0, .tv_nsec = 10000000 };
+	ring_buffer buf;
+
+	/* A buffer created without `blocking` cannot be waited on. */
+	errno = 0;
+	ck_assert(!rb_pop_head_wait(buffer, &out, &timeout));
+	ck_assert_int_eq(errno, EINVAL);
+	errno = 0;
+	ck_assert(!rb_push_tail_wait(buffer, &in, &timeout));
+	ck_assert_int_eq(errno, EINVAL);
+
+	buf = rb_create(&blocking_props);
+	ck_assert(buf);
+
+	errno = 0;
+	ck_assert(!rb_pop_head_wait(buf, &out, &timeout));
+	ck_assert_int_eq(errno, ETIMEDOUT);
+
+	while(!rb_full(buf))
+		rb_push_tail(buf, &in);
+
+	errno = 0;
+	ck_assert(!rb_push_tail_wait(buf, &in, &timeout));
+	ck_assert_int_eq(errno, ETIMEDOUT);
+	ck_assert_int_eq(rb_size(buf), blocking_props.entries);
+
+	ck_assert(rb_pop_head_wait(buf, &out, &timeout));
+	ck_assert_int_eq(out, in);
+
+	rb_destroy(&buf);
+}
+END_TEST
+
+static void * wait_producer(void * arg)
+{
+	ring_buffer buf = arg;
+
+	for(uint32_t i = 0; i < SPSC_TRANSFERS; i++)
+		rb_push_tail_wait(buf, &i, NULL);
+
+	return NULL;
+}
+
+static void __test_rb_wait_threaded(const struct ds_properties * props)
+{
+	uint32_t out;
+	pthread_t producer;
+	ring_buffer buf;
+
+	buf = rb_create(props);
+	ck_assert(buf);
+
+	pthread_create(&producer, NULL, wait_producer, buf);
+
+	/* Every value must arrive exactly once, in order, with neither side
+	 * polling. */
+	for(uint32_t i = 0; i < SPSC_TRANSFERS; i++) {
+		ck_assert(rb_pop_head_wait(buf, &out, NULL));
+		ck_assert_int_eq(out, i);
+	}
+
+	pthread_join(producer, NULL);
+
+	ck_assert(rb_empty(buf));
+	rb_destroy(&buf);
+}
+
+START_TEST(test_rb_wait_threaded)
+{
+	struct ds_properties wait_props = spsc_props;
+
+	wait_props.blocking = true;
+	__test_rb_wait_threaded(&wait_props);
+	wait_props.spsc = false;
+	__test_rb_wait_threaded(&wait_props);
+}
+END_TEST
+
+static bool reader_done;
+
+/* Repeatedly fill and drain the buffer with blocks that all hold the same
+ * value. */
+static void * refill_writer(void * arg)
+{
+	uint32_t in[10];
+	uint32_t out[10];
+	ring_buffer buf = arg;
+
+	for(uint32_t i = 0;
+	    !__atomic_load_n(&reader_done, __ATOMIC_ACQUIRE);
+	    i++) {
+		for(size_t j = 0; j < array_size(in); j++)
+			in[j] = i;
+
+		rb_push_tail_n(buf, in, array_size(in));
+		sched_yield();
+		rb_pop_head_n(buf, out, array_size(out));
+	}
+
+	return NULL;
+}
+
+/**
+ * Test that lock-free queries running alongside a writer only ever see states
+ * the buffer was actually in.
+ */
+START_TEST(test_rb_read_optimistic)
+{
+	uint32_t out;
+	uint32_t absent = UINT32_MAX;
+	struct ds_properties locked_props = spsc_props;
+	pthread_t writer;
+	ring_buffer buf;
+
+	locked_props.spsc = false;
+	buf = rb_create(&locked_props);
+	ck_assert(buf);
+
+	reader_done = false;
+	pthread_create(&writer, NULL, refill_writer, buf);
+
+	for(size_t i = 0; i < 100000; i++) {
+		size_t size = rb_size(buf);
+
+		ck_assert(size == 0 || size == locked_props.entries);
+		ck_assert(!rb_elem(buf, &absent));
+
+		/* Fills only ever count up, so a later fetch never sees an
+		 * older fill than an earlier one. */
+		if(rb_fetch_into(buf, 0, &out)) {
+			uint32_t last;
+
+			if(rb_fetch_into(buf, -1, &last))
+				ck_assert_int_le(out, last);
+		}
+	}
+
+	__atomic_store_n(&reader_done, true, __ATOMIC_RELEASE);
+	pthread_join(writer, NULL);
+	rb_destroy(&buf);
+}
+END_TEST
+
 Suite * rb_suite(void)
 {
 	Suite * suite;
@@ -629,14 +2269,24 @@ Suite * rb_suite(void)
 	TCase * case_rb_push_tail;
 	TCase * case_rb_pop_head;
 	TCase * case_rb_pop_tail;
+	TCase * case_rb_batch;
+	TCase * case_rb_span;
 	TCase * case_rb_insert;
 	TCase * case_rb_fetch;
+	TCase * case_rb_elem;
+	TCase * case_rb_remove;
 	TCase * case_rb_reverse;
 	TCase * case_rb_map;
 	TCase * case_rb_foldr;
 	TCase * case_rb_foldl;
 	TCase * case_rb_any;
 	TCase * case_rb_all;
+	TCase * case_rb_filter;
+	TCase * case_rb_wrap;
+	TCase * case_rb_typed;
+	TCase * case_rb_grow;
+	TCase * case_rb_spsc;
+	TCase * case_rb_wait;
 
 	suite = suite_create("Ring Buffer");
 
@@ -645,26 +2295,44 @@ Suite * rb_suite(void)
 	case_rb_push_tail = tcase_create("rb_push_tail");
 	case_rb_pop_head  = tcase_create("rb_pop_head");
 	case_rb_pop_tail  = tcase_create("rb_pop_tail");
+	case_rb_batch     = tcase_create("rb_batch");
+	case_rb_span      = tcase_create("rb_span");
 	case_rb_insert    = tcase_create("rb_insert");
 	case_rb_fetch     = tcase_create("rb_fetch");
+	case_rb_elem      = tcase_create("rb_elem");
+	case_rb_remove    = tcase_create("rb_remove");
 	case_rb_reverse   = tcase_create("rb_reverse");
 	case_rb_map       = tcase_create("rb_map");
 	case_rb_foldr     = tcase_create("rb_foldr");
 	case_rb_foldl     = tcase_create("rb_foldl");
 	case_rb_any       = tcase_create("rb_any");
 	case_rb_all       = tcase_create("rb_all");
+	case_rb_filter    = tcase_create("rb_filter");
+	case_rb_wrap      = tcase_create("rb_wrap");
+	case_rb_typed     = tcase_create("rb_typed");
+	case_rb_grow      = tcase_create("rb_grow");
+	case_rb_spsc      = tcase_create("rb_spsc");
+	case_rb_wait      = tcase_create("rb_wait");
 
 	tcase_add_checked_fixture(case_rb_create,    setup, takedown);
 	tcase_add_checked_fixture(case_rb_push_head, setup, takedown);
 	tcase_add_checked_fixture(case_rb_push_tail, setup, takedown);
+	tcase_add_checked_fixture(case_rb_batch,     setup, takedown);
+	tcase_add_checked_fixture(case_rb_span,      setup, takedown);
+	tcase_add_checked_fixture(case_rb_wait,      setup, takedown);
 	tcase_add_checked_fixture(case_rb_reverse,   setup, takedown);
 	tcase_add_checked_fixture(case_rb_map,       setup, takedown);
 	tcase_add_checked_fixture(case_rb_foldr,     setup, takedown);
 	tcase_add_checked_fixture(case_rb_foldl,     setup, takedown);
 	tcase_add_checked_fixture(case_rb_any,       setup, takedown);
 	tcase_add_checked_fixture(case_rb_all,       setup, takedown);
+	tcase_add_checked_fixture(case_rb_filter,    setup, takedown);
+	tcase_add_checked_fixture(case_rb_grow,      setup, takedown);
 
 	tcase_add_test(case_rb_create,    test_rb_create);
+	tcase_add_test(case_rb_create,    test_rb_create_invalid);
+	tcase_add_test(case_rb_create,    test_rb_file);
+	tcase_add_test(case_rb_create,    test_rb_shared);
 	tcase_add_test(case_rb_push_head, test_rb_push_head_single);
 	tcase_add_test(case_rb_push_head, test_rb_push_head_multiple);
 	tcase_add_test(case_rb_push_tail, test_rb_push_tail_single);
@@ -675,13 +2343,32 @@ Suite * rb_suite(void)
 	tcase_add_test(case_rb_pop_tail,  test_rb_pop_tail_empty);
 	tcase_add_test(case_rb_pop_tail,  test_rb_pop_tail_single);
 	tcase_add_test(case_rb_pop_tail,  test_rb_pop_tail_multiple);
+	tcase_add_test(case_rb_pop_tail,  test_rb_pop_into);
+	tcase_add_test(case_rb_batch,     test_rb_push_tail_n);
+	tcase_add_test(case_rb_batch,     test_rb_push_tail_n_full);
+	tcase_add_test(case_rb_batch,     test_rb_push_n_overwrite);
+	tcase_add_test(case_rb_batch,     test_rb_push_head_n);
+	tcase_add_test(case_rb_batch,     test_rb_pop_tail_n);
+	tcase_add_test(case_rb_span,      test_rb_reserve_commit);
+	tcase_add_test(case_rb_span,      test_rb_peek_release);
+	tcase_add_test(case_rb_span,      test_rb_fd);
+	tcase_add_test(case_rb_span,      test_rb_fd_growable);
+	tcase_add_test(case_rb_span,      test_rb_mirror);
 	tcase_add_test(case_rb_insert,    test_rb_insert_single);
 	tcase_add_test(case_rb_insert,    test_rb_insert_multiple);
+	tcase_add_test(case_rb_insert,    test_rb_insert_wrapped);
 	tcase_add_test(case_rb_fetch,     test_rb_fetch_empty);
 	tcase_add_test(case_rb_fetch,     test_rb_fetch_single);
 	tcase_add_test(case_rb_fetch,     test_rb_fetch_multiple);
+	tcase_add_test(case_rb_fetch,     test_rb_fetch_into);
+	tcase_add_test(case_rb_fetch,     test_rb_read_optimistic);
+	tcase_add_test(case_rb_elem,      test_rb_elem);
+	tcase_add_test(case_rb_remove,    test_rb_delete);
+	tcase_add_test(case_rb_remove,    test_rb_remove_into);
 	tcase_add_test(case_rb_reverse,   test_rb_reverse_empty);
 	tcase_add_test(case_rb_reverse,   test_rb_reverse);
+	tcase_add_test(case_rb_reverse,   test_rb_reverse_wide);
+	tcase_add_test(case_rb_reverse,   test_rb_rotate);
 	tcase_add_test(case_rb_map,       test_rb_map_empty);
 	tcase_add_test(case_rb_map,       test_rb_map);
 	tcase_add_test(case_rb_foldr,     test_rb_foldr_empty);
@@ -692,20 +2379,47 @@ Suite * rb_suite(void)
 	tcase_add_test(case_rb_any,       test_rb_any);
 	tcase_add_test(case_rb_all,       test_rb_all_empty);
 	tcase_add_test(case_rb_all,       test_rb_all);
+	tcase_add_test(case_rb_filter,    test_rb_filter);
+	tcase_add_test(case_rb_filter,    test_rb_drop_while);
+	tcase_add_test(case_rb_filter,    test_rb_take_while);
+	tcase_add_test(case_rb_wrap,      test_rb_wrap_pow2);
+	tcase_add_test(case_rb_wrap,      test_rb_wrap_non_pow2);
+	tcase_add_test(case_rb_typed,     test_rb_typed);
+	tcase_add_test(case_rb_typed,     test_rb_typed_overwrite);
+	tcase_add_test(case_rb_grow,      test_rb_grow);
+	tcase_add_test(case_rb_grow,      test_rb_reserve_capacity);
+	tcase_add_test(case_rb_spsc,      test_rb_spsc_overwrite);
+	tcase_add_test(case_rb_spsc,      test_rb_spsc_fill_drain);
+	tcase_add_test(case_rb_spsc,      test_rb_spsc_batch);
+	tcase_add_test(case_rb_spsc,      test_rb_spsc_threaded);
+	tcase_add_test(case_rb_spsc,      test_rb_spsc_span);
+	tcase_add_test(case_rb_spsc,      test_rb_spsc_resync);
+	tcase_add_test(case_rb_wait,      test_rb_wait_timeout);
+	tcase_add_test(case_rb_wait,      test_rb_wait_threaded);
 
 	suite_add_tcase(suite, case_rb_create);
 	suite_add_tcase(suite, case_rb_push_head);
 	suite_add_tcase(suite, case_rb_push_tail);
 	suite_add_tcase(suite, case_rb_pop_head);
 	suite_add_tcase(suite, case_rb_pop_tail);
+	suite_add_tcase(suite, case_rb_batch);
+	suite_add_tcase(suite, case_rb_span);
 	suite_add_tcase(suite, case_rb_insert);
 	suite_add_tcase(suite, case_rb_fetch);
+	suite_add_tcase(suite, case_rb_elem);
+	suite_add_tcase(suite, case_rb_remove);
 	suite_add_tcase(suite, case_rb_reverse);
 	suite_add_tcase(suite, case_rb_map);
 	suite_add_tcase(suite, case_rb_foldr);
 	suite_add_tcase(suite, case_rb_foldl);
 	suite_add_tcase(suite, case_rb_any);
 	suite_add_tcase(suite, case_rb_all);
+	suite_add_tcase(suite, case_rb_filter);
+	suite_add_tcase(suite, case_rb_wrap);
+	suite_add_tcase(suite, case_rb_typed);
+	suite_add_tcase(suite, case_rb_grow);
+	suite_add_tcase(suite, case_rb_spsc);
+	suite_add_tcase(suite, case_rb_wait);
 
 	return suite;
 }
@@ -0,0 +1,597 @@
+/* skip_list.c - Unit Tests for Indexable Skip List
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <check.h>
+
+#include "list/skip_list.h"
+
+#define MODEL_SIZE 2000
+
+static const struct ds_properties props = {
+	.data_size = sizeof(uint32_t),
+};
+
+/* An odd size, so the links are not right after the data. */
+static const struct ds_properties odd_props = {
+	.data_size = 5,
+};
+
+static struct sk_link * links_of(const skip_list list, struct sk_node * node)
+{
+	size_t offset = (DS_DATA_SIZE(list) + 7) & ~(size_t) 7;
+
+	return (struct sk_link *) (node->data + offset);
+}
+
+/* Check every level and span of `list`, and that it holds `expected`. */
+static void check_list(const skip_list list,
+	               const uint32_t * expected,
+	               const size_t length)
+{
+	static struct sk_node * nodes[MODEL_SIZE + 1];
+	struct sk_link * links;
+	struct sk_node * node;
+	size_t level = DS_PRIV(list)->level;
+	size_t rank;
+	size_t i = 0;
+
+	ck_assert_int_eq(DS_PRIV(list)->length, length);
+	ck_assert_int_ge(level, 1);
+	ck_assert_int_le(level, SK_MAX_LEVEL);
+	if(level > 1)
+		ck_assert(DS_PRIV(list)->head[level - 1].next);
+
+	for(node = DS_PRIV(list)->head[0].next; node; node = links[0].next) {
+		links = links_of(list, node);
+
+		ck_assert_int_lt(i, length);
+		ck_assert_int_le(node->levels, level);
+		ck_assert_int_eq(*(uint32_t *) node->data, expected[i]);
+		nodes[++i] = node;
+	}
+	ck_assert_int_eq(i, length);
+
+	/* Walk each level, checking that it visits exactly the nodes with
+	 * that level, and that each span is the distance between positions. */
+	for(size_t l = 0; l < level; l++) {
+		links = DS_PRIV(list)->head;
+		rank = 0;
+
+		for(i = 1; i <= length; i++) {
+			if(nodes[i]->levels <= l)
+				continue;
+
+			ck_assert_ptr_eq(links[l].next, nodes[i]);
+			ck_assert_int_eq(links[l].span, i - rank);
+
+			links = links_of(list, nodes[i]);
+			rank = i;
+		}
+
+		ck_assert(!links[l].next);
+		ck_assert_int_eq(links[l].span, length + 1 - rank);
+	}
+}
+
+static bool pred_even(uint32_t * n)
+{
+	return *n % 2 == 0;
+}
+
+static bool pred_small(uint32_t * n)
+{
+	return *n < 10;
+}
+
+static bool pred_any(__unused uint32_t * n)
+{
+	return true;
+}
+
+static bool pred_none(__unused uint32_t * n)
+{
+	return false;
+}
+
+static void increment(uint32_t * n)
+{
+	(*n)++;
+}
+
+static void subtract_left(uint32_t * acc, const uint32_t * n)
+{
+	*acc -= *n;
+}
+
+static void subtract_right(const uint32_t * n, uint32_t * acc)
+{
+	*acc = *n - *acc;
+}
+
+START_TEST(test_sk_create)
+{
+	skip_list list;
+
+	list = sk_create(&props);
+	ck_assert(list);
+	ck_assert(sk_empty(list));
+	ck_assert_int_eq(sk_size(list), 0);
+	check_list(list, NULL, 0);
+	sk_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_sk_push)
+{
+	uint32_t expected[400];
+	uint32_t in;
+	skip_list list;
+
+	list = sk_create(&props);
+
+	/* [199, 198, ..., 0, 200, 201, ..., 399] */
+	for(in = 0; in < 200; in++) {
+		sk_push_head(list, &in);
+		expected[199 - in] = in;
+	}
+	for(in = 200; in < 400; in++) {
+		sk_push_tail(list, &in);
+		expected[in] = in;
+	}
+
+	check_list(list, expected, 400);
+	ck_assert_int_eq(sk_size(list), 400);
+	ck_assert(!sk_empty(list));
+	ck_assert_int_gt(DS_PRIV(list)->level, 1);
+
+	sk_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_sk_pop)
+{
+	uint32_t in;
+	uint32_t out;
+	uint32_t * data;
+	skip_list list;
+
+	list = sk_create(&props);
+
+	ck_assert(!sk_pop_head(list));
+	ck_assert(!sk_pop_tail(list));
+	ck_assert(!sk_pop_head_into(list, &out));
+	ck_assert(!sk_pop_tail_into(list, &out));
+
+	for(in = 0; in < 100; in++)
+		sk_push_tail(list, &in);
+
+	data = sk_pop_head(list);
+	ck_assert(data);
+	ck_assert_int_eq(*data, 0);
+	free(data);
+
+	data = sk_pop_tail(list);
+	ck_assert(data);
+	ck_assert_int_eq(*data, 99);
+	free(data);
+
+	for(in = 1; in < 50; in++) {
+		ck_assert(sk_pop_head_into(list, &out));
+		ck_assert_int_eq(out, in);
+	}
+	for(in = 98; in >= 50; in--) {
+		ck_assert(sk_pop_tail_into(list, &out));
+		ck_assert_int_eq(out, in);
+	}
+
+	ck_assert(sk_empty(list));
+	check_list(list, NULL, 0);
+	ck_assert_int_eq(DS_PRIV(list)->level, 1);
+
+	sk_destroy(&list);
+}
+END_TEST
+
+/**
+ * Insert and remove at pseudo-random positions, checking every level against
+ * a plain array after each operation.
+ */
+START_TEST(test_sk_insert_remove)
+{
+	static uint32_t expected[MODEL_SIZE];
+	size_t length = 0;
+	uint32_t random = 1;
+	uint32_t out;
+	uint32_t * data;
+	size_t pos;
+	skip_list list;
+
+	list = sk_create(&props);
+
+	ck_assert(!sk_insert(list, &random, 1));
+	ck_assert(!sk_delete(list, 0));
+	ck_assert(!sk_remove(list, 0));
+	ck_assert(!sk_remove_into(list, 0, &out));
+
+	for(uint32_t i = 0; i < 3 * MODEL_SIZE; i++) {
+		random = random * 1103515245 + 12345;
+
+		/* Grow the list for the first half, then shrink it. */
+		if(length == 0 ||
+		   (length < MODEL_SIZE && (random >> 8) % 3 != (i < 1500))) {
+			pos = (random >> 4) % (length + 1);
+
+			ck_assert(sk_insert(list, &i, pos));
+			memmove(&expected[pos + 1],
+			        &expected[pos],
+			        (length - pos) * sizeof(*expected));
+			expected[pos] = i;
+			length++;
+		} else {
+			pos = (random >> 4) % length;
+
+			switch(i % 3) {
+			case 0:
+				ck_assert(sk_delete(list, pos));
+				break;
+			case 1:
+				data = sk_remove(list, pos);
+				ck_assert(data);
+				ck_assert_int_eq(*data, expected[pos]);
+				free(data);
+				break;
+			default:
+				ck_assert(sk_remove_into(list, pos, &out));
+				ck_assert_int_eq(out, expected[pos]);
+				break;
+			}
+
+			memmove(&expected[pos],
+			        &expected[pos + 1],
+			        (length - pos - 1) * sizeof(*expected));
+			length--;
+		}
+
+		if(i % 50 == 0)
+			check_list(list, expected, length);
+	}
+
+	check_list(list, expected, length);
+	sk_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_sk_odd_size)
+{
+	uint8_t in[5];
+	uint8_t out[5];
+	skip_list list;
+
+	list = sk_create(&odd_props);
+
+	for(uint8_t i = 0; i < 100; i++) {
+		memset(in, i, sizeof(in));
+		ck_assert(sk_insert(list, in, i / 2));
+	}
+
+	for(uint8_t i = 0; i < 50; i++) {
+		memset(in, 2 * i + 1, sizeof(in));
+		ck_assert_mem_eq(sk_fetch(list, i), in, sizeof(in));
+	}
+
+	ck_assert(sk_pop_tail_into(list, out));
+	memset(in, 0, sizeof(in));
+	ck_assert_mem_eq(out, in, sizeof(in));
+
+	sk_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_sk_fetch_elem)
+{
+	uint32_t in;
+	uint32_t * data;
+	skip_list list;
+
+	list = sk_create(&props);
+
+	in = 0;
+	ck_assert(!sk_fetch(list, 0));
+	ck_assert(!sk_elem(list, &in));
+
+	for(in = 0; in < 1000; in++)
+		sk_push_tail(list, &in);
+
+	for(in = 0; in < 1000; in++) {
+		data = sk_fetch(list, in);
+		ck_assert(data);
+		ck_assert_int_eq(*data, in);
+	}
+
+	for(in = 0; in < 1000; in += 37)
+		ck_assert(sk_elem(list, &in));
+
+	in = 1000;
+	ck_assert(!sk_fetch(list, 1000));
+	ck_assert(!sk_elem(list, &in));
+
+	sk_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_sk_any_all)
+{
+	uint32_t in;
+	skip_list list;
+
+	list = sk_create(&props);
+
+	ck_assert(!sk_any(list, (pred_fn) pred_any));
+	ck_assert(!sk_all(list, (pred_fn) pred_any));
+
+	for(in = 0; in < 40; in += 2)
+		sk_push_tail(list, &in);
+
+	ck_assert(sk_all(list, (pred_fn) pred_even));
+	ck_assert(sk_any(list, (pred_fn) pred_small));
+	ck_assert(!sk_all(list, (pred_fn) pred_small));
+
+	in = 39;
+	sk_push_tail(list, &in);
+	ck_assert(!sk_all(list, (pred_fn) pred_even));
+
+	sk_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_sk_filter)
+{
+	uint32_t expected[500];
+	uint32_t in;
+	skip_list list;
+
+	list = sk_create(&props);
+
+	ck_assert(!sk_filter(list, (pred_fn) pred_even));
+
+	for(in = 0; in < 1000; in++) {
+		sk_push_tail(list, &in);
+		if(in % 2 == 0)
+			expected[in / 2] = in;
+	}
+
+	ck_assert(sk_filter(list, (pred_fn) pred_even));
+	ck_assert(!sk_filter(list, (pred_fn) pred_even));
+	check_list(list, expected, 500);
+
+	ck_assert(sk_filter(list, (pred_fn) pred_small));
+	check_list(list, expected, 5);
+
+	ck_assert(sk_filter(list, (pred_fn) pred_none));
+	check_list(list, expected, 0);
+
+	sk_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_sk_drop_while)
+{
+	uint32_t expected[200];
+	uint32_t in;
+	skip_list list;
+
+	list = sk_create(&props);
+
+	ck_assert(!sk_drop_while(list, (pred_fn) pred_small));
+
+	for(in = 0; in < 200; in++) {
+		sk_push_tail(list, &in);
+		expected[in] = in;
+	}
+
+	ck_assert(sk_drop_while(list, (pred_fn) pred_small));
+	check_list(list, &expected[10], 190);
+	ck_assert(!sk_drop_while(list, (pred_fn) pred_small));
+
+	ck_assert(sk_drop_while(list, (pred_fn) pred_any));
+	check_list(list, expected, 0);
+
+	sk_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_sk_take_while)
+{
+	uint32_t expected[200];
+	uint32_t in;
+	skip_list list;
+
+	list = sk_create(&props);
+
+	ck_assert(!sk_take_while(list, (pred_fn) pred_small));
+
+	for(in = 0; in < 200; in++) {
+		sk_push_tail(list, &in);
+		expected[in] = in;
+	}
+
+	ck_assert(!sk_take_while(list, (pred_fn) pred_any));
+	ck_assert(sk_take_while(list, (pred_fn) pred_small));
+	check_list(list, expected, 10);
+
+	ck_assert(sk_take_while(list, (pred_fn) pred_none));
+	check_list(list, expected, 0);
+
+	sk_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_sk_map)
+{
+	uint32_t expected[300];
+	uint32_t in;
+	skip_list list;
+
+	list = sk_create(&props);
+
+	sk_map(list, (map_fn) increment);
+	ck_assert(sk_empty(list));
+
+	for(in = 0; in < 300; in++) {
+		sk_push_tail(list, &in);
+		expected[in] = in + 1;
+	}
+
+	sk_map(list, (map_fn) increment);
+	check_list(list, expected, 300);
+
+	sk_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_sk_reverse)
+{
+	uint32_t expected[300];
+	uint32_t in;
+	skip_list list;
+
+	list = sk_create(&props);
+
+	sk_reverse(list);
+	check_list(list, NULL, 0);
+
+	for(in = 0; in < 300; in++) {
+		sk_push_tail(list, &in);
+		expected[299 - in] = in;
+	}
+
+	sk_reverse(list);
+	check_list(list, expected, 300);
+
+	ck_assert_int_eq(*(uint32_t *) sk_fetch(list, 100), 199);
+
+	sk_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_sk_fold)
+{
+	uint32_t init = 0;
+	uint32_t * out;
+	skip_list list;
+
+	list = sk_create(&props);
+
+	out = sk_foldl(list, (foldl_fn) subtract_left, &init);
+	ck_assert_int_eq(*out, 0);
+	free(out);
+
+	for(uint32_t in = 1; in <= 41; in++)
+		sk_push_tail(list, &in);
+
+	/* foldl (-) 1000 [1..41] -> 139 */
+	init = 1000;
+	out = sk_foldl(list, (foldl_fn) subtract_left, &init);
+	ck_assert_int_eq(*out, 139);
+	free(out);
+
+	/* foldr (-) 0 [1..41] -> 21 */
+	init = 0;
+	out = sk_foldr(list, (foldr_fn) subtract_right, &init);
+	ck_assert_int_eq(*out, 21);
+	free(out);
+
+	sk_destroy(&list);
+}
+END_TEST
+
+Suite * sk_suite(void)
+{
+	Suite * suite;
+	TCase * case_sk_create;
+	TCase * case_sk_push;
+	TCase * case_sk_pop;
+	TCase * case_sk_insert;
+	TCase * case_sk_fetch;
+	TCase * case_sk_any;
+	TCase * case_sk_filter;
+	TCase * case_sk_drop_while;
+	TCase * case_sk_take_while;
+	TCase * case_sk_map;
+	TCase * case_sk_reverse;
+	TCase * case_sk_fold;
+
+	suite = suite_create("Skip List");
+
+	case_sk_create = tcase_create("sk_create");
+	case_sk_push = tcase_create("sk_push");
+	case_sk_pop = tcase_create("sk_pop");
+	case_sk_insert = tcase_create("sk_insert");
+	case_sk_fetch = tcase_create("sk_fetch");
+	case_sk_any = tcase_create("sk_any");
+	case_sk_filter = tcase_create("sk_filter");
+	case_sk_drop_while = tcase_create("sk_drop_while");
+	case_sk_take_while = tcase_create("sk_take_while");
+	case_sk_map = tcase_create("sk_map");
+	case_sk_reverse = tcase_create("sk_reverse");
+	case_sk_fold = tcase_create("sk_fold");
+
+	tcase_add_test(case_sk_create, test_sk_create);
+	tcase_add_test(case_sk_push, test_sk_push);
+	tcase_add_test(case_sk_pop, test_sk_pop);
+	tcase_add_test(case_sk_insert, test_sk_insert_remove);
+	tcase_add_test(case_sk_insert, test_sk_odd_size);
+	tcase_add_test(case_sk_fetch, test_sk_fetch_elem);
+	tcase_add_test(case_sk_any, test_sk_any_all);
+	tcase_add_test(case_sk_filter, test_sk_filter);
+	tcase_add_test(case_sk_drop_while, test_sk_drop_while);
+	tcase_add_test(case_sk_take_while, test_sk_take_while);
+	tcase_add_test(case_sk_map, test_sk_map);
+	tcase_add_test(case_sk_reverse, test_sk_reverse);
+	tcase_add_test(case_sk_fold, test_sk_fold);
+
+	suite_add_tcase(suite, case_sk_create);
+	suite_add_tcase(suite, case_sk_push);
+	suite_add_tcase(suite, case_sk_pop);
+	suite_add_tcase(suite, case_sk_insert);
+	suite_add_tcase(suite, case_sk_fetch);
+	suite_add_tcase(suite, case_sk_any);
+	suite_add_tcase(suite, case_sk_filter);
+	suite_add_tcase(suite, case_sk_drop_while);
+	suite_add_tcase(suite, case_sk_take_while);
+	suite_add_tcase(suite, case_sk_map);
+	suite_add_tcase(suite, case_sk_reverse);
+	suite_add_tcase(suite, case_sk_fold);
+
+	return suite;
+}
+
+int main(void)
+{
+	Suite * suite_sk;
+	SRunner * suite_runner;
+
+	suite_sk = sk_suite();
+
+	suite_runner = srunner_create(suite_sk);
+	srunner_run_all(suite_runner, CK_NORMAL);
+	srunner_free(suite_runner);
+
+	return 0;
+}
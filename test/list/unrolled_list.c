@@ -0,0 +1,618 @@
+/* unrolled_list.c - Unit Tests for Unrolled Linked List
+ * Copyright (C) 2018 Quytelda Kahja
+ *
+ * This file is part of focs.
+ *
+ * focs is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * focs is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with focs.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <check.h>
+
+#include "list/unrolled_list.h"
+
+static const struct ds_properties props = {
+	.data_size = sizeof(uint32_t),
+};
+
+/* Four elements to a node, so a few dozen elements span many nodes. */
+struct wide {
+	uint32_t value;
+	uint8_t  pad[12];
+};
+
+static const struct ds_properties wide_props = {
+	.data_size = sizeof(struct wide),
+};
+
+static const struct ds_properties pooled_props = {
+	.data_size = sizeof(uint32_t),
+	.pooled    = true,
+};
+
+/* Check the node structure of `list` and that it holds `expected`. */
+static void check_list(const unrolled_list list,
+	               const uint32_t * expected,
+	               const size_t length)
+{
+	struct ul_node * node;
+	struct ul_node * last = NULL;
+	size_t stride = DS_DATA_SIZE(list);
+	size_t i = 0;
+
+	ck_assert_int_eq(DS_PRIV(list)->length, length);
+
+	linked_list_foreach(list, node) {
+		ck_assert_int_gt(node->count, 0);
+		ck_assert_int_le(node->count, DS_PRIV(list)->capacity);
+
+		for(size_t j = 0; j < node->count; j++, i++) {
+			ck_assert_int_lt(i, length);
+			ck_assert_int_eq(*(uint32_t *)
+			                 (node->data + j * stride),
+			                 expected[i]);
+		}
+
+		last = node;
+	}
+
+	ck_assert_int_eq(i, length);
+	ck_assert_ptr_eq(DS_PRIV(list)->tail, last);
+}
+
+static bool pred_even(uint32_t * n)
+{
+	return *n % 2 == 0;
+}
+
+static bool pred_small(uint32_t * n)
+{
+	return *n < 10;
+}
+
+static bool pred_lt8(uint32_t * n)
+{
+	return *n < 8;
+}
+
+static bool pred_any(__unused uint32_t * n)
+{
+	return true;
+}
+
+static bool pred_none(__unused uint32_t * n)
+{
+	return false;
+}
+
+static void increment(uint32_t * n)
+{
+	(*n)++;
+}
+
+static void subtract_left(uint32_t * acc, const uint32_t * n)
+{
+	*acc -= *n;
+}
+
+static void subtract_right(const uint32_t * n, uint32_t * acc)
+{
+	*acc = *n - *acc;
+}
+
+START_TEST(test_ul_create)
+{
+	unrolled_list list;
+	struct ds_properties empty_props = {
+		.data_size = 0,
+	};
+
+	list = ul_create(&props);
+	ck_assert(list);
+	ck_assert(ul_empty(list));
+	ck_assert_int_eq(DS_PRIV(list)->capacity,
+	                 CACHE_LINE_SIZE / sizeof(uint32_t));
+	ul_destroy(&list);
+
+	list = ul_create(&wide_props);
+	ck_assert(list);
+	ck_assert_int_eq(DS_PRIV(list)->capacity, 4);
+	ul_destroy(&list);
+
+	ck_assert(!ul_create(&empty_props));
+	ck_assert_int_eq(errno, EINVAL);
+}
+END_TEST
+
+START_TEST(test_ul_push)
+{
+	uint32_t expected[40];
+	uint32_t in;
+	unrolled_list list;
+
+	list = ul_create(&props);
+
+	/* [19, 18, ..., 0, 20, 21, ..., 39] */
+	for(in = 0; in < 20; in++) {
+		ul_push_head(list, &in);
+		expected[19 - in] = in;
+	}
+	for(in = 20; in < 40; in++) {
+		ul_push_tail(list, &in);
+		expected[in] = in;
+	}
+
+	check_list(list, expected, 40);
+	ck_assert_int_eq(ul_size(list), 40);
+	ck_assert(!ul_empty(list));
+
+	ul_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_ul_pop)
+{
+	uint32_t in;
+	struct wide out;
+	uint32_t * data;
+	unrolled_list list;
+
+	list = ul_create(&wide_props);
+
+	ck_assert(!ul_pop_head(list));
+	ck_assert(!ul_pop_tail(list));
+	ck_assert(!ul_pop_head_into(list, &out));
+	ck_assert(!ul_pop_tail_into(list, &out));
+
+	for(in = 0; in < 10; in++) {
+		struct wide w = { .value = in };
+		ul_push_tail(list, &w);
+	}
+
+	data = ul_pop_head(list);
+	ck_assert(data);
+	ck_assert_int_eq(*data, 0);
+	free(data);
+
+	data = ul_pop_tail(list);
+	ck_assert(data);
+	ck_assert_int_eq(*data, 9);
+	free(data);
+
+	for(in = 1; in < 5; in++) {
+		ck_assert(ul_pop_head_into(list, &out));
+		ck_assert_int_eq(out.value, in);
+	}
+	for(in = 8; in >= 5; in--) {
+		ck_assert(ul_pop_tail_into(list, &out));
+		ck_assert_int_eq(out.value, in);
+	}
+
+	ck_assert(ul_empty(list));
+	ck_assert(!DS_PRIV(list)->head);
+	ck_assert(!DS_PRIV(list)->tail);
+
+	ul_destroy(&list);
+}
+END_TEST
+
+/**
+ * Insert into the middle of full nodes, forcing them to split, then remove
+ * elements until the nodes have to merge again.
+ */
+START_TEST(test_ul_insert_remove)
+{
+	uint32_t expected[64];
+	size_t length = 0;
+	struct wide out;
+	uint32_t * data;
+	unrolled_list list;
+
+	list = ul_create(&wide_props);
+
+	ck_assert(!ul_insert(list, &(struct wide) { .value = 0 }, 1));
+
+	for(uint32_t i = 0; i < 64; i++) {
+		size_t pos = (i * 7) % (length + 1);
+		struct wide w = { .value = i };
+
+		ck_assert(ul_insert(list, &w, pos));
+		memmove(&expected[pos + 1],
+		        &expected[pos],
+		        (length - pos) * sizeof(*expected));
+		expected[pos] = i;
+		length++;
+
+		check_list(list, expected, length);
+	}
+
+	ck_assert(!ul_delete(list, length));
+	ck_assert(!ul_remove(list, length));
+	ck_assert(!ul_remove_into(list, length, &out));
+
+	while(length > 0) {
+		size_t pos = (length * 5 + 3) % length;
+
+		switch(length % 3) {
+		case 0:
+			ck_assert(ul_delete(list, pos));
+			break;
+		case 1:
+			data = ul_remove(list, pos);
+			ck_assert(data);
+			ck_assert_int_eq(*data, expected[pos]);
+			free(data);
+			break;
+		default:
+			ck_assert(ul_remove_into(list, pos, &out));
+			ck_assert_int_eq(out.value, expected[pos]);
+			break;
+		}
+
+		memmove(&expected[pos],
+		        &expected[pos + 1],
+		        (length - pos - 1) * sizeof(*expected));
+		length--;
+
+		check_list(list, expected, length);
+	}
+
+	ck_assert(!DS_PRIV(list)->head);
+	ul_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_ul_fetch_elem)
+{
+	uint32_t in;
+	uint32_t * data;
+	unrolled_list list;
+
+	list = ul_create(&props);
+
+	in = 0;
+	ck_assert(!ul_fetch(list, 0));
+	ck_assert(!ul_elem(list, &in));
+
+	for(in = 0; in < 100; in++)
+		ul_push_tail(list, &in);
+
+	for(in = 0; in < 100; in++) {
+		data = ul_fetch(list, in);
+		ck_assert(data);
+		ck_assert_int_eq(*data, in);
+		ck_assert(ul_elem(list, &in));
+	}
+
+	ck_assert(!ul_fetch(list, 100));
+	ck_assert(!ul_elem(list, &in));
+
+	ul_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_ul_any_all)
+{
+	uint32_t in;
+	unrolled_list list;
+
+	list = ul_create(&props);
+
+	ck_assert(!ul_any(list, (pred_fn) pred_any));
+	ck_assert(!ul_all(list, (pred_fn) pred_any));
+
+	for(in = 0; in < 40; in += 2)
+		ul_push_tail(list, &in);
+
+	ck_assert(ul_all(list, (pred_fn) pred_even));
+	ck_assert(ul_any(list, (pred_fn) pred_small));
+	ck_assert(!ul_all(list, (pred_fn) pred_small));
+
+	in = 39;
+	ul_push_tail(list, &in);
+	ck_assert(!ul_all(list, (pred_fn) pred_even));
+
+	ul_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_ul_filter)
+{
+	uint32_t expected[50];
+	uint32_t in;
+	unrolled_list list;
+
+	list = ul_create(&wide_props);
+
+	ck_assert(!ul_filter(list, (pred_fn) pred_even));
+
+	for(in = 0; in < 100; in++) {
+		struct wide w = { .value = in };
+		ul_push_tail(list, &w);
+		if(in % 2 == 0)
+			expected[in / 2] = in;
+	}
+
+	ck_assert(ul_filter(list, (pred_fn) pred_even));
+	ck_assert(!ul_filter(list, (pred_fn) pred_even));
+	check_list(list, expected, 50);
+
+	/* The survivors are packed into full nodes. */
+	ck_assert_int_eq(DS_PRIV(list)->head->count, 4);
+
+	ck_assert(ul_filter(list, (pred_fn) pred_small));
+	check_list(list, expected, 5);
+
+	ck_assert(ul_filter(list, (pred_fn) pred_none));
+	check_list(list, expected, 0);
+	ck_assert(!DS_PRIV(list)->head);
+
+	ul_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_ul_drop_while)
+{
+	uint32_t expected[20];
+	uint32_t in;
+	unrolled_list list;
+
+	list = ul_create(&wide_props);
+
+	ck_assert(!ul_drop_while(list, (pred_fn) pred_small));
+
+	for(in = 0; in < 20; in++) {
+		struct wide w = { .value = in };
+		ul_push_tail(list, &w);
+		expected[in] = in;
+	}
+
+	ck_assert(ul_drop_while(list, (pred_fn) pred_small));
+	check_list(list, &expected[10], 10);
+	ck_assert(!ul_drop_while(list, (pred_fn) pred_small));
+
+	ck_assert(ul_drop_while(list, (pred_fn) pred_any));
+	check_list(list, expected, 0);
+	ck_assert(!DS_PRIV(list)->head);
+
+	ul_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_ul_take_while)
+{
+	uint32_t expected[20];
+	uint32_t in;
+	unrolled_list list;
+
+	list = ul_create(&wide_props);
+
+	ck_assert(!ul_take_while(list, (pred_fn) pred_small));
+
+	for(in = 0; in < 20; in++) {
+		struct wide w = { .value = in };
+		ul_push_tail(list, &w);
+		expected[in] = in;
+	}
+
+	ck_assert(!ul_take_while(list, (pred_fn) pred_any));
+	ck_assert(ul_take_while(list, (pred_fn) pred_small));
+	check_list(list, expected, 10);
+
+	/* Stopping at a node boundary keeps the whole previous node. */
+	ck_assert(ul_take_while(list, (pred_fn) pred_lt8));
+	check_list(list, expected, 8);
+
+	ck_assert(ul_take_while(list, (pred_fn) pred_none));
+	check_list(list, expected, 0);
+	ck_assert(!DS_PRIV(list)->head);
+
+	ul_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_ul_map)
+{
+	uint32_t expected[30];
+	uint32_t in;
+	unrolled_list list;
+
+	list = ul_create(&props);
+
+	ul_map(list, (map_fn) increment);
+	ck_assert(ul_empty(list));
+
+	for(in = 0; in < 30; in++) {
+		ul_push_tail(list, &in);
+		expected[in] = in + 1;
+	}
+
+	ul_map(list, (map_fn) increment);
+	check_list(list, expected, 30);
+
+	ul_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_ul_reverse)
+{
+	uint32_t expected[23];
+	uint32_t in;
+	unrolled_list list;
+
+	list = ul_create(&wide_props);
+
+	ul_reverse(list);
+	ck_assert(!DS_PRIV(list)->head);
+	ck_assert(!DS_PRIV(list)->tail);
+
+	/* Nodes of 4, 3, 4, 4, 4, and 3 elements. */
+	for(in = 0; in < 23; in++) {
+		struct wide w = { .value = in };
+		ul_push_tail(list, &w);
+		expected[22 - in] = in;
+	}
+	ck_assert(ul_delete(list, 5));
+	memmove(&expected[17], &expected[18], 5 * sizeof(*expected));
+
+	ul_reverse(list);
+	check_list(list, expected, 22);
+
+	ul_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_ul_fold)
+{
+	uint32_t init = 0;
+	uint32_t * out;
+	unrolled_list list;
+
+	list = ul_create(&props);
+
+	out = ul_foldl(list, (foldl_fn) subtract_left, &init);
+	ck_assert_int_eq(*out, 0);
+	free(out);
+
+	for(uint32_t in = 1; in <= 41; in++)
+		ul_push_tail(list, &in);
+
+	/* foldl (-) 1000 [1..41] -> 139 */
+	init = 1000;
+	out = ul_foldl(list, (foldl_fn) subtract_left, &init);
+	ck_assert_int_eq(*out, 139);
+	free(out);
+
+	/* foldr (-) 0 [1..41] -> 21 */
+	init = 0;
+	out = ul_foldr(list, (foldr_fn) subtract_right, &init);
+	ck_assert_int_eq(*out, 21);
+	free(out);
+
+	ul_destroy(&list);
+}
+END_TEST
+
+START_TEST(test_ul_pooled)
+{
+	uint32_t expected[1000];
+	uint32_t in;
+	uint32_t out;
+	unrolled_list list;
+
+	list = ul_create(&pooled_props);
+	ck_assert(list);
+	ck_assert(DS_PRIV(list)->pool);
+
+	for(in = 0; in < 1000; in++) {
+		ul_push_tail(list, &in);
+		expected[in] = in;
+	}
+
+	ck_assert(ul_insert(list, &in, 500));
+	ck_assert(ul_remove_into(list, 500, &out));
+	ck_assert_int_eq(out, 1000);
+	check_list(list, expected, 1000);
+
+	ck_assert(ul_filter(list, (pred_fn) pred_small));
+	check_list(list, expected, 10);
+
+	for(in = 0; in < 10; in++) {
+		ck_assert(ul_pop_head_into(list, &out));
+		ck_assert_int_eq(out, in);
+	}
+	ck_assert(ul_empty(list));
+
+	for(in = 0; in < 100; in++)
+		ul_push_head(list, &in);
+	ul_destroy(&list);
+}
+END_TEST
+
+Suite * ul_suite(void)
+{
+	Suite * suite;
+	TCase * case_ul_create;
+	TCase * case_ul_push;
+	TCase * case_ul_pop;
+	TCase * case_ul_insert;
+	TCase * case_ul_fetch;
+	TCase * case_ul_any;
+	TCase * case_ul_filter;
+	TCase * case_ul_drop_while;
+	TCase * case_ul_take_while;
+	TCase * case_ul_map;
+	TCase * case_ul_reverse;
+	TCase * case_ul_fold;
+	TCase * case_ul_pool;
+
+	suite = suite_create("Unrolled List");
+
+	case_ul_create = tcase_create("ul_create");
+	case_ul_push = tcase_create("ul_push");
+	case_ul_pop = tcase_create("ul_pop");
+	case_ul_insert = tcase_create("ul_insert");
+	case_ul_fetch = tcase_create("ul_fetch");
+	case_ul_any = tcase_create("ul_any");
+	case_ul_filter = tcase_create("ul_filter");
+	case_ul_drop_while = tcase_create("ul_drop_while");
+	case_ul_take_while = tcase_create("ul_take_while");
+	case_ul_map = tcase_create("ul_map");
+	case_ul_reverse = tcase_create("ul_reverse");
+	case_ul_fold = tcase_create("ul_fold");
+	case_ul_pool = tcase_create("ul_pool");
+
+	tcase_add_test(case_ul_create, test_ul_create);
+	tcase_add_test(case_ul_push, test_ul_push);
+	tcase_add_test(case_ul_pop, test_ul_pop);
+	tcase_add_test(case_ul_insert, test_ul_insert_remove);
+	tcase_add_test(case_ul_fetch, test_ul_fetch_elem);
+	tcase_add_test(case_ul_any, test_ul_any_all);
+	tcase_add_test(case_ul_filter, test_ul_filter);
+	tcase_add_test(case_ul_drop_while, test_ul_drop_while);
+	tcase_add_test(case_ul_take_while, test_ul_take_while);
+	tcase_add_test(case_ul_map, test_ul_map);
+	tcase_add_test(case_ul_reverse, test_ul_reverse);
+	tcase_add_test(case_ul_fold, test_ul_fold);
+	tcase_add_test(case_ul_pool, test_ul_pooled);
+
+	suite_add_tcase(suite, case_ul_create);
+	suite_add_tcase(suite, case_ul_push);
+	suite_add_tcase(suite, case_ul_pop);
+	suite_add_tcase(suite, case_ul_insert);
+	suite_add_tcase(suite, case_ul_fetch);
+	suite_add_tcase(suite, case_ul_any);
+	suite_add_tcase(suite, case_ul_filter);
+	suite_add_tcase(suite, case_ul_drop_while);
+	suite_add_tcase(suite, case_ul_take_while);
+	suite_add_tcase(suite, case_ul_map);
+	suite_add_tcase(suite, case_ul_reverse);
+	suite_add_tcase(suite, case_ul_fold);
+	suite_add_tcase(suite, case_ul_pool);
+
+	return suite;
+}
+
+int main(void)
+{
+	Suite * suite_ul;
+	SRunner * suite_runner;
+
+	suite_ul = ul_suite();
+
+	suite_runner = srunner_create(suite_ul);
+	srunner_run_all(suite_runner, CK_NORMAL);
+	srunner_free(suite_runner);
+
+	return 0;
+}